@@ -67,19 +67,56 @@ static juce::File absoluteFileFromPath(const juce::String& path)
 }
 
 
+/**
+ * @brief  Locates an asset file in the asset folder or the file system,
+ *         ignoring binary resources.
+ *
+ * @param assetName          The name of a file in the asset folder.
+ *
+ * @param lookOutsideAssets  Whether assetName should be treated as a path if
+ *                           it isn't found in the asset folder.
+ *
+ * @return                   The requested file, or a file that doesn't exist
+ *                           if nothing was found.
+ */
+static juce::File findLocalAssetFile
+(const juce::String& assetName, bool lookOutsideAssets)
+{
+    juce::File assetFile
+            = absoluteFileFromPath(juce::String(assetFolder) + assetName);
+    if (!assetFile.existsAsFile() && lookOutsideAssets)
+    {
+        assetFile = absoluteFileFromPath(assetName);
+    }
+    return assetFile;
+}
+
+
+/**
+ * @brief  Checks if an asset name has a particular file type.
+ *
+ * @param assetName  A binary resource name or file path.
+ *
+ * @param type       The file extension, without the leading period.
+ *
+ * @return           Whether the asset's name ends with the file type, as
+ *                   either a file extension or a binary resource suffix.
+ */
+static bool isAssetType(const juce::String& assetName, const juce::String& type)
+{
+    return assetName.endsWithIgnoreCase("." + type)
+            || assetName.endsWithIgnoreCase("_" + type);
+}
+
+
 // Loads an asset file using its asset name.
 juce::File Assets::findAssetFile
 (const juce::String& assetName, bool lookOutsideAssets)
 {
     File assetFile = createBinaryTempFile(assetName);
-    if (! assetFile.exists())
+    if (! assetFile.existsAsFile())
     {
-        juce::File assetFile
-                = absoluteFileFromPath(juce::String(assetFolder) + assetName);
-    }
-    if (!assetFile.existsAsFile() && lookOutsideAssets)
-    {
-        assetFile = absoluteFileFromPath(assetName);
+        assetFile = findLocalAssetFile(assetName, lookOutsideAssets);
     }
     #ifdef JUCE_DEBUG
     if (!assetFile.exists())
@@ -92,12 +129,54 @@ juce::File Assets::findAssetFile
 }
 
 
+// Opens an asset for reading without creating any temporary files.
+std::unique_ptr<juce::InputStream> Assets::createAssetInputStream
+(const juce::String& assetName, bool lookOutsideAssets)
+{
+    int dataSize = -1;
+    const char* resourceData = BinaryData::getNamedResource(
+            assetName.toRawUTF8(), dataSize);
+    if (resourceData != nullptr && dataSize > 0)
+    {
+        return std::unique_ptr<juce::InputStream>(new juce::MemoryInputStream(
+                resourceData, (size_t) dataSize, false));
+    }
+    juce::File assetFile = findLocalAssetFile(assetName, lookOutsideAssets);
+    if (assetFile.existsAsFile())
+    {
+        std::unique_ptr<juce::FileInputStream> fileStream
+                (assetFile.createInputStream());
+        if (fileStream != nullptr && fileStream->openedOk())
+        {
+            return std::unique_ptr<juce::InputStream>(fileStream.release());
+        }
+    }
+    DBG(dbgPrefix << __func__ << ": Failed to open asset \"" << assetName
+            << "\"");
+    return nullptr;
+}
+
+
+// Loads the full contents of a text asset.
+juce::String Assets::loadAssetText
+(const juce::String& assetName, bool lookOutsideAssets)
+{
+    std::unique_ptr<juce::InputStream> assetStream
+            = createAssetInputStream(assetName, lookOutsideAssets);
+    if (assetStream == nullptr)
+    {
+        return juce::String();
+    }
+    return assetStream->readEntireStreamAsString();
+}
+
+
 // Creates an Image object from an asset file.
 juce::Image Assets::loadImageAsset
 (const juce::String& assetName, bool lookOutsideAssets)
 {
     using juce::Image;
-    if (assetName.endsWith(".svg"))
+    if (isAssetType(assetName, "svg"))
     {
         Image image;
         std::unique_ptr<juce::Drawable> svgDrawable
@@ -119,8 +198,13 @@ juce::Image Assets::loadImageAsset
         return image;
 
     }
-    juce::File imageFile = findAssetFile(assetName, lookOutsideAssets);
-    return juce::ImageFileFormat::loadFrom(imageFile);
+    std::unique_ptr<juce::InputStream> imageStream
+            = createAssetInputStream(assetName, lookOutsideAssets);
+    if (imageStream == nullptr)
+    {
+        return Image();
+    }
+    return juce::ImageFileFormat::loadFrom(*imageStream);
 }
 
 
@@ -128,18 +212,24 @@ juce::Image Assets::loadImageAsset
 juce::Drawable * Assets::loadSVGDrawable
 (const juce::String& assetName, bool lookOutsideAssets)
 {
-    juce::File svgFile = findAssetFile(assetName, lookOutsideAssets);
-    if (!svgFile.existsAsFile() || svgFile.getFileExtension() != ".svg")
+    if (!isAssetType(assetName, "svg"))
+    {
+        DBG(dbgPrefix << __func__ << ": Asset \"" << assetName
+                << "\" is not a svg file.");
+        return nullptr;
+    }
+    const juce::String svgText = loadAssetText(assetName, lookOutsideAssets);
+    if (svgText.isEmpty())
     {
-        DBG(dbgPrefix << __func__ << ": File \"" << svgFile.getFileName()
+        DBG(dbgPrefix << __func__ << ": File \"" << assetName
                 << "\" not found.");
         return nullptr;
     }
     std::unique_ptr<juce::XmlElement> svgElement
-            (juce::XmlDocument::parse(svgFile));
+            (juce::XmlDocument::parse(svgText));
     if (svgElement == nullptr)
     {
-        DBG(dbgPrefix << __func__ << ": File \"" << svgFile.getFileName()
+        DBG(dbgPrefix << __func__ << ": File \"" << assetName
                 << "\" is not a valid svg file.");
         return nullptr;
     }
@@ -151,17 +241,20 @@ juce::Drawable * Assets::loadSVGDrawable
 juce::var Assets::loadJSONAsset
 (const juce::String& assetName, bool lookOutsideAssets)
 {
-    juce::File jsonFile = findAssetFile(assetName, lookOutsideAssets);
-    if (!jsonFile.existsAsFile() || jsonFile.getFileExtension() != ".json")
+    if (!isAssetType(assetName, "json"))
     {
-        #ifdef JUCE_DEBUG
-        if (jsonFile.existsAsFile())
-        {
-            DBG(dbgPrefix << __func__ << ": " << assetName
-                    << " exists but is not a valid JSON file.");
-        }
-        #endif
         return juce::var();
     }
-    return juce::JSON::parse(jsonFile);
+    const juce::String jsonText = loadAssetText(assetName, lookOutsideAssets);
+    if (jsonText.isEmpty())
+    {
+        return juce::var();
+    }
+    juce::var jsonData;
+    if (juce::JSON::parse(jsonText, jsonData).failed())
+    {
+        DBG(dbgPrefix << __func__ << ": " << assetName
+                << " exists but is not a valid JSON file.");
+    }
+    return jsonData;
 }
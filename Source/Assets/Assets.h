@@ -41,6 +41,46 @@ namespace Assets
     juce::File findAssetFile(const juce::String& assetName,
             bool lookOutsideAssets = true);
 
+    /**
+     * @brief  Opens an asset for reading without creating any temporary files.
+     *
+     *  Binary resources are read directly from memory without being copied.
+     * Assets that aren't binary resources are read from the asset folder, or
+     * from elsewhere in the file system if lookOutsideAssets is true.
+     *
+     * @param assetName          The name of a binary resource, or of a file in
+     *                           the asset folder.
+     *
+     * @param lookOutsideAssets  If the asset isn't found as a binary resource
+     *                           or in the asset folder, and this value is set
+     *                           to true, the asset name will be treated as a
+     *                           path, and the file will be loaded from
+     *                           elsewhere in the file system.
+     *
+     * @return                   A stream reading the asset's data, or nullptr
+     *                           if nothing was found.
+     */
+    std::unique_ptr<juce::InputStream> createAssetInputStream
+    (const juce::String& assetName, bool lookOutsideAssets = true);
+
+    /**
+     * @brief  Loads the full contents of a text asset.
+     *
+     * @param assetName          The name of a binary resource, or of a file in
+     *                           the asset folder.
+     *
+     * @param lookOutsideAssets  If the asset isn't found as a binary resource
+     *                           or in the asset folder, and this value is set
+     *                           to true, the asset name will be treated as a
+     *                           path, and the file will be loaded from
+     *                           elsewhere in the file system.
+     *
+     * @return                   The asset's text, or the empty string if
+     *                           nothing was found.
+     */
+    juce::String loadAssetText(const juce::String& assetName,
+            bool lookOutsideAssets = true);
+
     /**
      * @brief  Creates an Image object from an asset file.
      *
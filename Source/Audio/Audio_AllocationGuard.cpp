@@ -0,0 +1,274 @@
+#include "Audio_AllocationGuard.h"
+
+#ifdef JUCE_DEBUG
+#include <cstdlib>
+#include <new>
+
+#if JUCE_MAC || JUCE_IOS
+#include <malloc/malloc.h>
+#include <mach/mach.h>
+#endif
+
+// Number of ScopedNoAllocation objects that exist on each thread:
+static thread_local int noAllocationDepth = 0;
+
+// Number of heap operations made inside ScopedNoAllocation scopes on each
+// thread:
+static thread_local int blockedHeapAccesses = 0;
+
+// Whether heap operations inside ScopedNoAllocation scopes are expected on
+// each thread, so they are only counted instead of triggering an assertion:
+static thread_local bool expectingHeapAccess = false;
+
+// Starts blocking heap operations on the current thread.
+Audio::ScopedNoAllocation::ScopedNoAllocation()
+{
+    noAllocationDepth++;
+}
+
+
+// Stops blocking heap operations on the current thread, unless another
+// ScopedNoAllocation object still exists on the thread.
+Audio::ScopedNoAllocation::~ScopedNoAllocation()
+{
+    noAllocationDepth--;
+}
+
+
+// Checks that heap allocation is detected, by creating an audio buffer inside
+// a ScopedNoAllocation scope.
+bool Audio::ScopedNoAllocation::detectsBufferAllocation()
+{
+    const int blockedBefore = blockedHeapAccesses;
+    expectingHeapAccess = true;
+    {
+        const ScopedNoAllocation noAllocation;
+        AudioBuffer<float> buffer(1, 64);
+        // Keep the buffer's data in use, so its allocation can't be removed:
+        const float* volatile bufferData = buffer.getReadPointer(0);
+        ignoreUnused(bufferData);
+    }
+    expectingHeapAccess = false;
+    return blockedHeapAccesses > blockedBefore;
+}
+
+
+/**
+ * @brief  Triggers an assertion if the current thread isn't allowed to allocate
+ *         or free heap memory.
+ */
+static void checkHeapAccess()
+{
+    if (noAllocationDepth > 0)
+    {
+        blockedHeapAccesses++;
+        if (expectingHeapAccess)
+        {
+            return;
+        }
+        // Heap memory was allocated or freed in real-time audio code! Allow
+        // heap access while the assertion runs, as logging it may allocate.
+        const int depth = noAllocationDepth;
+        noAllocationDepth = 0;
+        jassertfalse;
+        noAllocationDepth = depth;
+    }
+}
+
+#if JUCE_LINUX
+// glibc's own allocation functions, which the replacements below call:
+extern "C"
+{
+    void* __libc_malloc(std::size_t size);
+    void* __libc_calloc(std::size_t count, std::size_t size);
+    void* __libc_realloc(void* memory, std::size_t size);
+    void __libc_free(void* memory);
+}
+
+// Replacement C allocation functions. The executable's definitions take the
+// place of glibc's for every library, and operator new and delete also
+// allocate through them:
+
+extern "C" void* malloc(std::size_t size) noexcept
+{
+    checkHeapAccess();
+    return __libc_malloc(size);
+}
+
+extern "C" void* calloc(std::size_t count, std::size_t size) noexcept
+{
+    checkHeapAccess();
+    return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void* memory, std::size_t size) noexcept
+{
+    checkHeapAccess();
+    return __libc_realloc(memory, size);
+}
+
+extern "C" void free(void* memory) noexcept
+{
+    if (memory != nullptr)
+    {
+        checkHeapAccess();
+    }
+    __libc_free(memory);
+}
+
+#elif JUCE_MAC || JUCE_IOS
+// The default malloc zone's functions, before they were replaced:
+static malloc_zone_t defaultZone;
+
+// Replacement malloc zone functions, which also handle operator new and
+// delete:
+
+static void* zoneMalloc(malloc_zone_t* zone, std::size_t size)
+{
+    checkHeapAccess();
+    return defaultZone.malloc(zone, size);
+}
+
+static void* zoneCalloc(malloc_zone_t* zone, std::size_t count,
+        std::size_t size)
+{
+    checkHeapAccess();
+    return defaultZone.calloc(zone, count, size);
+}
+
+static void* zoneRealloc(malloc_zone_t* zone, void* memory, std::size_t size)
+{
+    checkHeapAccess();
+    return defaultZone.realloc(zone, memory, size);
+}
+
+static void zoneFree(malloc_zone_t* zone, void* memory)
+{
+    if (memory != nullptr)
+    {
+        checkHeapAccess();
+    }
+    defaultZone.free(zone, memory);
+}
+
+
+/**
+ * @brief  Replaces the default malloc zone's allocation functions with
+ *         versions that check if heap access is allowed.
+ *
+ * @return  Whether the zone's functions were replaced.
+ */
+static bool hookDefaultZone()
+{
+    malloc_zone_t* zone = malloc_default_zone();
+    defaultZone = *zone;
+    // The zone's function table is normally read-only:
+    if (vm_protect(mach_task_self(), (vm_address_t) zone,
+            sizeof(malloc_zone_t), 0, VM_PROT_READ | VM_PROT_WRITE)
+            != KERN_SUCCESS)
+    {
+        return false;
+    }
+    zone->malloc = zoneMalloc;
+    zone->calloc = zoneCalloc;
+    zone->realloc = zoneRealloc;
+    zone->free = zoneFree;
+    vm_protect(mach_task_self(), (vm_address_t) zone, sizeof(malloc_zone_t),
+            0, VM_PROT_READ);
+    return true;
+}
+
+// Hooks the default zone before anything else runs:
+static const bool defaultZoneHooked = hookDefaultZone();
+
+#else
+/**
+ * @brief  Allocates heap memory after checking that allocation is allowed.
+ *
+ * @param size  The number of bytes to allocate.
+ *
+ * @return      The allocated memory, or nullptr if allocation failed.
+ */
+static void* checkedAllocate(std::size_t size)
+{
+    checkHeapAccess();
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+
+/**
+ * @brief  Frees heap memory after checking that heap access is allowed.
+ *
+ * @param memory  Memory allocated by checkedAllocate, or nullptr.
+ */
+static void checkedFree(void* memory)
+{
+    if (memory != nullptr)
+    {
+        checkHeapAccess();
+        std::free(memory);
+    }
+}
+
+// Replacement global allocation functions, used where the C allocation
+// functions can't be replaced:
+
+void* operator new(std::size_t size)
+{
+    if (void* memory = checkedAllocate(size))
+    {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    if (void* memory = checkedAllocate(size))
+    {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return checkedAllocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return checkedAllocate(size);
+}
+
+void operator delete(void* memory) noexcept
+{
+    checkedFree(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+    checkedFree(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+    checkedFree(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept
+{
+    checkedFree(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{
+    checkedFree(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept
+{
+    checkedFree(memory);
+}
+#endif
+#endif
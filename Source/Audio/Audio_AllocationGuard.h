@@ -0,0 +1,59 @@
+#pragma once
+/**
+ * @file  Audio_AllocationGuard.h
+ *
+ * @brief  Detects heap allocation within real-time audio code in debug builds.
+ */
+
+#include "JuceHeader.h"
+
+namespace Audio { class ScopedNoAllocation; }
+
+/**
+ * @brief  Marks a scope where the current thread must never allocate or free
+ *         heap memory.
+ *
+ *  In debug builds, heap allocation functions are replaced with versions
+ * that trigger an assertion if called while a ScopedNoAllocation object
+ * exists on the calling thread. On Linux, malloc, calloc, realloc and free
+ * are replaced, and on macOS and iOS the default malloc zone's functions are
+ * replaced, so allocations made by JUCE containers such as AudioBuffer and
+ * HeapBlock are caught along with operator new and delete. Other platforms
+ * only replace the global new and delete operators. Create one at the start
+ * of each audio callback to catch any allocation on the real-time thread. In
+ * release builds this class does nothing.
+ */
+class Audio::ScopedNoAllocation
+{
+public:
+#ifdef JUCE_DEBUG
+    /**
+     * @brief  Starts blocking heap operations on the current thread.
+     */
+    ScopedNoAllocation();
+
+    /**
+     * @brief  Stops blocking heap operations on the current thread, unless
+     *         another ScopedNoAllocation object still exists on the thread.
+     */
+    ~ScopedNoAllocation();
+
+    /**
+     * @brief  Checks that heap allocation is detected, by creating an audio
+     *         buffer inside a ScopedNoAllocation scope. The buffer's heap
+     *         operations are counted without triggering an assertion.
+     *
+     * @return  Whether allocating or freeing the buffer was detected.
+     */
+    static bool detectsBufferAllocation();
+#else
+    ScopedNoAllocation() { }
+
+    // Release builds don't check for allocation, so there is nothing to
+    // detect:
+    static bool detectsBufferAllocation() { return true; }
+#endif
+
+private:
+    JUCE_DECLARE_NON_COPYABLE(ScopedNoAllocation)
+};
@@ -0,0 +1,260 @@
+#include "Audio_BatchRenderer.h"
+#include "Audio_OfflineRenderer.h"
+#include "Audio_EventList.h"
+#include "Audio_Limiter.h"
+#include "Audio_Sequencer.h"
+#include "Audio_SampleCache.h"
+#include "MusicFile.h"
+
+// Holds all data needed to render and mix one song.
+struct Audio::BatchRenderer::Song
+{
+    // The song's music box file:
+    File songFile;
+    // The audio file to write:
+    File outputFile;
+    // The playback speed in beats per minute:
+    int bpm;
+    // The length of the song's beats in output samples:
+    int64 beatsLength;
+    // The notes played in each segment, with beats relative to the segment:
+    ReferenceCountedArray<EventList> segmentEvents;
+    // The position in output samples where each segment starts:
+    Array<int64> segmentOffsets;
+    // The rendered audio of each segment:
+    OwnedArray<AudioBuffer<float>> segmentAudio;
+    // The number of segments not yet rendered:
+    std::atomic<int> segmentsLeft { 0 };
+};
+
+
+// Renders one segment of a song.
+class Audio::BatchRenderer::SegmentJob : public ThreadPoolJob
+{
+public:
+    SegmentJob(BatchRenderer& batch, Song& song, const int segment) :
+    ThreadPoolJob("Audio::BatchRenderer::SegmentJob"),
+    batch(batch), song(song), segment(segment) { }
+
+    virtual ~SegmentJob() { }
+
+    // Renders the segment, unless the batch was cancelled.
+    JobStatus runJob() override
+    {
+        if (! batch.cancelled && ! shouldExit())
+        {
+            OfflineRenderer renderer(batch.sampleBank);
+            // Segments overlap, so only the mixed song is limited:
+            renderer.setLimiting(false);
+            renderer.renderToBuffer(song.segmentEvents[segment], song.bpm,
+                    *song.segmentAudio[segment]);
+        }
+        batch.segmentFinished(song);
+        return jobHasFinished;
+    }
+
+private:
+    BatchRenderer& batch;
+    Song& song;
+    const int segment;
+
+    JUCE_DECLARE_NON_COPYABLE(SegmentJob)
+};
+
+
+// Creates a batch renderer with a pool of rendering threads.
+Audio::BatchRenderer::BatchRenderer(const int numThreads) :
+threadPool(jmax(numThreads, 1)) { }
+
+
+// Cancels rendering, and waits for every rendering thread to stop.
+Audio::BatchRenderer::~BatchRenderer()
+{
+    cancel();
+    threadPool.removeAllJobs(true, -1);
+}
+
+
+// Renders every .mb file in a directory, blocking until all songs are
+// finished or rendering is cancelled.
+Result Audio::BatchRenderer::renderDirectory(const File& songDirectory,
+        const File& outputDirectory, const String& outputExtension)
+{
+    jassert(songs.isEmpty());
+    if (! songDirectory.isDirectory())
+    {
+        return Result::fail(songDirectory.getFullPathName()
+                + " is not a directory");
+    }
+    const Result createdOutput = outputDirectory.createDirectory();
+    if (createdOutput.failed())
+    {
+        return createdOutput;
+    }
+    if (sampleBank == nullptr)
+    {
+        SampleCache sampleCache;
+        sampleBank = sampleCache.loadBank(SampleBank::getNoteAssetNames(),
+                OfflineRenderer::defaultSampleRate);
+    }
+    cancelled = false;
+    errors.clear();
+    totalSegments = 0;
+    segmentsFinished = 0;
+
+    // Split every song into segments before starting any jobs, so the song
+    // list never changes while jobs are running:
+    Array<File> songFiles = songDirectory.findChildFiles(File::findFiles,
+            false, "*.mb");
+    songFiles.sort();
+    const double sampleRate = sampleBank->getSampleRate();
+    for (const File& songFile : songFiles)
+    {
+        MusicFile musicFile(songFile.getFullPathName());
+        const int beatCount = musicFile.getBeatCount();
+        if (beatCount == 0)
+        {
+            addError(songFile, "no notes to render");
+            continue;
+        }
+        Song* song = new Song;
+        song->songFile = songFile;
+        song->outputFile = outputDirectory.getChildFile(
+                songFile.getFileNameWithoutExtension() + outputExtension);
+        song->bpm = musicFile.getBPM();
+        const double samplesPerBeat = Sequencer::samplesPerBeat(song->bpm,
+                sampleRate);
+        song->beatsLength = (int64) std::llround(beatCount * samplesPerBeat);
+        const std::map<int, Array<int>>& noteMap = musicFile.getNoteMap();
+        const std::map<int, std::map<int, float>>& gainMap
+                = musicFile.getGainMap();
+        for (int firstBeat = 0; firstBeat < beatCount;
+                firstBeat += segmentBeats)
+        {
+            std::map<int, Array<int>> segmentNotes;
+            std::map<int, std::map<int, float>> segmentGains;
+            int segmentLength = 0;
+            for (auto iter = noteMap.lower_bound(firstBeat);
+                    iter != noteMap.end()
+                    && iter->first < firstBeat + segmentBeats; iter++)
+            {
+                if (! iter->second.isEmpty())
+                {
+                    segmentNotes[iter->first - firstBeat] = iter->second;
+                    segmentLength = iter->first - firstBeat + 1;
+                    auto gainIter = gainMap.find(iter->first);
+                    if (gainIter != gainMap.end())
+                    {
+                        segmentGains[iter->first - firstBeat]
+                                = gainIter->second;
+                    }
+                }
+            }
+            // Segments without notes add nothing to the mix:
+            if (segmentNotes.empty())
+            {
+                continue;
+            }
+            song->segmentEvents.add(new EventList(segmentNotes,
+                    segmentLength, segmentGains));
+            song->segmentOffsets.add((int64) std::llround(firstBeat
+                    * samplesPerBeat));
+            song->segmentAudio.add(new AudioBuffer<float>());
+        }
+        song->segmentsLeft = song->segmentEvents.size();
+        totalSegments += song->segmentEvents.size();
+        songs.add(song);
+    }
+    if (songs.isEmpty())
+    {
+        return errors.isEmpty() ? Result::ok()
+                : Result::fail(errors.joinIntoString("\n"));
+    }
+
+    batchFinished.reset();
+    songsLeft = songs.size();
+    for (Song* song : songs)
+    {
+        for (int i = 0; i < song->segmentEvents.size(); i++)
+        {
+            threadPool.addJob(new SegmentJob(*this, *song, i), true);
+        }
+    }
+    batchFinished.wait();
+    songs.clear();
+    if (cancelled)
+    {
+        return Result::fail("Batch render cancelled");
+    }
+    const ScopedLock errorListLock(errorLock);
+    return errors.isEmpty() ? Result::ok()
+            : Result::fail(errors.joinIntoString("\n"));
+}
+
+
+// Gets the progress of the current or most recent batch.
+double Audio::BatchRenderer::getProgress() const
+{
+    if (totalSegments == 0)
+    {
+        return 0;
+    }
+    return (double) segmentsFinished.load() / totalSegments;
+}
+
+
+// Stops rendering as soon as all running segments finish.
+void Audio::BatchRenderer::cancel()
+{
+    cancelled = true;
+}
+
+
+// Records that a song segment finished, mixing and writing the song once all
+// of its segments are done.
+void Audio::BatchRenderer::segmentFinished(Song& song)
+{
+    segmentsFinished++;
+    if (--song.segmentsLeft > 0)
+    {
+        return;
+    }
+    if (! cancelled)
+    {
+        // Each segment's ringing notes overlap the segments after it:
+        int64 songLength = song.beatsLength;
+        for (int i = 0; i < song.segmentAudio.size(); i++)
+        {
+            songLength = jmax(songLength, song.segmentOffsets[i]
+                    + song.segmentAudio[i]->getNumSamples());
+        }
+        AudioBuffer<float> songAudio(1, (int) songLength);
+        songAudio.clear();
+        for (int i = 0; i < song.segmentAudio.size(); i++)
+        {
+            const AudioBuffer<float>& segment = *song.segmentAudio[i];
+            songAudio.addFrom(0, (int) song.segmentOffsets[i], segment, 0, 0,
+                    segment.getNumSamples());
+        }
+        song.segmentAudio.clear();
+        Limiter::limitBuffer(songAudio, sampleBank->getSampleRate());
+        const Result written = OfflineRenderer::writeToFile(songAudio,
+                sampleBank->getSampleRate(), song.outputFile);
+        if (written.failed())
+        {
+            addError(song.songFile, written.getErrorMessage());
+        }
+    }
+    if (--songsLeft == 0)
+    {
+        batchFinished.signal();
+    }
+}
+
+
+// Records the reason a song failed to render.
+void Audio::BatchRenderer::addError(const File& songFile, const String& error)
+{
+    const ScopedLock errorListLock(errorLock);
+    errors.add(songFile.getFileName() + ": " + error);
+}
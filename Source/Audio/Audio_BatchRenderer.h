@@ -0,0 +1,122 @@
+#pragma once
+/**
+ * @file  Audio_BatchRenderer.h
+ *
+ * @brief  Renders every song in a directory to audio files using all
+ *         available processor cores.
+ */
+
+#include "JuceHeader.h"
+#include "Audio_SampleBank.h"
+#include <atomic>
+
+namespace Audio { class BatchRenderer; }
+
+/**
+ * @brief  Renders a directory of music box files to WAV or FLAC files on a
+ *         thread pool.
+ *
+ *  Each song is split into segments of a fixed number of beats, and each
+ * segment is rendered as a separate pool job, so long songs are spread across
+ * every thread instead of holding up a single one. Every segment is rendered
+ * until its last note finishes ringing, and segments are mixed together at
+ * their start positions, so notes that ring past the end of a segment overlap
+ * the following segment exactly as they would in a single render. Segments
+ * are rendered without limiting, and the mixed song is limited instead.
+ *
+ *  All jobs share a single sample bank, which is never modified after it is
+ * created.
+ */
+class Audio::BatchRenderer
+{
+public:
+    // The number of beats rendered in each song segment:
+    static const constexpr int segmentBeats = 256;
+
+    /**
+     * @brief  Creates the renderer and its thread pool.
+     *
+     * @param numThreads  The number of threads used for rendering.
+     */
+    BatchRenderer(const int numThreads = juce::SystemStats::getNumCpus());
+
+    virtual ~BatchRenderer();
+
+    /**
+     * @brief  Renders every .mb file in a directory, blocking until all songs
+     *         are finished or rendering is cancelled.
+     *
+     * @param songDirectory    The directory holding all music box files.
+     *
+     * @param outputDirectory  The directory where audio files are written.
+     *                         Each audio file is named after its song file.
+     *
+     * @param outputExtension  The output file extension, either ".wav" or
+     *                         ".flac".
+     *
+     * @return                 Whether every song was rendered, or the reasons
+     *                         any songs failed.
+     */
+    juce::Result renderDirectory(const juce::File& songDirectory,
+            const juce::File& outputDirectory,
+            const juce::String& outputExtension = ".wav");
+
+    /**
+     * @brief  Gets the progress of the current or most recent batch.
+     *
+     * @return  The fraction of all song segments rendered, between zero and
+     *          one.
+     */
+    double getProgress() const;
+
+    /**
+     * @brief  Stops rendering as soon as all running segments finish. Songs
+     *         that weren't finished are not written.
+     */
+    void cancel();
+
+private:
+    struct Song;
+    class SegmentJob;
+
+    /**
+     * @brief  Records that a song segment finished, mixing and writing the
+     *         song once all of its segments are done. This is called on the
+     *         pool thread that rendered the segment.
+     *
+     * @param song  The song that owns the finished segment.
+     */
+    void segmentFinished(Song& song);
+
+    /**
+     * @brief  Records the reason a song failed to render.
+     *
+     * @param songFile  The song that failed.
+     *
+     * @param error     A description of the failure.
+     */
+    void addError(const juce::File& songFile, const juce::String& error);
+
+    // Runs all segment jobs:
+    juce::ThreadPool threadPool;
+    // Holds all note samples at the output sample rate:
+    SampleBank::Ptr sampleBank;
+    // All songs in the current batch:
+    juce::OwnedArray<Song> songs;
+    // Signalled when the last song in the batch is finished:
+    juce::WaitableEvent batchFinished;
+    // The number of songs that still have unfinished segments:
+    std::atomic<int> songsLeft { 0 };
+    // The number of segments in the current batch:
+    int totalSegments = 0;
+    // The number of segments finished in the current batch:
+    std::atomic<int> segmentsFinished { 0 };
+    // Set when the current batch should stop:
+    std::atomic<bool> cancelled { false };
+    // Descriptions of all songs that failed to render:
+    juce::StringArray errors;
+    // Protects the error list:
+    juce::CriticalSection errorLock;
+
+    JUCE_DECLARE_NON_COPYABLE(BatchRenderer)
+};
@@ -0,0 +1,517 @@
+#include "Audio_Benchmark.h"
+#include "Audio_Convolver.h"
+#include "Audio_MixKernel.h"
+#include "Audio_ModalSynth.h"
+#include "Audio_Resampler.h"
+#include "Audio_SampleBank.h"
+#include "Audio_VoicePool.h"
+#include <iostream>
+
+// The number of frames processed in each benchmarked block:
+static const constexpr int blockSize = 512;
+
+// The minimum time spent running each measurement:
+static const constexpr double minTestSeconds = 0.25;
+
+// The sample rate used when benchmarking sample banks:
+static const constexpr double benchmarkSampleRate = 48000;
+
+/**
+ * @brief  Measures the average time taken by a benchmarked function.
+ *
+ * @param function  The function to measure, which processes a single block.
+ *
+ * @return          The average time per call in nanoseconds.
+ */
+static double timeFunction(const std::function<void()>& function)
+{
+    // Run once first, so the measurement doesn't include cache misses:
+    function();
+    int numCalls = 0;
+    const int64 startTicks = Time::getHighResolutionTicks();
+    int64 elapsedTicks = 0;
+    do
+    {
+        for (int i = 0; i < 64; i++)
+        {
+            function();
+        }
+        numCalls += 64;
+        elapsedTicks = Time::getHighResolutionTicks() - startTicks;
+    }
+    while (Time::highResolutionTicksToSeconds(elapsedTicks) < minTestSeconds);
+    return Time::highResolutionTicksToSeconds(elapsedTicks) * 1.0e9
+            / numCalls;
+}
+
+
+/**
+ * @brief  Measures how closely resampled audio matches a pure sine wave.
+ *
+ *  The sine with the expected frequency that best fits the audio is removed,
+ * and everything left over is counted as noise, so results don't depend on
+ * any delay the resampler adds.
+ *
+ * @param audio      The resampled audio.
+ *
+ * @param length     The number of frames to measure.
+ *
+ * @param frequency  The sine's frequency, in cycles per frame.
+ *
+ * @return           The signal to noise ratio in decibels.
+ */
+static double measureSineQuality(const float* audio, const int length,
+        const double frequency)
+{
+    double sineSum = 0.0;
+    double cosineSum = 0.0;
+    for (int i = 0; i < length; i++)
+    {
+        const double angle = MathConstants<double>::twoPi * frequency * i;
+        sineSum += audio[i] * std::sin(angle);
+        cosineSum += audio[i] * std::cos(angle);
+    }
+    const double sineAmplitude = sineSum * 2.0 / length;
+    const double cosineAmplitude = cosineSum * 2.0 / length;
+    double signal = 0.0;
+    double noise = 0.0;
+    for (int i = 0; i < length; i++)
+    {
+        const double angle = MathConstants<double>::twoPi * frequency * i;
+        const double fit = sineAmplitude * std::sin(angle)
+                + cosineAmplitude * std::cos(angle);
+        signal += fit * fit;
+        noise += (audio[i] - fit) * (audio[i] - fit);
+    }
+    return 10.0 * std::log10(signal / jmax(noise, 1.0e-20));
+}
+
+
+/**
+ * @brief  Prints one benchmark measurement.
+ *
+ * @param name         The name of the measured function.
+ *
+ * @param nanoseconds  The average time per call.
+ *
+ * @param baseline     The time per call of the function used for comparison.
+ */
+static void printResult(const String& name, const double nanoseconds,
+        const double baseline)
+{
+    std::cout << "    " << name.paddedRight(' ', 24)
+            << String(nanoseconds, 0).paddedLeft(' ', 10) << " ns/block  "
+            << String(baseline / nanoseconds, 2).paddedLeft(' ', 6)
+            << "x\n";
+}
+
+
+// Runs every benchmark.
+void Audio::Benchmark::runAll()
+{
+    runMixKernel();
+    runSampleStorage();
+    runGeneratedNotes();
+    runModalSynth();
+    runConvolver();
+    runResampler();
+}
+
+
+// Compares the vectorised MixKernel against its scalar version and against
+// mixing each channel separately, at several voice counts.
+void Audio::Benchmark::runMixKernel()
+{
+    std::cout << "MixKernel: " << blockSize << " frame blocks, "
+            << (MixKernel::isVectorised() ? "vectorised" : "scalar only")
+            << "\n";
+    const int voiceCounts[] = { 1, 8, 32, 128 };
+    const int maxVoices = 128;
+    Random random(1);
+    AudioBuffer<float> voiceData(maxVoices, blockSize);
+    HeapBlock<MixKernel::Source> sources(maxVoices);
+    for (int v = 0; v < maxVoices; v++)
+    {
+        float* data = voiceData.getWritePointer(v);
+        for (int i = 0; i < blockSize; i++)
+        {
+            data[i] = random.nextFloat() * 2.0f - 1.0f;
+        }
+        sources[v].data = data;
+        sources[v].numFrames = blockSize;
+        sources[v].leftGainStep = 0.0f;
+        sources[v].rightGainStep = 0.0f;
+        MixKernel::getPanGains(random.nextFloat(),
+                random.nextFloat() * 2.0f - 1.0f, sources[v].leftGain,
+                sources[v].rightGain);
+    }
+    AudioBuffer<float> mix(2, blockSize);
+    mix.clear();
+    float* left = mix.getWritePointer(0);
+    float* right = mix.getWritePointer(1);
+    for (const int numVoices : voiceCounts)
+    {
+        std::cout << "  " << numVoices << " voices:\n";
+        const double perChannel = timeFunction([&]()
+        {
+            for (int v = 0; v < numVoices; v++)
+            {
+                FloatVectorOperations::addWithMultiply(left, sources[v].data,
+                        sources[v].leftGain, blockSize);
+                FloatVectorOperations::addWithMultiply(right, sources[v].data,
+                        sources[v].rightGain, blockSize);
+            }
+        });
+        const double scalar = timeFunction([&]()
+        {
+            MixKernel::mixStereoScalar(sources, numVoices, left, right,
+                    blockSize);
+        });
+        const double vectorised = timeFunction([&]()
+        {
+            MixKernel::mixStereo(sources, numVoices, left, right, blockSize);
+        });
+        printResult("scalar kernel", scalar, scalar);
+        printResult("per-channel addFrom", perChannel, scalar);
+        printResult("vectorised kernel", vectorised, scalar);
+    }
+    // Keep the mix from being optimised away:
+    std::cout << "  (checksum " << mix.getMagnitude(0, blockSize) << ")\n";
+}
+
+
+// Compares the memory use and rendering time of fully decoded and streamed
+// 16-bit sample banks, using the music box note samples, and reports the
+// memory saved by trimming them.
+void Audio::Benchmark::runSampleStorage()
+{
+    std::cout << "SampleBank storage: " << blockSize << " frame blocks, "
+            << VoicePool::defaultPolyphony << " voices at "
+            << benchmarkSampleRate << "Hz\n";
+    const SampleBank::Storage storageModes[] =
+    {
+        SampleBank::Storage::decoded,
+        SampleBank::Storage::pcm16
+    };
+    double decodedTime = 0;
+    AudioBuffer<float> mix(2, blockSize);
+    for (const SampleBank::Storage storage : storageModes)
+    {
+        SampleBank::Processing processing;
+        processing.storage = storage;
+        SampleBank::Ptr sampleBank = new SampleBank(
+                SampleBank::getNoteAssetNames(), benchmarkSampleRate,
+                processing);
+        VoicePool voicePool;
+        voicePool.setSampleRate(benchmarkSampleRate);
+        voicePool.setCullThreshold(0.0f);
+        if (sampleBank->isStreamed())
+        {
+            voicePool.allocateStreams();
+        }
+        int nextNote = 0;
+        // Each call keeps every voice busy, and includes the time spent
+        // filling streams:
+        const double renderTime = timeFunction([&]()
+        {
+            while (voicePool.getActiveVoiceCount()
+                    < VoicePool::defaultPolyphony)
+            {
+                voicePool.startVoice(nextNote, *sampleBank);
+                nextNote = (nextNote + 1) % sampleBank->getNumNotes();
+            }
+            if (sampleBank->isStreamed())
+            {
+                voicePool.fillStreams();
+            }
+            mix.clear();
+            voicePool.renderNextBlock(mix.getWritePointer(0),
+                    mix.getWritePointer(1), blockSize);
+        });
+        if (storage == SampleBank::Storage::decoded)
+        {
+            decodedTime = renderTime;
+        }
+        const String name = sampleBank->isStreamed() ? "16-bit streamed"
+                : "decoded float";
+        printResult(name, renderTime, decodedTime);
+        std::cout << "      "
+                << (int) (sampleBank->getMemorySize() / 1024)
+                << " KB samples + "
+                << (int) (voicePool.getStreamMemorySize() / 1024)
+                << " KB streams, " << voicePool.getStreamUnderrunCount()
+                << " underruns\n";
+        if (storage == SampleBank::Storage::decoded)
+        {
+            // Both sizes are decoded floats, so this shows what trimming
+            // alone saves:
+            const size_t untrimmedSize = sampleBank->getUntrimmedMemorySize();
+            std::cout << "      trimmed from "
+                    << (int) (untrimmedSize / 1024) << " KB, saving "
+                    << (int) ((untrimmedSize - jmin(untrimmedSize,
+                        sampleBank->getMemorySize())) / 1024) << " KB\n";
+        }
+    }
+}
+
+
+// Reports the memory used by notes generated from the music box samples for a
+// chromatic pitch layout.
+void Audio::Benchmark::runGeneratedNotes()
+{
+    // Every music box sample keeps its own pitch, and the semitones between
+    // them are generated:
+    SampleBank::Processing processing;
+    for (const double& frequency : ModalSynth::getMusicBoxPitches())
+    {
+        processing.samplePitches.add(69.0 + 12.0 * std::log2(frequency
+                / 440.0));
+    }
+    const int lowestPitch = roundToInt(processing.samplePitches.getFirst());
+    const int highestPitch = roundToInt(processing.samplePitches.getLast());
+    for (int pitch = lowestPitch; pitch <= highestPitch; pitch++)
+    {
+        processing.notePitches.add(pitch);
+    }
+    SampleBank::Ptr sampleBank = new SampleBank(
+            SampleBank::getNoteAssetNames(), benchmarkSampleRate,
+            processing);
+    std::cout << "Generated notes: " << sampleBank->getNumNotes()
+            << " note chromatic layout from "
+            << processing.samplePitches.size() << " samples at "
+            << benchmarkSampleRate << "Hz\n";
+    int numGenerated = 0;
+    size_t generatedSize = 0;
+    for (int note = 0; note < sampleBank->getNumNotes(); note++)
+    {
+        if (sampleBank->isGeneratedNote(note))
+        {
+            numGenerated++;
+            generatedSize += sampleBank->getNoteMemorySize(note);
+            std::cout << "    note " << note << " from sample "
+                    << sampleBank->getSourceSample(note) << ": "
+                    << (int) (sampleBank->getNoteMemorySize(note) / 1024)
+                    << " KB\n";
+        }
+    }
+    std::cout << "  " << numGenerated << " generated notes use "
+            << (int) (generatedSize / 1024) << " KB of "
+            << (int) (sampleBank->getMemorySize() / 1024) << " KB\n";
+}
+
+
+// Compares the rendering time per voice and memory use of the ModalSynth
+// against playing decoded note samples, at several voice counts.
+void Audio::Benchmark::runModalSynth()
+{
+    std::cout << "ModalSynth: " << blockSize << " frame blocks at "
+            << benchmarkSampleRate << "Hz\n";
+    const int voiceCounts[] = { 1, 8, 32, VoicePool::maxPolyphony };
+    SampleBank::Ptr sampleBank = new SampleBank(
+            SampleBank::getNoteAssetNames(), benchmarkSampleRate);
+    // Both engines are benchmarked without culling, so every voice is
+    // rendered in every block:
+    VoicePool voicePool;
+    voicePool.setSampleRate(benchmarkSampleRate);
+    voicePool.setPolyphony(VoicePool::maxPolyphony);
+    voicePool.setCullThreshold(0.0f);
+    ModalSynth modalSynth;
+    modalSynth.setSampleRate(benchmarkSampleRate);
+    modalSynth.setPolyphony(VoicePool::maxPolyphony);
+    modalSynth.setCullThreshold(0.0f);
+    AudioBuffer<float> mix(2, blockSize);
+    for (const int numVoices : voiceCounts)
+    {
+        std::cout << "  " << numVoices << " voices:\n";
+        voicePool.stopAllVoices();
+        modalSynth.stopAllNotes();
+        int nextNote = 0;
+        const double sampleTime = timeFunction([&]()
+        {
+            while (voicePool.getActiveVoiceCount() < numVoices)
+            {
+                voicePool.startVoice(nextNote, *sampleBank);
+                nextNote = (nextNote + 1) % sampleBank->getNumNotes();
+            }
+            mix.clear();
+            voicePool.renderNextBlock(mix.getWritePointer(0),
+                    mix.getWritePointer(1), blockSize);
+        });
+        const double synthTime = timeFunction([&]()
+        {
+            while (modalSynth.getActiveVoiceCount() < numVoices)
+            {
+                modalSynth.startNote(nextNote);
+                nextNote = (nextNote + 1) % modalSynth.getNumNotes();
+            }
+            mix.clear();
+            modalSynth.renderNextBlock(mix.getWritePointer(0),
+                    mix.getWritePointer(1), blockSize);
+        });
+        printResult("decoded samples", sampleTime, sampleTime);
+        printResult("modal synth", synthTime, sampleTime);
+        std::cout << "      " << String(sampleTime / numVoices, 0)
+                << " vs " << String(synthTime / numVoices, 0)
+                << " ns/voice\n";
+    }
+    std::cout << "  memory: "
+            << (int) (sampleBank->getMemorySize() / 1024)
+            << " KB samples vs "
+            << (int) (modalSynth.getMemorySize() / 1024)
+            << " KB synth\n";
+}
+
+
+// Measures the cost of each block processed by the Convolver at several block
+// sizes and impulse response lengths.
+void Audio::Benchmark::runConvolver()
+{
+    std::cout << "Convolver: stereo at " << benchmarkSampleRate << "Hz\n";
+    const int blockSizes[] = { 64, 128, 256, 512 };
+    const double impulseSeconds[] = { 0.025, 0.05, 0.1, 0.2, 0.5 };
+    Random random(1);
+    Array<float> impulse;
+    for (int i = 0; i < roundToInt(Convolver::maxImpulseSeconds
+            * benchmarkSampleRate); i++)
+    {
+        impulse.add((random.nextFloat() * 2.0f - 1.0f) * 0.01f);
+    }
+    AudioBuffer<float> audio(2, Convolver::maxPartitionSize);
+    for (const int blockSize : blockSizes)
+    {
+        std::cout << "  " << blockSize << " frame blocks:\n";
+        double shortestTime = 0;
+        for (const double seconds : impulseSeconds)
+        {
+            Array<float> partImpulse;
+            partImpulse.addArray(impulse, 0,
+                    roundToInt(seconds * benchmarkSampleRate));
+            Convolver convolver;
+            convolver.prepare(partImpulse, benchmarkSampleRate, blockSize);
+            for (int c = 0; c < 2; c++)
+            {
+                float* data = audio.getWritePointer(c);
+                for (int i = 0; i < blockSize; i++)
+                {
+                    data[i] = random.nextFloat() * 2.0f - 1.0f;
+                }
+            }
+            const double blockTime = timeFunction([&]()
+            {
+                convolver.process(audio.getWritePointer(0),
+                        audio.getWritePointer(1), blockSize);
+            });
+            if (shortestTime == 0)
+            {
+                shortestTime = blockTime;
+            }
+            printResult(String(roundToInt(seconds * 1000)) + "ms impulse ("
+                    + String(convolver.getNumPartitions()) + " parts)",
+                    blockTime, shortestTime);
+            const double budget = blockSize / benchmarkSampleRate * 1.0e9;
+            std::cout << "      " << String(blockTime * 100.0 / budget, 2)
+                    << "% of the block's duration\n";
+        }
+    }
+}
+
+
+// Compares the accuracy and speed of the Resampler against the
+// LagrangeInterpolator it replaced, at common sample rate conversions and
+// pitch shifts.
+void Audio::Benchmark::runResampler()
+{
+    struct Conversion
+    {
+        const char* name;
+        double inputRate;
+        double outputRate;
+    };
+    // Pitch shifts play input recorded at one rate back at another:
+    const Conversion conversions[] =
+    {
+        { "44.1kHz to 48kHz", 44100, 48000 },
+        { "48kHz to 44.1kHz", 48000, 44100 },
+        { "96kHz to 48kHz", 96000, 48000 },
+        { "up one semitone", 48000 * std::pow(2.0, 1.0 / 12.0), 48000 },
+        { "down one octave", 24000, 48000 }
+    };
+    const double testFrequencies[] = { 1000, 5000, 10000, 15000 };
+    const int inputLength = roundToInt(benchmarkSampleRate);
+    // Frames at each end, where the input starts and stops abruptly, aren't
+    // measured:
+    const int edgeFrames = Resampler::numTaps * 4;
+    HeapBlock<float> input((size_t) inputLength);
+    // The output buffer must hold the longest conversion, down one octave:
+    HeapBlock<float> output((size_t) inputLength * 2 + 1);
+    std::cout << "Resampler: " << Resampler::numTaps << " taps, "
+            << Resampler::numPhases << " phases, signal to noise ratio of "
+            << "converted sines, Lagrange vs windowed sinc\n";
+    for (const Conversion& conversion : conversions)
+    {
+        std::cout << "  " << conversion.name << ":\n";
+        const double speedRatio = conversion.inputRate
+                / conversion.outputRate;
+        const Resampler resampler(speedRatio);
+        const int outputLength = resampler.getOutputLength(inputLength);
+        for (const double frequency : testFrequencies)
+        {
+            // Frequencies near either Nyquist frequency can't be recorded or
+            // are removed, so there's nothing to measure:
+            const double outputFrequency = frequency / conversion.outputRate;
+            if (outputFrequency >= 0.45
+                    || frequency / conversion.inputRate >= 0.45)
+            {
+                continue;
+            }
+            for (int i = 0; i < inputLength; i++)
+            {
+                input[i] = (float) std::sin(MathConstants<double>::twoPi
+                        * frequency * i / conversion.inputRate);
+            }
+            LagrangeInterpolator interpolator;
+            interpolator.process(speedRatio, input, output,
+                    outputLength - Resampler::numTaps);
+            const double lagrangeQuality = measureSineQuality(
+                    output + edgeFrames, outputLength - edgeFrames * 2,
+                    outputFrequency);
+            resampler.process(input, inputLength, output, outputLength);
+            const double sincQuality = measureSineQuality(
+                    output + edgeFrames, outputLength - edgeFrames * 2,
+                    outputFrequency);
+            std::cout << "    " << (String(roundToInt(frequency)) + "Hz")
+                    .paddedRight(' ', 10)
+                    << String(lagrangeQuality, 1).paddedLeft(' ', 8)
+                    << " dB vs" << String(sincQuality, 1).paddedLeft(' ', 7)
+                    << " dB\n";
+        }
+    }
+
+    std::cout << "  speed, converting " << inputLength << " frames:\n";
+    Random random(1);
+    for (int i = 0; i < inputLength; i++)
+    {
+        input[i] = random.nextFloat() * 2.0f - 1.0f;
+    }
+    for (const Conversion& conversion : conversions)
+    {
+        const double speedRatio = conversion.inputRate
+                / conversion.outputRate;
+        const Resampler resampler(speedRatio);
+        const int outputLength = resampler.getOutputLength(inputLength);
+        const double lagrangeTime = timeFunction([&]()
+        {
+            LagrangeInterpolator interpolator;
+            interpolator.process(speedRatio, input, output,
+                    outputLength - Resampler::numTaps);
+        });
+        const double sincTime = timeFunction([&]()
+        {
+            resampler.process(input, inputLength, output, outputLength);
+        });
+        std::cout << "    " << String(conversion.name).paddedRight(' ', 20)
+                << String(lagrangeTime / outputLength, 2).paddedLeft(' ', 7)
+                << " vs" << String(sincTime / outputLength, 2)
+                .paddedLeft(' ', 7) << " ns/frame\n";
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+/**
+ * @file  Audio_Benchmark.h
+ *
+ * @brief  Measures the speed of audio processing code.
+ */
+
+#include "JuceHeader.h"
+
+namespace Audio
+{
+    /**
+     * @brief  Micro-benchmarks for the audio engine, run from the command
+     *         line with the --benchmark option.
+     *
+     *  Each benchmark prints its results to standard output. Benchmarks use
+     * generated data, so they don't depend on the audio device.
+     */
+    namespace Benchmark
+    {
+        /**
+         * @brief  Runs every benchmark.
+         */
+        void runAll();
+
+        /**
+         * @brief  Compares the vectorised MixKernel against its scalar
+         *         version and against mixing each channel separately, at
+         *         several voice counts.
+         */
+        void runMixKernel();
+
+        /**
+         * @brief  Compares the memory use and rendering time of fully decoded
+         *         and streamed 16-bit sample banks, using the music box note
+         *         samples, and reports the memory saved by trimming them.
+         */
+        void runSampleStorage();
+
+        /**
+         * @brief  Reports the memory used by notes generated from the music
+         *         box samples for a chromatic pitch layout.
+         */
+        void runGeneratedNotes();
+
+        /**
+         * @brief  Compares the rendering time per voice and memory use of the
+         *         ModalSynth against playing decoded note samples, at several
+         *         voice counts.
+         */
+        void runModalSynth();
+
+        /**
+         * @brief  Measures the cost of each block processed by the Convolver
+         *         at several block sizes and impulse response lengths.
+         */
+        void runConvolver();
+
+        /**
+         * @brief  Compares the accuracy and speed of the Resampler against
+         *         the LagrangeInterpolator it replaced, at common sample rate
+         *         conversions and pitch shifts.
+         */
+        void runResampler();
+    }
+}
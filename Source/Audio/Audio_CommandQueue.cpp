@@ -0,0 +1,36 @@
+#include "Audio_CommandQueue.h"
+
+// Allocates space for all queued commands.
+Audio::CommandQueue::CommandQueue(const int capacity) :
+    fifo(capacity),
+    commands((size_t) capacity) { }
+
+
+// Adds a command to the end of the queue.
+bool Audio::CommandQueue::push(const Command& command)
+{
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite(1, start1, size1, start2, size2);
+    if (size1 == 0)
+    {
+        return false;
+    }
+    commands[start1] = command;
+    fifo.finishedWrite(1);
+    return true;
+}
+
+
+// Removes the command at the front of the queue.
+bool Audio::CommandQueue::pop(Command& command)
+{
+    int start1, size1, start2, size2;
+    fifo.prepareToRead(1, start1, size1, start2, size2);
+    if (size1 == 0)
+    {
+        return false;
+    }
+    command = commands[start1];
+    fifo.finishedRead(1);
+    return true;
+}
@@ -0,0 +1,137 @@
+#pragma once
+/**
+ * @file  Audio_CommandQueue.h
+ *
+ * @brief  Passes playback commands from the message thread to the audio
+ *         thread without locking.
+ */
+
+#include "JuceHeader.h"
+#include "Audio_EventList.h"
+#include "Audio_SampleBank.h"
+
+namespace Audio { class CommandQueue; }
+
+/**
+ * @brief  A fixed-size, wait-free single-producer, single-consumer queue of
+ *         playback commands.
+ *
+ *  Exactly one thread may push commands, and exactly one thread may pop them.
+ * The NotePlayer pushes commands from the message thread, and the audio thread
+ * pops all pending commands at the start of each audio block. Neither
+ * operation locks, allocates, or waits on the other thread.
+ */
+class Audio::CommandQueue
+{
+public:
+    /**
+     * @brief  A single playback command.
+     */
+    struct Command
+    {
+        enum class Type
+        {
+            // Start playing a note:
+            playNote,
+            // Immediately stop all playing notes:
+            stopAllNotes,
+            // Start playing an event list:
+            startSequence,
+            // Stop playing the current event list:
+            stopSequence,
+            // Replace the current event list with an edited version:
+            updateSequence,
+            // Change the maximum number of notes that may play at once:
+            setPolyphony,
+            // Change how voices are chosen when the polyphony limit is
+            // reached:
+            setStealingPolicy,
+            // Change the level below which voices are culled:
+            setCullThreshold,
+            // Replace the sample bank used to play notes:
+            setSampleBank,
+            // Match the notes that may be played to a newly loaded bank:
+            setNoteLayout,
+            // Change the engine used to play new notes:
+            setEngine,
+            // Turn the body resonance stage on or off:
+            setBodyResonance,
+            // Change the highest level the output limiter allows:
+            setLimiterCeiling,
+            // Turn soft clipping in the output limiter on or off:
+            setSoftClip,
+            // Change the stereo position of a note:
+            setNotePan,
+            // Change the gain of a note:
+            setNoteGain,
+            // Change how widely notes are spread across the stereo field:
+            setStereoWidth
+        };
+        Type type;
+        // The note index used by playNote, setNotePan and setNoteGain
+        // commands:
+        int note;
+        // The tempo used by startSequence commands:
+        int bpm;
+        // The new voice limit used by setPolyphony commands, the new
+        // VoicePool::StealingPolicy used by setStealingPolicy commands, the
+        // new NotePlayer::Engine used by setEngine commands, or whether
+        // setBodyResonance and setSoftClip commands turn their stage on:
+        int intValue;
+        // The linear gain threshold used by setCullThreshold commands, the
+        // ceiling in decibels used by setLimiterCeiling commands, the pan
+        // used by setNotePan commands, the linear gain used by setNoteGain
+        // commands, or the width used by setStereoWidth commands:
+        float floatValue;
+        // Identifies the sequence started or stopped by sequence commands:
+        uint32 sequenceId;
+        // The event list played by startSequence and updateSequence
+        // commands. The sender adds a reference to the list that the
+        // receiver must remove.
+        EventList* eventList;
+        // The bank used by setSampleBank and setNoteLayout commands. The
+        // sender adds a reference to the bank that the receiver must remove.
+        SampleBank* sampleBank;
+    };
+
+    /**
+     * @brief  Allocates space for all queued commands.
+     *
+     * @param capacity  The maximum number of commands that can wait in the
+     *                  queue at once.
+     */
+    CommandQueue(const int capacity);
+
+    virtual ~CommandQueue() { }
+
+    /**
+     * @brief  Adds a command to the end of the queue. This should only be
+     *         called by the producer thread.
+     *
+     * @param command  The command to add.
+     *
+     * @return         True if the command was added, false if the queue was
+     *                 full.
+     */
+    bool push(const Command& command);
+
+    /**
+     * @brief  Removes the command at the front of the queue. This should only
+     *         be called by the consumer thread.
+     *
+     * @param command  If the queue isn't empty, the removed command will be
+     *                 copied here.
+     *
+     * @return         True if a command was removed, false if the queue was
+     *                 empty.
+     */
+    bool pop(Command& command);
+
+private:
+    // Tracks read and write positions within the command buffer:
+    AbstractFifo fifo;
+    // Holds all queued commands:
+    HeapBlock<Command> commands;
+
+    JUCE_DECLARE_NON_COPYABLE(CommandQueue)
+};
@@ -0,0 +1,320 @@
+#include "Audio_Convolver.h"
+#include "Audio_SIMD.h"
+
+// The length of the generated body response, in seconds:
+static const constexpr double bodySeconds = 0.15;
+
+// The energy of the generated body resonance, relative to the direct sound:
+static const constexpr double bodyEnergy = 0.5;
+
+// The share of the body resonance's amplitude that comes from diffuse table
+// reflections rather than from the box's resonant modes:
+static const constexpr float bodyNoiseLevel = 0.3f;
+
+// The decay time of the diffuse table reflections to -60dB, in seconds:
+static const constexpr double bodyNoiseDecaySeconds = 0.04;
+
+// The cutoff frequency of the diffuse table reflections, in Hz:
+static const constexpr double bodyNoiseCutoff = 3000.0;
+
+// Seeds the generated table reflections, so every body response is the same:
+static const constexpr int64 bodyNoiseSeed = 0x6d62;
+
+/**
+ * @brief  A single resonance of a wooden music box.
+ */
+struct BodyMode
+{
+    // The resonant frequency in Hz:
+    double frequency;
+    // The amplitude relative to the other modes:
+    double amplitude;
+    // The decay time to -60dB, in seconds:
+    double decaySeconds;
+};
+
+// The lowest resonances of the box's panels and the air inside it:
+static const BodyMode bodyModes[] =
+{
+    { 180.0, 1.0, 0.09 },
+    { 310.0, 0.8, 0.07 },
+    { 520.0, 0.7, 0.06 },
+    { 760.0, 0.5, 0.05 },
+    { 1150.0, 0.35, 0.04 },
+    { 1720.0, 0.25, 0.03 },
+    { 2600.0, 0.15, 0.02 }
+};
+
+/**
+ * @brief  Gets the gain that decays a signal by 60dB over a number of seconds.
+ *
+ * @param seconds     The time taken to decay by 60dB.
+ *
+ * @param timeOffset  The time since the decay started, in seconds.
+ *
+ * @return            The decay gain at the time offset.
+ */
+static double getDecayGain(const double seconds, const double timeOffset)
+{
+    return std::exp(std::log(0.001) * timeOffset / seconds);
+}
+
+
+// Creates the impulse response of a small wooden music box resting on a
+// table.
+Array<float> Audio::Convolver::createBodyResponse(const double sampleRate)
+{
+    jassert(sampleRate > 0);
+    const int length = roundToInt(bodySeconds * sampleRate);
+    Array<float> response;
+    response.insertMultiple(0, 0.0f, length);
+    for (const BodyMode& mode : bodyModes)
+    {
+        if (mode.frequency >= sampleRate * 0.45)
+        {
+            continue;
+        }
+        const double angle = MathConstants<double>::twoPi * mode.frequency
+                / sampleRate;
+        for (int i = 0; i < length; i++)
+        {
+            response.getReference(i) += (float) (mode.amplitude
+                    * getDecayGain(mode.decaySeconds, i / sampleRate)
+                    * std::sin(angle * i));
+        }
+    }
+    Random random(bodyNoiseSeed);
+    const float noiseCoefficient = (float) (1.0 - std::exp(
+            -MathConstants<double>::twoPi * bodyNoiseCutoff / sampleRate));
+    float noise = 0.0f;
+    for (int i = 0; i < length; i++)
+    {
+        noise += (random.nextFloat() * 2.0f - 1.0f - noise)
+                * noiseCoefficient;
+        response.getReference(i) += bodyNoiseLevel * noise
+                * (float) getDecayGain(bodyNoiseDecaySeconds, i / sampleRate);
+    }
+    double resonanceEnergy = 0.0;
+    for (const float& sample : response)
+    {
+        resonanceEnergy += sample * sample;
+    }
+    // Add the direct sound, then scale the whole response to unit energy so
+    // the body resonance barely changes the overall level:
+    const float resonanceScale = (float) std::sqrt(bodyEnergy
+            / jmax(resonanceEnergy, 1.0e-9));
+    const float totalScale = (float) (1.0 / std::sqrt(1.0 + bodyEnergy));
+    for (int i = 0; i < length; i++)
+    {
+        const float direct = (i == 0) ? 1.0f : 0.0f;
+        response.set(i, (response[i] * resonanceScale + direct)
+                * totalScale);
+    }
+    return response;
+}
+
+
+// Calculates the spectrum of each partition of an impulse response,
+// allocates all buffers, and clears the convolver.
+void Audio::Convolver::prepare(const Array<float>& impulse,
+        const double sampleRate, const int blockSize)
+{
+    // Use the largest power of two that fits in a block, so each block
+    // processes one or two partitions:
+    partitionSize = minPartitionSize;
+    int fftOrder = 7;
+    while (partitionSize * 2 <= jmin(blockSize, maxPartitionSize))
+    {
+        partitionSize *= 2;
+        fftOrder++;
+    }
+    const int fftSize = partitionSize * 2;
+    fft.reset(new FFT(fftOrder));
+    jassert(fft->getSize() == fftSize);
+    const int impulseLength = jmin(impulse.size(),
+            roundToInt(maxImpulseSeconds * sampleRate));
+    numPartitions = jmax(1, (impulseLength + partitionSize - 1)
+            / partitionSize);
+    const size_t spectraSize = (size_t) (numPartitions * fftSize);
+    impulseReal.calloc(spectraSize);
+    impulseImag.calloc(spectraSize);
+    inputReal.malloc(spectraSize);
+    inputImag.malloc(spectraSize);
+    recentLeft.malloc((size_t) fftSize);
+    recentRight.malloc((size_t) fftSize);
+    sumReal.malloc((size_t) fftSize);
+    sumImag.malloc((size_t) fftSize);
+    outputLeft.malloc((size_t) partitionSize);
+    outputRight.malloc((size_t) partitionSize);
+    for (int p = 0; p < numPartitions; p++)
+    {
+        float* partitionReal = impulseReal + p * fftSize;
+        const int start = p * partitionSize;
+        const int length = jmin(partitionSize, impulseLength - start);
+        // Scaling here saves scaling every inverse transform:
+        for (int i = 0; i < length; i++)
+        {
+            partitionReal[i] = impulse[start + i] / fftSize;
+        }
+        fft->performForward(partitionReal, impulseImag + p * fftSize);
+    }
+    reset();
+}
+
+
+// Clears all stored input and output.
+void Audio::Convolver::reset()
+{
+    if (numPartitions == 0)
+    {
+        return;
+    }
+    const size_t spectraSize = sizeof(float) * (size_t) (numPartitions
+            * partitionSize * 2);
+    zeromem(inputReal, spectraSize);
+    zeromem(inputImag, spectraSize);
+    zeromem(recentLeft, sizeof(float) * (size_t) (partitionSize * 2));
+    zeromem(recentRight, sizeof(float) * (size_t) (partitionSize * 2));
+    zeromem(outputLeft, sizeof(float) * (size_t) partitionSize);
+    zeromem(outputRight, sizeof(float) * (size_t) partitionSize);
+    newestInput = 0;
+    partitionFrames = 0;
+    ringingFrames = 0;
+}
+
+
+// Gets the number of frames in each impulse partition.
+int Audio::Convolver::getPartitionSize() const
+{
+    return partitionSize;
+}
+
+
+// Gets the number of impulse partitions multiplied for each partition of
+// input.
+int Audio::Convolver::getNumPartitions() const
+{
+    return numPartitions;
+}
+
+
+// Checks if earlier input can still be heard in the output.
+bool Audio::Convolver::isRinging() const
+{
+    return ringingFrames > 0;
+}
+
+
+// Replaces a section of mono or stereo audio with the convolved output.
+void Audio::Convolver::process(float* left, float* right,
+        const int numSamples)
+{
+    if (numPartitions == 0)
+    {
+        return;
+    }
+    int done = 0;
+    while (done < numSamples)
+    {
+        const int numFrames = jmin(numSamples - done,
+                partitionSize - partitionFrames);
+        float* sectionLeft = left + done;
+        float* sectionRight = (right == nullptr) ? nullptr : right + done;
+        const Range<float> leftRange = FloatVectorOperations::findMinAndMax(
+                sectionLeft, numFrames);
+        const Range<float> rightRange = (sectionRight == nullptr)
+                ? Range<float>() : FloatVectorOperations::findMinAndMax(
+                sectionRight, numFrames);
+        if (leftRange.getStart() != 0.0f || leftRange.getEnd() != 0.0f
+                || rightRange.getStart() != 0.0f
+                || rightRange.getEnd() != 0.0f)
+        {
+            // The input reaches the output after one partition of latency,
+            // and then rings for the length of the impulse:
+            ringingFrames = (numPartitions + 2) * partitionSize;
+        }
+        else
+        {
+            ringingFrames = jmax(0, ringingFrames - numFrames);
+        }
+        const int position = partitionSize + partitionFrames;
+        FloatVectorOperations::copy(recentLeft + position, sectionLeft,
+                numFrames);
+        FloatVectorOperations::copy(sectionLeft, outputLeft + partitionFrames,
+                numFrames);
+        // Mono input leaves the imaginary part silent, and its output is
+        // discarded:
+        if (sectionRight == nullptr)
+        {
+            FloatVectorOperations::clear(recentRight + position, numFrames);
+        }
+        else
+        {
+            FloatVectorOperations::copy(recentRight + position, sectionRight,
+                    numFrames);
+            FloatVectorOperations::copy(sectionRight,
+                    outputRight + partitionFrames, numFrames);
+        }
+        partitionFrames += numFrames;
+        done += numFrames;
+        if (partitionFrames == partitionSize)
+        {
+            processPartition();
+            partitionFrames = 0;
+        }
+    }
+}
+
+
+// Convolves the last full partition of input, replacing the output
+// partition.
+void Audio::Convolver::processPartition()
+{
+    using namespace SIMD;
+    const int fftSize = partitionSize * 2;
+    newestInput = (newestInput + 1) % numPartitions;
+    float* newestReal = inputReal + newestInput * fftSize;
+    float* newestImag = inputImag + newestInput * fftSize;
+    // The left channel is the real part and the right channel the imaginary
+    // part, so one transform covers both:
+    FloatVectorOperations::copy(newestReal, recentLeft, fftSize);
+    FloatVectorOperations::copy(newestImag, recentRight, fftSize);
+    fft->performForward(newestReal, newestImag);
+    // This partition becomes the first half of the next transform:
+    FloatVectorOperations::copy(recentLeft, recentLeft + partitionSize,
+            partitionSize);
+    FloatVectorOperations::copy(recentRight, recentRight + partitionSize,
+            partitionSize);
+
+    // Multiply each recent input spectrum by the impulse partition it lines
+    // up with, summing the products:
+    FloatVectorOperations::clear(sumReal, fftSize);
+    FloatVectorOperations::clear(sumImag, fftSize);
+    int input = newestInput;
+    for (int p = 0; p < numPartitions; p++)
+    {
+        const float* xReal = inputReal + input * fftSize;
+        const float* xImag = inputImag + input * fftSize;
+        const float* hReal = impulseReal + p * fftSize;
+        const float* hImag = impulseImag + p * fftSize;
+        for (int i = 0; i < fftSize; i += size)
+        {
+            const Vector xr = load(xReal + i);
+            const Vector xi = load(xImag + i);
+            const Vector hr = load(hReal + i);
+            const Vector hi = load(hImag + i);
+            store(sumReal + i, subtract(multiplyAdd(load(sumReal + i), xr,
+                    hr), multiply(xi, hi)));
+            store(sumImag + i, multiplyAdd(multiplyAdd(load(sumImag + i), xr,
+                    hi), xi, hr));
+        }
+        input = (input == 0) ? numPartitions - 1 : input - 1;
+    }
+    fft->performInverse(sumReal, sumImag);
+    // The first half wraps around from the end of the transform, so only the
+    // second half is valid output:
+    FloatVectorOperations::copy(outputLeft, sumReal + partitionSize,
+            partitionSize);
+    FloatVectorOperations::copy(outputRight, sumImag + partitionSize,
+            partitionSize);
+}
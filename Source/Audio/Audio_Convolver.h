@@ -0,0 +1,155 @@
+#pragma once
+/**
+ * @file  Audio_Convolver.h
+ *
+ * @brief  Applies an impulse response to the output mix.
+ */
+
+#include "JuceHeader.h"
+#include "Audio_FFT.h"
+
+namespace Audio { class Convolver; }
+
+/**
+ * @brief  Convolves a mono or stereo signal with a short impulse response,
+ *         using a uniformly partitioned FFT convolution.
+ *
+ *  The impulse response is split into partitions of equal length, and the
+ * spectrum of each partition is calculated when the convolver is prepared.
+ * Input is collected until a full partition is ready, then transformed once
+ * and multiplied with every impulse partition using a frequency-domain delay
+ * line. Both stereo channels share each transform, with the left channel in
+ * the real part and the right channel in the imaginary part, which works
+ * because the impulse response is real.
+ *
+ *  Output is delayed by one partition. The partition size is chosen from the
+ * audio block size, so every block processes the same small number of
+ * partitions and the cost of each block stays fixed. Impulse responses
+ * should include the direct sound, as the convolver's output replaces its
+ * input.
+ *
+ *  All memory is allocated in prepare, so process never allocates. Like the
+ * VoicePool, the convolver should only be used on the audio thread or while
+ * the audio device is stopped.
+ */
+class Audio::Convolver
+{
+public:
+    // The smallest and largest partition sizes, in frames:
+    static const constexpr int minPartitionSize = 64;
+    static const constexpr int maxPartitionSize = 512;
+    // The longest impulse response that may be used, in seconds:
+    static const constexpr double maxImpulseSeconds = 0.5;
+
+    Convolver() { }
+
+    virtual ~Convolver() { }
+
+    /**
+     * @brief  Creates the impulse response of a small wooden music box
+     *         resting on a table.
+     *
+     * @param sampleRate  The sample rate of the created impulse response.
+     *
+     * @return            The impulse response, including the direct sound.
+     */
+    static juce::Array<float> createBodyResponse(const double sampleRate);
+
+    /**
+     * @brief  Calculates the spectrum of each partition of an impulse
+     *         response, allocates all buffers, and clears the convolver.
+     *         This should only be called while the audio device is stopped.
+     *
+     * @param impulse     The impulse response samples. Samples past
+     *                    maxImpulseSeconds are ignored.
+     *
+     * @param sampleRate  The sample rate of the impulse and the audio.
+     *
+     * @param blockSize   The expected audio block size, used to choose the
+     *                    partition size.
+     */
+    void prepare(const juce::Array<float>& impulse, const double sampleRate,
+            const int blockSize);
+
+    /**
+     * @brief  Clears all stored input and output, so the convolver is
+     *         silent until new input arrives.
+     */
+    void reset();
+
+    /**
+     * @brief  Gets the number of frames in each impulse partition.
+     *
+     * @return  The partition size, which is also the convolver's latency in
+     *          frames, or zero if the convolver hasn't been prepared.
+     */
+    int getPartitionSize() const;
+
+    /**
+     * @brief  Gets the number of impulse partitions multiplied for each
+     *         partition of input.
+     *
+     * @return  The number of partitions in the impulse response.
+     */
+    int getNumPartitions() const;
+
+    /**
+     * @brief  Checks if earlier input can still be heard in the output.
+     *
+     * @return  Whether processing silent input would produce sound.
+     */
+    bool isRinging() const;
+
+    /**
+     * @brief  Replaces a section of mono or stereo audio with the convolved
+     *         output. Audio passes through unchanged if the convolver hasn't
+     *         been prepared.
+     *
+     * @param left        The left or mono channel samples.
+     *
+     * @param right       The right channel samples, or nullptr for mono
+     *                    audio.
+     *
+     * @param numSamples  The number of frames to process.
+     */
+    void process(float* left, float* right, const int numSamples);
+
+private:
+    /**
+     * @brief  Convolves the last full partition of input, replacing the
+     *         output partition.
+     */
+    void processPartition();
+
+    // Transforms each partition, padded to twice its length:
+    std::unique_ptr<FFT> fft;
+    // The number of frames in each partition:
+    int partitionSize = 0;
+    // The number of impulse response partitions:
+    int numPartitions = 0;
+    // The spectrum of each impulse partition, scaled to undo the inverse
+    // transform's gain:
+    juce::HeapBlock<float> impulseReal;
+    juce::HeapBlock<float> impulseImag;
+    // The spectrum of each recent input partition, used as a ring buffer:
+    juce::HeapBlock<float> inputReal;
+    juce::HeapBlock<float> inputImag;
+    // The ring buffer index of the newest input spectrum:
+    int newestInput = 0;
+    // The last two partitions of left and right input, with the second
+    // partition being filled:
+    juce::HeapBlock<float> recentLeft;
+    juce::HeapBlock<float> recentRight;
+    // The sum of each input spectrum multiplied by its impulse partition:
+    juce::HeapBlock<float> sumReal;
+    juce::HeapBlock<float> sumImag;
+    // The output of the last processed partition:
+    juce::HeapBlock<float> outputLeft;
+    juce::HeapBlock<float> outputRight;
+    // The number of frames of the current partition that have been filled:
+    int partitionFrames = 0;
+    // The number of frames still affected by the last non-silent input:
+    int ringingFrames = 0;
+
+    JUCE_DECLARE_NON_COPYABLE(Convolver)
+};
@@ -0,0 +1,160 @@
+#include "Audio_EventList.h"
+#include <algorithm>
+
+// Compiles an event list from a note map.
+Audio::EventList::EventList(const std::map<int, juce::Array<int>>& noteMap,
+        const int numBeats,
+        const std::map<int, std::map<int, float>>& gainMap) :
+numBeats(numBeats)
+{
+    int maxNotes = 0;
+    for (const auto& iter : noteMap)
+    {
+        maxNotes += iter.second.size();
+    }
+    allocate((int) noteMap.size(), maxNotes, gainMap.empty() ? 0 : maxNotes);
+    addEvents(noteMap, gainMap, juce::Range<int>(0,
+            std::numeric_limits<int>::max()));
+}
+
+
+// Compiles an edited copy of another event list, only reading the edited
+// beats from the note map.
+Audio::EventList::EventList(const EventList& previous,
+        const juce::Range<int> editedBeats,
+        const std::map<int, juce::Array<int>>& noteMap,
+        const int numBeats,
+        const std::map<int, std::map<int, float>>& gainMap) :
+numBeats(numBeats)
+{
+    const int editStart = previous.findFirstEvent(editedBeats.getStart());
+    const int editEnd = previous.findFirstEvent(editedBeats.getEnd());
+    int maxEvents = previous.getNumEvents() - (editEnd - editStart);
+    int editedNotes = 0;
+    for (auto iter = noteMap.lower_bound(editedBeats.getStart());
+            iter != noteMap.end() && iter->first < editedBeats.getEnd();
+            iter++)
+    {
+        maxEvents++;
+        editedNotes += iter->second.size();
+    }
+    allocate(maxEvents, previous.notes.size() + editedNotes,
+            previous.gains.size() + (gainMap.empty() ? 0 : editedNotes));
+    // Events outside the edited range are copied unchanged:
+    for (int i = 0; i < editStart; i++)
+    {
+        const Event& event = previous.getEvent(i);
+        addEvent(event.beat, event.notes, event.numNotes, event.gains);
+    }
+    addEvents(noteMap, gainMap, editedBeats);
+    for (int i = editEnd; i < previous.getNumEvents(); i++)
+    {
+        const Event& event = previous.getEvent(i);
+        addEvent(event.beat, event.notes, event.numNotes, event.gains);
+    }
+}
+
+
+// Gets the number of beats that contain notes.
+int Audio::EventList::getNumEvents() const
+{
+    return events.size();
+}
+
+
+// Gets a stored event.
+const Audio::EventList::Event& Audio::EventList::getEvent(const int index) const
+{
+    return events.getReference(index);
+}
+
+
+// Finds the first event at or after a beat.
+int Audio::EventList::findFirstEvent(const int beat) const
+{
+    const Event* first = std::lower_bound(events.begin(), events.end(), beat,
+            [](const Event& event, const int beat)
+            {
+                return event.beat < beat;
+            });
+    return (int) (first - events.begin());
+}
+
+
+// Gets the length of the song in beats.
+int Audio::EventList::getBeatCount() const
+{
+    return numBeats;
+}
+
+
+// Allocates space for all events, notes and gains, so adding events never
+// moves the packed arrays.
+void Audio::EventList::allocate(const int maxEvents, const int maxNotes,
+        const int maxGains)
+{
+    events.ensureStorageAllocated(maxEvents);
+    notes.ensureStorageAllocated(maxNotes);
+    gains.ensureStorageAllocated(maxGains);
+}
+
+
+// Adds an event to the end of the list, copying its notes and gains into the
+// packed arrays.
+void Audio::EventList::addEvent(const int beat, const int* eventNotes,
+        const int numNotes, const float* eventGains)
+{
+    jassert(events.isEmpty() || events.getLast().beat < beat);
+    // Events point into the packed arrays, which allocate never lets
+    // reallocate:
+    const int* packedNotes = notes.getRawDataPointer() + notes.size();
+    notes.addArray(eventNotes, numNotes);
+    const float* packedGains = nullptr;
+    if (eventGains != nullptr)
+    {
+        packedGains = gains.getRawDataPointer() + gains.size();
+        gains.addArray(eventGains, numNotes);
+    }
+    events.add({ beat, numNotes, packedNotes, packedGains });
+}
+
+
+// Compiles and adds the events for a range of beats in a note map.
+void Audio::EventList::addEvents(
+        const std::map<int, juce::Array<int>>& noteMap,
+        const std::map<int, std::map<int, float>>& gainMap,
+        const juce::Range<int> beats)
+{
+    juce::Array<float> beatGains;
+    // std::map iterates in key order, so events are added sorted by beat:
+    for (auto iter = noteMap.lower_bound(jmax(0, beats.getStart()));
+            iter != noteMap.end() && iter->first < beats.getEnd(); iter++)
+    {
+        const juce::Array<int>& beatNotes = iter->second;
+        if (beatNotes.isEmpty())
+        {
+            continue;
+        }
+        const float* eventGains = nullptr;
+        auto gainIter = gainMap.find(iter->first);
+        if (gainIter != gainMap.end())
+        {
+            bool belowFullGain = false;
+            beatGains.clearQuick();
+            for (const int& note : beatNotes)
+            {
+                auto noteGain = gainIter->second.find(note);
+                const float gain = (noteGain == gainIter->second.end())
+                        ? 1.0f : jlimit(0.0f, 1.0f, noteGain->second);
+                belowFullGain = belowFullGain || gain < 1.0f;
+                beatGains.add(gain);
+            }
+            if (belowFullGain)
+            {
+                eventGains = beatGains.getRawDataPointer();
+            }
+        }
+        addEvent(iter->first, beatNotes.getRawDataPointer(), beatNotes.size(),
+                eventGains);
+    }
+}
@@ -0,0 +1,178 @@
+#pragma once
+/**
+ * @file  Audio_EventList.h
+ *
+ * @brief  Stores a song's notes in a form the audio thread can read directly.
+ */
+
+#include "JuceHeader.h"
+#include <map>
+
+namespace Audio { class EventList; }
+
+/**
+ * @brief  An immutable list of note events, compiled from a NoteGrid note map
+ *         before playback starts.
+ *
+ *  Events are sorted by beat, and only beats that contain notes are stored.
+ * All events are stored in one contiguous array, and their notes and gains
+ * are packed into two more shared arrays, so playing the list never follows
+ * more than one pointer per event. Events only store note gains when some of
+ * their notes play below full gain, so songs without note gains cost nothing
+ * extra to play.
+ *
+ *  Songs edited during playback are recompiled into a new list, copying every
+ * event outside the edited beats from the previous list. EventList objects
+ * are shared with the audio thread, so they should always be added to an
+ * Audio::ReleasePool to ensure they are never deleted on the audio thread.
+ */
+class Audio::EventList : public juce::ReferenceCountedObject
+{
+public:
+    typedef juce::ReferenceCountedObjectPtr<EventList> Ptr;
+
+    /**
+     * @brief  All notes that start on a single beat.
+     */
+    struct Event
+    {
+        // The beat index where the notes start:
+        int beat;
+        // The number of notes played on the beat:
+        int numNotes;
+        // The indices of all notes played on the beat:
+        const int* notes;
+        // The linear gain of each note, in the same order, or nullptr if
+        // every note plays at full gain:
+        const float* gains;
+    };
+
+    /**
+     * @brief  Compiles an event list from a note map.
+     *
+     * @param noteMap   Maps each beat number to the list of all notes played
+     *                  on that beat.
+     *
+     * @param numBeats  The length of the song in beats.
+     *
+     * @param gainMap   Maps each beat number to the gain of each of that
+     *                  beat's notes that doesn't play at full gain.
+     */
+    EventList(const std::map<int, juce::Array<int>>& noteMap,
+            const int numBeats,
+            const std::map<int, std::map<int, float>>& gainMap = {});
+
+    /**
+     * @brief  Compiles an edited copy of another event list, only reading the
+     *         edited beats from the note map.
+     *
+     * @param previous     The event list compiled before the edit.
+     *
+     * @param editedBeats  The range of beats that may have changed.
+     *
+     * @param noteMap      Maps each beat number to the list of all notes
+     *                     played on that beat.
+     *
+     * @param numBeats     The length of the edited song in beats.
+     *
+     * @param gainMap      Maps each beat number to the gain of each of that
+     *                     beat's notes that doesn't play at full gain.
+     */
+    EventList(const EventList& previous, const juce::Range<int> editedBeats,
+            const std::map<int, juce::Array<int>>& noteMap,
+            const int numBeats,
+            const std::map<int, std::map<int, float>>& gainMap = {});
+
+    virtual ~EventList() { }
+
+    /**
+     * @brief  Gets the number of beats that contain notes.
+     *
+     * @return  The number of stored events.
+     */
+    int getNumEvents() const;
+
+    /**
+     * @brief  Gets a stored event.
+     *
+     * @param index  The index of an event, which must be between zero and
+     *               getNumEvents() - 1.
+     *
+     * @return       The event at that index.
+     */
+    const Event& getEvent(const int index) const;
+
+    /**
+     * @brief  Finds the first event at or after a beat.
+     *
+     * @param beat  The beat to search from.
+     *
+     * @return      The index of the first event starting on or after the
+     *              beat, or getNumEvents() if there is none.
+     */
+    int findFirstEvent(const int beat) const;
+
+    /**
+     * @brief  Gets the length of the song in beats.
+     *
+     * @return  The number of beats needed to play all events.
+     */
+    int getBeatCount() const;
+
+private:
+    /**
+     * @brief  Allocates space for all events, notes and gains, so adding
+     *         events never moves the packed arrays.
+     *
+     * @param maxEvents  The largest number of events that will be added.
+     *
+     * @param maxNotes   The largest number of notes that will be added.
+     *
+     * @param maxGains   The largest number of note gains that will be added.
+     */
+    void allocate(const int maxEvents, const int maxNotes,
+            const int maxGains);
+
+    /**
+     * @brief  Adds an event to the end of the list, copying its notes and
+     *         gains into the packed arrays.
+     *
+     * @param beat        The beat index where the notes start, which must be
+     *                    after every event already added.
+     *
+     * @param eventNotes  The indices of all notes played on the beat.
+     *
+     * @param numNotes    The number of notes played on the beat.
+     *
+     * @param eventGains  The gain of each note, or nullptr if every note plays
+     *                    at full gain.
+     */
+    void addEvent(const int beat, const int* eventNotes, const int numNotes,
+            const float* eventGains);
+
+    /**
+     * @brief  Compiles and adds the events for a range of beats in a note map.
+     *
+     * @param noteMap  Maps each beat number to the list of all notes played on
+     *                 that beat.
+     *
+     * @param gainMap  Maps each beat number to the gain of each of that
+     *                 beat's notes that doesn't play at full gain.
+     *
+     * @param beats    The range of beats to compile.
+     */
+    void addEvents(const std::map<int, juce::Array<int>>& noteMap,
+            const std::map<int, std::map<int, float>>& gainMap,
+            const juce::Range<int> beats);
+
+    // All beats containing notes, sorted by beat:
+    juce::Array<Event> events;
+    // The notes of every event, packed in event order:
+    juce::Array<int> notes;
+    // The note gains of every event with gains, packed in event order:
+    juce::Array<float> gains;
+    // The length of the song in beats:
+    int numBeats;
+
+    JUCE_DECLARE_NON_COPYABLE(EventList)
+};
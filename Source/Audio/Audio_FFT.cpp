@@ -0,0 +1,117 @@
+#include "Audio_FFT.h"
+#include "Audio_SIMD.h"
+
+// Calculates the bit-reversal swaps and twiddle factors for a transform
+// size.
+Audio::FFT::FFT(const int order) :
+size(1 << order), swapIndices((size_t) size), twiddleReal((size_t) size),
+twiddleImag((size_t) size)
+{
+    jassert(order >= 2 && order < 31);
+    for (int i = 0; i < size; i++)
+    {
+        int reversed = 0;
+        for (int bit = 0; bit < order; bit++)
+        {
+            reversed |= ((i >> bit) & 1) << (order - 1 - bit);
+        }
+        if (i < reversed)
+        {
+            swapIndices[numSwaps * 2] = i;
+            swapIndices[numSwaps * 2 + 1] = reversed;
+            numSwaps++;
+        }
+    }
+    twiddleReal[0] = 1.0f;
+    twiddleImag[0] = 0.0f;
+    for (int half = 1; half < size; half *= 2)
+    {
+        for (int j = 0; j < half; j++)
+        {
+            const double angle = -MathConstants<double>::pi * j / half;
+            twiddleReal[half + j] = (float) std::cos(angle);
+            twiddleImag[half + j] = (float) std::sin(angle);
+        }
+    }
+}
+
+
+// Gets the number of complex values in each transform.
+int Audio::FFT::getSize() const
+{
+    return size;
+}
+
+
+// Replaces complex data with its discrete Fourier transform.
+void Audio::FFT::performForward(float* real, float* imag) const
+{
+    using namespace SIMD;
+    for (int i = 0; i < numSwaps; i++)
+    {
+        const int first = swapIndices[i * 2];
+        const int second = swapIndices[i * 2 + 1];
+        std::swap(real[first], real[second]);
+        std::swap(imag[first], imag[second]);
+    }
+    // The first two stages only multiply by 1 and -i, so they're done
+    // together without twiddle factors:
+    for (int k = 0; k < size; k += 4)
+    {
+        const float r0 = real[k] + real[k + 1];
+        const float i0 = imag[k] + imag[k + 1];
+        const float r1 = real[k] - real[k + 1];
+        const float i1 = imag[k] - imag[k + 1];
+        const float r2 = real[k + 2] + real[k + 3];
+        const float i2 = imag[k + 2] + imag[k + 3];
+        const float r3 = real[k + 2] - real[k + 3];
+        const float i3 = imag[k + 2] - imag[k + 3];
+        real[k] = r0 + r2;
+        imag[k] = i0 + i2;
+        real[k + 2] = r0 - r2;
+        imag[k + 2] = i0 - i2;
+        // (r3 + i * i3) * -i = i3 - i * r3:
+        real[k + 1] = r1 + i3;
+        imag[k + 1] = i1 - r3;
+        real[k + 3] = r1 - i3;
+        imag[k + 3] = i1 + r3;
+    }
+    for (int half = 4; half < size; half *= 2)
+    {
+        const float* stageReal = twiddleReal + half;
+        const float* stageImag = twiddleImag + half;
+        for (int k = 0; k < size; k += half * 2)
+        {
+            float* lowReal = real + k;
+            float* lowImag = imag + k;
+            float* highReal = lowReal + half;
+            float* highImag = lowImag + half;
+            for (int j = 0; j < half; j += SIMD::size)
+            {
+                const Vector wr = load(stageReal + j);
+                const Vector wi = load(stageImag + j);
+                const Vector hr = load(highReal + j);
+                const Vector hi = load(highImag + j);
+                const Vector br = subtract(multiply(hr, wr),
+                        multiply(hi, wi));
+                const Vector bi = multiplyAdd(multiply(hr, wi), hi, wr);
+                const Vector ar = load(lowReal + j);
+                const Vector ai = load(lowImag + j);
+                store(lowReal + j, add(ar, br));
+                store(lowImag + j, add(ai, bi));
+                store(highReal + j, subtract(ar, br));
+                store(highImag + j, subtract(ai, bi));
+            }
+        }
+    }
+}
+
+
+// Replaces a discrete Fourier transform with the complex data it was created
+// from, multiplied by the transform size.
+void Audio::FFT::performInverse(float* real, float* imag) const
+{
+    // Swapping the real and imaginary parts conjugates the input and output,
+    // which turns the forward transform into the inverse:
+    performForward(imag, real);
+}
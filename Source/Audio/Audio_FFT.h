@@ -0,0 +1,76 @@
+#pragma once
+/**
+ * @file  Audio_FFT.h
+ *
+ * @brief  Performs fast Fourier transforms on split complex data.
+ */
+
+#include "JuceHeader.h"
+
+namespace Audio { class FFT; }
+
+/**
+ * @brief  An in-place radix-2 complex FFT of a fixed power-of-two size.
+ *
+ *  Complex values are stored with their real and imaginary parts in separate
+ * arrays, so the butterflies of every stage after the first two process four
+ * values at once with the SIMD wrappers. All tables are created by the
+ * constructor, so transforms never allocate memory, and a single FFT may be
+ * used by several threads at once.
+ *
+ *  Neither transform is scaled, so a forward transform followed by an
+ * inverse transform multiplies the data by the transform size.
+ */
+class Audio::FFT
+{
+public:
+    /**
+     * @brief  Creates the twiddle factor and bit reversal tables for a
+     *         transform size.
+     *
+     * @param order  The base 2 logarithm of the transform size, at least 2.
+     */
+    FFT(const int order);
+
+    virtual ~FFT() { }
+
+    /**
+     * @brief  Gets the number of complex values in each transform.
+     *
+     * @return  The transform size.
+     */
+    int getSize() const;
+
+    /**
+     * @brief  Replaces complex data with its discrete Fourier transform.
+     *
+     * @param real  The real part of each of the getSize() values.
+     *
+     * @param imag  The imaginary part of each value.
+     */
+    void performForward(float* real, float* imag) const;
+
+    /**
+     * @brief  Replaces a discrete Fourier transform with the complex data it
+     *         was created from, multiplied by the transform size.
+     *
+     * @param real  The real part of each of the getSize() values.
+     *
+     * @param imag  The imaginary part of each value.
+     */
+    void performInverse(float* real, float* imag) const;
+
+private:
+    // The number of complex values in each transform:
+    int size;
+    // Pairs of indices swapped to put the data in bit-reversed order:
+    juce::HeapBlock<int> swapIndices;
+    // The number of index pairs in swapIndices:
+    int numSwaps = 0;
+    // Twiddle factors for every stage. The stage combining transforms of
+    // size n uses the n values starting at index n, exp(-i * pi * j / n):
+    juce::HeapBlock<float> twiddleReal;
+    juce::HeapBlock<float> twiddleImag;
+
+    JUCE_DECLARE_NON_COPYABLE(FFT)
+};
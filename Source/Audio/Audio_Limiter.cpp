@@ -0,0 +1,222 @@
+#include "Audio_Limiter.h"
+
+// Soft clipping starts at this fraction of the ceiling:
+static const constexpr float softClipKnee = 0.7f;
+
+// Recovering gains this close to unity are treated as unity:
+static const constexpr float unityTolerance = 1.0e-5f;
+
+// Creates a limiter that passes audio through until it is prepared.
+Audio::Limiter::Limiter() :
+ceiling(Decibels::decibelsToGain(defaultCeilingDb)) { }
+
+
+// Limits a buffer of offline audio in place, without delaying it.
+void Audio::Limiter::limitBuffer(AudioBuffer<float>& audio,
+        const double sampleRate, const float ceilingDb, const bool softClip)
+{
+    jassert(audio.getNumChannels() == 1 || audio.getNumChannels() == 2);
+    Limiter limiter;
+    limiter.setCeiling(ceilingDb);
+    limiter.setSoftClip(softClip);
+    limiter.prepare(sampleRate);
+    const int numChannels = audio.getNumChannels();
+    const int length = audio.getNumSamples();
+    const int latency = limiter.getLatency();
+    // Process the delayed end of the audio by adding silence, then remove
+    // the delay from the start:
+    audio.setSize(numChannels, length + latency, true, true);
+    limiter.process(audio.getWritePointer(0), (numChannels > 1)
+            ? audio.getWritePointer(1) : nullptr, length + latency);
+    for (int c = 0; c < numChannels; c++)
+    {
+        float* data = audio.getWritePointer(c);
+        std::memmove(data, data + latency, sizeof(float) * (size_t) length);
+    }
+    audio.setSize(numChannels, length, true, false, true);
+}
+
+
+// Allocates the look-ahead buffers for a sample rate, and clears the limiter.
+void Audio::Limiter::prepare(const double sampleRate)
+{
+    jassert(sampleRate > 0);
+    latency = jmax(1, roundToInt(lookaheadSeconds * sampleRate));
+    releaseCoefficient = (float) std::exp(std::log(0.001)
+            / (releaseSeconds * sampleRate));
+    // The window minimum and moving average both cover the delayed frame
+    // and every frame after it:
+    const size_t windowSize = (size_t) latency + 1;
+    delayLeft.malloc((size_t) latency);
+    delayRight.malloc((size_t) latency);
+    minimumFrames.malloc(windowSize);
+    minimumGains.malloc(windowSize);
+    recentGains.malloc(windowSize);
+    reset();
+}
+
+
+// Clears all delayed audio and resets the gain.
+void Audio::Limiter::reset()
+{
+    if (latency == 0)
+    {
+        return;
+    }
+    FloatVectorOperations::clear(delayLeft, latency);
+    FloatVectorOperations::clear(delayRight, latency);
+    FloatVectorOperations::fill(recentGains, 1.0f, latency + 1);
+    recentGainSum = latency + 1;
+    delayPosition = 0;
+    recentPosition = 0;
+    minimumStart = 0;
+    numMinimums = 0;
+    releasedGain = 1.0f;
+    frameCount = 0;
+    ringingFrames = 0;
+    gainReductionDb = 0.0f;
+}
+
+
+// Sets the highest level output samples may reach.
+void Audio::Limiter::setCeiling(const float ceilingDb)
+{
+    ceiling = Decibels::decibelsToGain(jmin(ceilingDb, 0.0f));
+}
+
+
+// Turns soft clipping of peaks on or off.
+void Audio::Limiter::setSoftClip(const bool enabled)
+{
+    softClip = enabled;
+}
+
+
+// Gets the number of frames the limiter delays its input.
+int Audio::Limiter::getLatency() const
+{
+    return latency;
+}
+
+
+// Checks if the limiter still holds delayed audio, or is still recovering
+// from gain reduction.
+bool Audio::Limiter::isRinging() const
+{
+    return ringingFrames > 0;
+}
+
+
+// Gets the largest gain reduction applied since the last time it was read,
+// and starts measuring again.
+float Audio::Limiter::getGainReductionDb()
+{
+    return gainReductionDb.exchange(0.0f);
+}
+
+
+// Replaces a section of audio with the limited, delayed output.
+void Audio::Limiter::process(float* left, float* right, const int numSamples)
+{
+    if (latency == 0)
+    {
+        return;
+    }
+    const int windowSize = latency + 1;
+    float lowestGain = 1.0f;
+    bool active = false;
+    for (int i = 0; i < numSamples; i++)
+    {
+        const float peak = (right == nullptr) ? std::abs(left[i])
+                : jmax(std::abs(left[i]), std::abs(right[i]));
+        const float requiredGain = (peak > ceiling) ? ceiling / peak : 1.0f;
+
+        // Keep only candidates inside the window that could still become
+        // the window minimum, so the first candidate is always the minimum:
+        if (numMinimums > 0
+                && minimumFrames[minimumStart] <= frameCount - windowSize)
+        {
+            minimumStart = (minimumStart + 1) % windowSize;
+            numMinimums--;
+        }
+        while (numMinimums > 0 && minimumGains[(minimumStart + numMinimums
+                - 1) % windowSize] >= requiredGain)
+        {
+            numMinimums--;
+        }
+        const int newMinimum = (minimumStart + numMinimums) % windowSize;
+        minimumFrames[newMinimum] = frameCount;
+        minimumGains[newMinimum] = requiredGain;
+        numMinimums++;
+        const float minimumGain = minimumGains[minimumStart];
+
+        // Drop instantly to the minimum, and recover from it gradually:
+        if (minimumGain < releasedGain)
+        {
+            releasedGain = minimumGain;
+        }
+        else
+        {
+            releasedGain = minimumGain + (releasedGain - minimumGain)
+                    * releaseCoefficient;
+            if (releasedGain > 1.0f - unityTolerance)
+            {
+                releasedGain = 1.0f;
+            }
+        }
+        // Averaging over the look-ahead ramps the gain down before each
+        // peak, and every averaged gain is low enough for the delayed frame:
+        recentGainSum += releasedGain - recentGains[recentPosition];
+        recentGains[recentPosition] = releasedGain;
+        recentPosition = (recentPosition + 1) % windowSize;
+        const float gain = jmin(1.0f, (float) (recentGainSum / windowSize));
+        lowestGain = jmin(lowestGain, gain);
+        active = active || peak > 0.0f || releasedGain < 1.0f;
+
+        const float delayedLeft = delayLeft[delayPosition];
+        delayLeft[delayPosition] = left[i];
+        left[i] = delayedLeft * gain;
+        if (right != nullptr)
+        {
+            const float delayedRight = delayRight[delayPosition];
+            delayRight[delayPosition] = right[i];
+            right[i] = delayedRight * gain;
+        }
+        delayPosition = (delayPosition + 1) % latency;
+        if (softClip)
+        {
+            left[i] = softClipSample(left[i]);
+            if (right != nullptr)
+            {
+                right[i] = softClipSample(right[i]);
+            }
+        }
+        frameCount++;
+    }
+    // Delayed input and averaged gains take two windows to clear:
+    ringingFrames = active ? windowSize * 2
+            : jmax(0, ringingFrames - numSamples);
+    // Keep the largest reduction until it is read, so readers polling less
+    // often than blocks are processed still see every peak:
+    const float blockReductionDb = jmax(0.0f,
+            -Decibels::gainToDecibels(lowestGain));
+    float largestDb = gainReductionDb.load(std::memory_order_relaxed);
+    while (blockReductionDb > largestDb
+            && ! gainReductionDb.compare_exchange_weak(largestDb,
+                blockReductionDb)) { }
+}
+
+
+// Softly limits a sample that may reach the ceiling.
+float Audio::Limiter::softClipSample(const float sample) const
+{
+    const float knee = ceiling * softClipKnee;
+    const float level = std::abs(sample);
+    if (level <= knee)
+    {
+        return sample;
+    }
+    const float range = ceiling - knee;
+    return std::copysign(knee + range * std::tanh((level - knee) / range),
+            sample);
+}
@@ -0,0 +1,176 @@
+#pragma once
+/**
+ * @file  Audio_Limiter.h
+ *
+ * @brief  Keeps the output mix from clipping.
+ */
+
+#include "JuceHeader.h"
+#include <atomic>
+
+namespace Audio { class Limiter; }
+
+/**
+ * @brief  A look-ahead peak limiter that keeps every output sample at or
+ *         below a ceiling level.
+ *
+ *  Input is delayed by a short look-ahead, so gain reduction can ramp down
+ * smoothly before each peak arrives instead of clipping it. The gain needed
+ * by every sample in the look-ahead is tracked with a sliding window minimum,
+ * and then smoothed with a moving average exactly as long as the look-ahead,
+ * which guarantees each delayed sample's gain is low enough for that sample.
+ * Gain recovers gradually after peaks pass. Stereo channels share the same
+ * gain, so the stereo image doesn't shift while limiting.
+ *
+ *  An optional soft clip rounds off peaks that reach the ceiling, trading a
+ * little saturation on the loudest peaks for a less abrupt limit.
+ *
+ *  All memory is allocated in prepare, so process never allocates. Apart
+ * from getGainReductionDb, the limiter should only be used on the audio
+ * thread or while the audio device is stopped.
+ */
+class Audio::Limiter
+{
+public:
+    // The look-ahead delay, in seconds:
+    static const constexpr double lookaheadSeconds = 0.002;
+    // The time taken for the gain to recover by 60dB after peaks, in seconds:
+    static const constexpr double releaseSeconds = 0.15;
+    // The ceiling level used until another is set, in decibels:
+    static const constexpr float defaultCeilingDb = -1.0f;
+
+    Limiter();
+
+    virtual ~Limiter() { }
+
+    /**
+     * @brief  Limits a buffer of offline audio in place, without delaying it.
+     *
+     * @param audio       A mono or stereo buffer.
+     *
+     * @param sampleRate  The audio's sample rate.
+     *
+     * @param ceilingDb   The highest allowed sample level, in decibels.
+     *
+     * @param softClip    Whether peaks are softly clipped.
+     */
+    static void limitBuffer(juce::AudioBuffer<float>& audio,
+            const double sampleRate,
+            const float ceilingDb = defaultCeilingDb,
+            const bool softClip = false);
+
+    /**
+     * @brief  Allocates the look-ahead buffers for a sample rate, and clears
+     *         the limiter. This should only be called while the audio device
+     *         is stopped.
+     *
+     * @param sampleRate  The audio's sample rate.
+     */
+    void prepare(const double sampleRate);
+
+    /**
+     * @brief  Clears all delayed audio and resets the gain.
+     */
+    void reset();
+
+    /**
+     * @brief  Sets the highest level output samples may reach.
+     *
+     * @param ceilingDb  The ceiling in decibels, at or below 0dB.
+     */
+    void setCeiling(const float ceilingDb);
+
+    /**
+     * @brief  Turns soft clipping of peaks on or off.
+     *
+     * @param enabled  Whether peaks are softly clipped.
+     */
+    void setSoftClip(const bool enabled);
+
+    /**
+     * @brief  Gets the number of frames the limiter delays its input.
+     *
+     * @return  The look-ahead length in frames, or zero if the limiter hasn't
+     *          been prepared.
+     */
+    int getLatency() const;
+
+    /**
+     * @brief  Checks if the limiter still holds delayed audio, or is still
+     *         recovering from gain reduction.
+     *
+     * @return  Whether processing silent input would change the limiter.
+     */
+    bool isRinging() const;
+
+    /**
+     * @brief  Gets the largest gain reduction applied since the last time it
+     *         was read, and starts measuring again. This may be called on any
+     *         thread, but only one thread should read it.
+     *
+     * @return  The gain reduction in decibels, zero or above.
+     */
+    float getGainReductionDb();
+
+    /**
+     * @brief  Replaces a section of audio with the limited, delayed output.
+     *         Audio passes through unchanged if the limiter hasn't been
+     *         prepared.
+     *
+     * @param left        The left or mono channel samples.
+     *
+     * @param right       The right channel samples, or nullptr for mono
+     *                    audio.
+     *
+     * @param numSamples  The number of frames to process.
+     */
+    void process(float* left, float* right, const int numSamples);
+
+private:
+    /**
+     * @brief  Softly limits a sample that may reach the ceiling.
+     *
+     * @param sample  A sample at or below the ceiling level.
+     *
+     * @return        The clipped sample, which stays below the ceiling.
+     */
+    float softClipSample(const float sample) const;
+
+    // The highest allowed output level as a linear gain:
+    float ceiling;
+    // Whether peaks are softly clipped:
+    bool softClip = false;
+    // The look-ahead delay in frames, or zero if not prepared:
+    int latency = 0;
+    // The gain multiplier applied each frame while the gain recovers:
+    float releaseCoefficient = 0.0f;
+    // Delayed input for each channel, used as ring buffers:
+    juce::HeapBlock<float> delayLeft;
+    juce::HeapBlock<float> delayRight;
+    // The position of the oldest delayed frame:
+    int delayPosition = 0;
+    // The frame number and required gain of each sliding window minimum
+    // candidate, used as a ring buffer holding a queue with rising gains:
+    juce::HeapBlock<juce::int64> minimumFrames;
+    juce::HeapBlock<float> minimumGains;
+    // The ring buffer index of the first minimum candidate:
+    int minimumStart = 0;
+    // The number of minimum candidates:
+    int numMinimums = 0;
+    // The recovering gain of each recent frame, averaged to smooth the gain:
+    juce::HeapBlock<float> recentGains;
+    // The sum of all recent gains:
+    double recentGainSum = 0.0;
+    // The recent gain ring buffer index replaced by the next frame:
+    int recentPosition = 0;
+    // The gain after recovering from the last minimum:
+    float releasedGain = 1.0f;
+    // The number of frames processed since the limiter was reset:
+    juce::int64 frameCount = 0;
+    // The number of frames still affected by the last non-silent input:
+    int ringingFrames = 0;
+    // The largest gain reduction since it was last read, in decibels:
+    std::atomic<float> gainReductionDb { 0.0f };
+
+    JUCE_DECLARE_NON_COPYABLE(Limiter)
+};
@@ -0,0 +1,288 @@
+#include "Audio_MixKernel.h"
+#include "Audio_SIMD.h"
+
+
+/**
+ * @brief  Checks if a voice can be mixed in the single pass over the output
+ *         block.
+ *
+ * @param source      A voice in the mix.
+ *
+ * @param numSamples  The number of frames in the output block.
+ *
+ * @return            Whether the voice covers the whole block at a constant
+ *                    gain.
+ */
+static inline bool isConstantBlock(const Audio::MixKernel::Source& source,
+        const int numSamples)
+{
+    return source.numFrames == numSamples && source.leftGainStep == 0.0f
+            && source.rightGainStep == 0.0f;
+}
+
+
+/**
+ * @brief  Gets the gain used for a voice in a mono mix.
+ *
+ * @param source  A voice in the mix.
+ *
+ * @return        The average of the voice's channel gains.
+ */
+static inline float monoGain(const Audio::MixKernel::Source& source)
+{
+    return (source.leftGain + source.rightGain) * 0.5f;
+}
+
+
+/**
+ * @brief  Gets the per-frame gain change used for a voice in a mono mix.
+ *
+ * @param source  A voice in the mix.
+ *
+ * @return        The average of the voice's channel gain steps.
+ */
+static inline float monoGainStep(const Audio::MixKernel::Source& source)
+{
+    return (source.leftGainStep + source.rightGainStep) * 0.5f;
+}
+
+
+// Gets the left and right channel gain of a panned voice.
+void Audio::MixKernel::getPanGains(const float gain, const float pan,
+        float& leftGain, float& rightGain)
+{
+    const float clippedPan = jlimit(-1.0f, 1.0f, pan);
+    leftGain = gain * jmin(1.0f, 1.0f - clippedPan);
+    rightGain = gain * jmin(1.0f, 1.0f + clippedPan);
+}
+
+
+// Checks if the mixing functions use SIMD instructions on this processor.
+bool Audio::MixKernel::isVectorised()
+{
+    #if AUDIO_SIMD_NATIVE
+    return true;
+    #else
+    return false;
+    #endif
+}
+
+
+#if AUDIO_SIMD_NATIVE
+/**
+ * @brief  Adds a voice that ends or changes gain partway through the block to
+ *         a stereo mix.
+ *
+ * @param source  The voice to add.
+ *
+ * @param left    The left channel of the mix.
+ *
+ * @param right   The right channel of the mix.
+ */
+static void mixRampedStereo(const Audio::MixKernel::Source& source,
+        float* left, float* right)
+{
+    using namespace Audio::SIMD;
+    Vector leftGain = ramp(source.leftGain, source.leftGainStep);
+    Vector rightGain = ramp(source.rightGain, source.rightGainStep);
+    const Vector leftStep = fill(source.leftGainStep * size);
+    const Vector rightStep = fill(source.rightGainStep * size);
+    int i = 0;
+    for (; i <= source.numFrames - size; i += size)
+    {
+        const Vector input = load(source.data + i);
+        store(left + i, multiplyAdd(load(left + i), input, leftGain));
+        store(right + i, multiplyAdd(load(right + i), input, rightGain));
+        leftGain = add(leftGain, leftStep);
+        rightGain = add(rightGain, rightStep);
+    }
+    for (; i < source.numFrames; i++)
+    {
+        left[i] += source.data[i] * (source.leftGain + source.leftGainStep * i);
+        right[i] += source.data[i]
+                * (source.rightGain + source.rightGainStep * i);
+    }
+}
+
+
+/**
+ * @brief  Adds a voice that ends or changes gain partway through the block to
+ *         a mono mix.
+ *
+ * @param source  The voice to add.
+ *
+ * @param output  The mix buffer.
+ */
+static void mixRampedMono(const Audio::MixKernel::Source& source,
+        float* output)
+{
+    using namespace Audio::SIMD;
+    const float gain = monoGain(source);
+    const float gainStep = monoGainStep(source);
+    Vector gainVector = ramp(gain, gainStep);
+    const Vector stepVector = fill(gainStep * size);
+    int i = 0;
+    for (; i <= source.numFrames - size; i += size)
+    {
+        store(output + i, multiplyAdd(load(output + i),
+                load(source.data + i), gainVector));
+        gainVector = add(gainVector, stepVector);
+    }
+    for (; i < source.numFrames; i++)
+    {
+        output[i] += source.data[i] * (gain + gainStep * i);
+    }
+}
+#endif
+
+
+// Adds a set of voices to a stereo mix.
+void Audio::MixKernel::mixStereo(const Source* sources, const int numSources,
+        float* left, float* right, const int numSamples)
+{
+    #if AUDIO_SIMD_NATIVE
+    using namespace SIMD;
+    for (int first = 0; first < numSources; first += maxPassSources)
+    {
+        // Sort the voices once per block, mixing voices that end or change
+        // gain partway through the block one at a time, and listing the rest
+        // for a single pass over the output:
+        const float* constantData[maxPassSources];
+        float leftGains[maxPassSources];
+        float rightGains[maxPassSources];
+        int numConstant = 0;
+        const int end = jmin(numSources, first + maxPassSources);
+        for (int s = first; s < end; s++)
+        {
+            const Source& source = sources[s];
+            if (isConstantBlock(source, numSamples))
+            {
+                constantData[numConstant] = source.data;
+                leftGains[numConstant] = source.leftGain;
+                rightGains[numConstant] = source.rightGain;
+                numConstant++;
+            }
+            else
+            {
+                mixRampedStereo(source, left, right);
+            }
+        }
+        int i = 0;
+        for (; i <= numSamples - size; i += size)
+        {
+            Vector leftSum = load(left + i);
+            Vector rightSum = load(right + i);
+            for (int s = 0; s < numConstant; s++)
+            {
+                const Vector input = load(constantData[s] + i);
+                leftSum = multiplyAdd(leftSum, input, fill(leftGains[s]));
+                rightSum = multiplyAdd(rightSum, input, fill(rightGains[s]));
+            }
+            store(left + i, leftSum);
+            store(right + i, rightSum);
+        }
+        for (; i < numSamples; i++)
+        {
+            for (int s = 0; s < numConstant; s++)
+            {
+                left[i] += constantData[s][i] * leftGains[s];
+                right[i] += constantData[s][i] * rightGains[s];
+            }
+        }
+    }
+    #else
+    mixStereoScalar(sources, numSources, left, right, numSamples);
+    #endif
+}
+
+
+// Adds a set of voices to a mono mix, using the average of each voice's
+// channel gains.
+void Audio::MixKernel::mixMono(const Source* sources, const int numSources,
+        float* output, const int numSamples)
+{
+    #if AUDIO_SIMD_NATIVE
+    using namespace SIMD;
+    for (int first = 0; first < numSources; first += maxPassSources)
+    {
+        // Sort the voices once per block, mixing voices that end or change
+        // gain partway through the block one at a time, and listing the rest
+        // for a single pass over the output:
+        const float* constantData[maxPassSources];
+        float gains[maxPassSources];
+        int numConstant = 0;
+        const int end = jmin(numSources, first + maxPassSources);
+        for (int s = first; s < end; s++)
+        {
+            const Source& source = sources[s];
+            if (isConstantBlock(source, numSamples))
+            {
+                constantData[numConstant] = source.data;
+                gains[numConstant] = monoGain(source);
+                numConstant++;
+            }
+            else
+            {
+                mixRampedMono(source, output);
+            }
+        }
+        int i = 0;
+        for (; i <= numSamples - size; i += size)
+        {
+            Vector sum = load(output + i);
+            for (int s = 0; s < numConstant; s++)
+            {
+                sum = multiplyAdd(sum, load(constantData[s] + i),
+                        fill(gains[s]));
+            }
+            store(output + i, sum);
+        }
+        for (; i < numSamples; i++)
+        {
+            for (int s = 0; s < numConstant; s++)
+            {
+                output[i] += constantData[s][i] * gains[s];
+            }
+        }
+    }
+    #else
+    mixMonoScalar(sources, numSources, output, numSamples);
+    #endif
+}
+
+
+// A non-vectorised version of mixStereo.
+void Audio::MixKernel::mixStereoScalar(const Source* sources,
+        const int numSources, float* left, float* right, const int numSamples)
+{
+    for (int s = 0; s < numSources; s++)
+    {
+        const Source& source = sources[s];
+        jassert(source.numFrames <= numSamples);
+        for (int i = 0; i < source.numFrames; i++)
+        {
+            left[i] += source.data[i]
+                    * (source.leftGain + source.leftGainStep * i);
+            right[i] += source.data[i]
+                    * (source.rightGain + source.rightGainStep * i);
+        }
+    }
+}
+
+
+// A non-vectorised version of mixMono.
+void Audio::MixKernel::mixMonoScalar(const Source* sources,
+        const int numSources, float* output, const int numSamples)
+{
+    for (int s = 0; s < numSources; s++)
+    {
+        const Source& source = sources[s];
+        jassert(source.numFrames <= numSamples);
+        const float gain = monoGain(source);
+        const float gainStep = monoGainStep(source);
+        for (int i = 0; i < source.numFrames; i++)
+        {
+            output[i] += source.data[i] * (gain + gainStep * i);
+        }
+    }
+}
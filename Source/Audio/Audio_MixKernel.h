@@ -0,0 +1,142 @@
+#pragma once
+/**
+ * @file  Audio_MixKernel.h
+ *
+ * @brief  Mixes many voices into an output buffer with per-voice gain and
+ *         pan.
+ */
+
+#include "JuceHeader.h"
+
+namespace Audio
+{
+    /**
+     * @brief  Vectorised functions that sum mono voice data into mono or
+     *         stereo mix buffers.
+     *
+     *  Voices that cover the whole output block at a constant gain are mixed
+     * in a single pass over the output, holding each group of output frames
+     * in SIMD registers while every voice is added to it. Voices are sorted
+     * once per block, so voices that end partway through the block or change
+     * gain within it are mixed separately, and the single pass never tests a
+     * voice. SSE is used on Intel processors and NEON
+     * on ARM processors. Other processors use the scalar versions, which are
+     * also always available for comparison.
+     *
+     *  None of these functions allocate memory or take locks, so they are
+     * safe to use on the audio thread.
+     */
+    namespace MixKernel
+    {
+        // The largest number of voices mixed in one pass over the output.
+        // Larger mixes take one pass for each group of this many voices:
+        static const constexpr int maxPassSources = 128;
+
+        /**
+         * @brief  One voice's contribution to a mix.
+         */
+        struct Source
+        {
+            // The voice's mono sample data for this block:
+            const float* data;
+            // The number of frames to mix, no more than the output size:
+            int numFrames;
+            // The gain applied when adding the voice to the left channel, or
+            // to the only channel of a mono mix:
+            float leftGain;
+            // The gain applied when adding the voice to the right channel:
+            float rightGain;
+            // The amount added to leftGain after each frame:
+            float leftGainStep;
+            // The amount added to rightGain after each frame:
+            float rightGainStep;
+        };
+
+        /**
+         * @brief  Gets the left and right channel gain of a panned voice.
+         *
+         *  Voices are panned by attenuating the opposite channel, so a
+         * centred voice plays at its full gain in both channels.
+         *
+         * @param gain       The voice's overall gain.
+         *
+         * @param pan        The voice's position, from -1 for hard left to 1
+         *                   for hard right.
+         *
+         * @param leftGain   Used to return the left channel gain.
+         *
+         * @param rightGain  Used to return the right channel gain.
+         */
+        void getPanGains(const float gain, const float pan, float& leftGain,
+                float& rightGain);
+
+        /**
+         * @brief  Checks if the mixing functions use SIMD instructions on
+         *         this processor.
+         *
+         * @return  Whether mixStereo and mixMono are vectorised.
+         */
+        bool isVectorised();
+
+        /**
+         * @brief  Adds a set of voices to a stereo mix.
+         *
+         * @param sources     The voices to add.
+         *
+         * @param numSources  The number of voices to add.
+         *
+         * @param left        The left channel of the mix.
+         *
+         * @param right       The right channel of the mix.
+         *
+         * @param numSamples  The number of frames in the mix buffer.
+         */
+        void mixStereo(const Source* sources, const int numSources,
+                float* left, float* right, const int numSamples);
+
+        /**
+         * @brief  Adds a set of voices to a mono mix, using the average of
+         *         each voice's channel gains.
+         *
+         * @param sources     The voices to add.
+         *
+         * @param numSources  The number of voices to add.
+         *
+         * @param output      The mix buffer.
+         *
+         * @param numSamples  The number of frames in the mix buffer.
+         */
+        void mixMono(const Source* sources, const int numSources,
+                float* output, const int numSamples);
+
+        /**
+         * @brief  A non-vectorised version of mixStereo.
+         *
+         * @param sources     The voices to add.
+         *
+         * @param numSources  The number of voices to add.
+         *
+         * @param left        The left channel of the mix.
+         *
+         * @param right       The right channel of the mix.
+         *
+         * @param numSamples  The number of frames in the mix buffer.
+         */
+        void mixStereoScalar(const Source* sources, const int numSources,
+                float* left, float* right, const int numSamples);
+
+        /**
+         * @brief  A non-vectorised version of mixMono.
+         *
+         * @param sources     The voices to add.
+         *
+         * @param numSources  The number of voices to add.
+         *
+         * @param output      The mix buffer.
+         *
+         * @param numSamples  The number of frames in the mix buffer.
+         */
+        void mixMonoScalar(const Source* sources, const int numSources,
+                float* output, const int numSamples);
+    }
+}
@@ -0,0 +1,410 @@
+#include "Audio_ModalSynth.h"
+#include "Audio_MixKernel.h"
+#include "Audio_SIMD.h"
+
+static_assert(Audio::ModalSynth::maxVoices % Audio::SIMD::size == 0,
+        "Voices must fill whole SIMD vectors");
+static_assert(Audio::SIMD::size == 4, "Partial sums assume four lanes");
+
+// Each mode's frequency relative to the fundamental, for a clamped-free bar:
+static const constexpr float modeRatios[] = { 1.0f, 6.267f, 17.55f, 34.39f };
+
+// Each mode's initial amplitude relative to the fundamental:
+static const constexpr float modeAmplitudes[] = { 1.0f, 0.3f, 0.1f, 0.04f };
+
+// The overall amplitude of a struck note, similar to the note samples:
+static const constexpr float strikeAmplitude = 0.25f;
+
+// The fundamental's decay time to -60dB at the reference frequency, in
+// seconds:
+static const constexpr double referenceDecaySeconds = 4.0;
+
+// The frequency where the fundamental decays in referenceDecaySeconds:
+static const constexpr double referenceFrequency = 440.0;
+
+// The shortest and longest fundamental decay times, in seconds:
+static const constexpr double minDecaySeconds = 0.5;
+static const constexpr double maxDecaySeconds = 8.0;
+
+// How much faster higher modes decay, as a power of their frequency ratio:
+static const constexpr double modeDecayExponent = 0.7;
+
+// Modes above this fraction of the sample rate are left out:
+static const constexpr double maxModeFrequency = 0.45;
+
+// The MIDI note numbers of the music box notes, in note order:
+static const constexpr int musicBoxNotes[] =
+{
+    68, 70, 72, 73, 75, 77, 79, 80, 82, 84, 85, 87, 89, 91, 92
+};
+
+// Creates a synth that plays the music box pitches, with no active voices.
+Audio::ModalSynth::ModalSynth() :
+cullThreshold(Decibels::decibelsToGain(VoicePool::defaultCullThresholdDb))
+{
+    zeromem(output1, sizeof(output1));
+    zeromem(output2, sizeof(output2));
+    zeromem(feedback1, sizeof(feedback1));
+    zeromem(feedback2, sizeof(feedback2));
+    zeromem(levelScale, sizeof(levelScale));
+    zeromem(leftGains, sizeof(leftGains));
+    zeromem(rightGains, sizeof(rightGains));
+    zeromem(leftGainSteps, sizeof(leftGainSteps));
+    zeromem(rightGainSteps, sizeof(rightGainSteps));
+    releaseFrames = roundToInt(VoicePool::releaseSeconds * sampleRate);
+    setPitches(getMusicBoxPitches());
+}
+
+
+// Gets the pitches of a 15 note music box, matching the built-in note
+// samples.
+Array<double> Audio::ModalSynth::getMusicBoxPitches()
+{
+    Array<double> frequencies;
+    for (const int& midiNote : musicBoxNotes)
+    {
+        frequencies.add(MidiMessage::getMidiNoteInHertz(midiNote));
+    }
+    return frequencies;
+}
+
+
+// Sets the pitch of every note.
+void Audio::ModalSynth::setPitches(const Array<double>& frequencies)
+{
+    numNotes = jmin(frequencies.size(), maxNotes);
+    for (int i = 0; i < numNotes; i++)
+    {
+        pitches[i] = frequencies[i];
+    }
+    updateNoteModels();
+}
+
+
+// Gets the number of notes that can be played.
+int Audio::ModalSynth::getNumNotes() const
+{
+    return numNotes;
+}
+
+
+// Sets the output sample rate, updating the model of every note.
+void Audio::ModalSynth::setSampleRate(const double sampleRate)
+{
+    jassert(sampleRate > 0);
+    this->sampleRate = sampleRate;
+    releaseFrames = roundToInt(VoicePool::releaseSeconds * sampleRate);
+    updateNoteModels();
+}
+
+
+// Sets the maximum number of notes that may play at once.
+void Audio::ModalSynth::setPolyphony(const int polyphony)
+{
+    this->polyphony = jlimit(1, VoicePool::maxPolyphony, polyphony);
+}
+
+
+// Sets the level below which voices are stopped early.
+void Audio::ModalSynth::setCullThreshold(const float threshold)
+{
+    cullThreshold = jmax(0.0f, threshold);
+}
+
+
+// Strikes a note, releasing the oldest voice first if the polyphony limit has
+// been reached.
+void Audio::ModalSynth::startNote(const int note, const float gain,
+        const float pan)
+{
+    if (note < 0 || note >= numNotes)
+    {
+        return;
+    }
+    int oldestPlaying = -1;
+    int oldestReleasing = -1;
+    int numPlaying = 0;
+    for (int v = 0; v < numActive; v++)
+    {
+        int& oldest = (releaseFramesLeft[v] > 0) ? oldestReleasing
+                : oldestPlaying;
+        if (oldest < 0 || startOrder[v] - startOrder[oldest] > (1u << 31))
+        {
+            oldest = v;
+        }
+        if (releaseFramesLeft[v] == 0)
+        {
+            numPlaying++;
+        }
+    }
+    if (numPlaying >= polyphony && oldestPlaying >= 0)
+    {
+        releaseVoice(oldestPlaying);
+        if (releaseFramesLeft[oldestPlaying] == 0)
+        {
+            removeVoice(oldestPlaying);
+        }
+    }
+    if (numActive == maxVoices)
+    {
+        // Every release voice is still fading, so cut off the oldest fade:
+        removeVoice(oldestReleasing >= 0 ? oldestReleasing : 0);
+    }
+    const int voice = numActive++;
+    const NoteModel& model = notes[note];
+    for (int m = 0; m < modesPerVoice; m++)
+    {
+        output1[m][voice] = 0.0f;
+        output2[m][voice] = model.strike[m];
+        feedback1[m][voice] = model.feedback1[m];
+        feedback2[m][voice] = model.feedback2[m];
+        levelScale[m][voice] = model.levelScale[m];
+    }
+    MixKernel::getPanGains(gain, pan, leftGains[voice], rightGains[voice]);
+    leftGainSteps[voice] = 0.0f;
+    rightGainSteps[voice] = 0.0f;
+    releaseFramesLeft[voice] = 0;
+    startOrder[voice] = nextStartOrder++;
+}
+
+
+// Immediately stops all active voices.
+void Audio::ModalSynth::stopAllNotes()
+{
+    while (numActive > 0)
+    {
+        removeVoice(numActive - 1);
+    }
+}
+
+
+// Gets the number of voices that are currently playing.
+int Audio::ModalSynth::getActiveVoiceCount() const
+{
+    return numActive;
+}
+
+
+// Gets the amount of memory used by the synth.
+size_t Audio::ModalSynth::getMemorySize() const
+{
+    return sizeof(ModalSynth);
+}
+
+
+// Adds the next block of output from all active voices to a mix buffer, and
+// stops any voices that finish.
+void Audio::ModalSynth::renderNextBlock(float* left, float* right,
+        const int numSamples)
+{
+    // Decaying resonators would otherwise spend a long time on denormals:
+    const ScopedNoDenormals noDenormals;
+    for (int start = 0; start < numSamples && numActive > 0;
+            start += maxSectionFrames)
+    {
+        renderSection(left + start, (right == nullptr) ? nullptr
+                : right + start, jmin(maxSectionFrames, numSamples - start));
+    }
+}
+
+
+// Adds a section of output from all active voices to a mix buffer, and stops
+// any voices that finish.
+void Audio::ModalSynth::renderSection(float* left, float* right,
+        const int numSamples)
+{
+    using namespace SIMD;
+    zeromem(leftSums, sizeof(float) * (size_t) (numSamples * size));
+    zeromem(rightSums, sizeof(float) * (size_t) (numSamples * size));
+    const Vector zero = fill(0.0f);
+    // Each group of four voices keeps its state in registers while the whole
+    // section is rendered, adding each frame to that frame's partial sums:
+    for (int first = 0; first < numActive; first += size)
+    {
+        Vector last[modesPerVoice];
+        Vector beforeLast[modesPerVoice];
+        Vector coefficient1[modesPerVoice];
+        Vector coefficient2[modesPerVoice];
+        for (int m = 0; m < modesPerVoice; m++)
+        {
+            last[m] = load(output1[m] + first);
+            beforeLast[m] = load(output2[m] + first);
+            coefficient1[m] = load(feedback1[m] + first);
+            coefficient2[m] = load(feedback2[m] + first);
+        }
+        Vector leftGain = load(leftGains + first);
+        Vector rightGain = load(rightGains + first);
+        const Vector leftStep = load(leftGainSteps + first);
+        const Vector rightStep = load(rightGainSteps + first);
+        for (int i = 0; i < numSamples; i++)
+        {
+            Vector voiceOutput = zero;
+            for (int m = 0; m < modesPerVoice; m++)
+            {
+                const Vector next = subtract(
+                        multiply(coefficient1[m], last[m]),
+                        multiply(coefficient2[m], beforeLast[m]));
+                beforeLast[m] = last[m];
+                last[m] = next;
+                voiceOutput = add(voiceOutput, next);
+            }
+            float* leftSum = leftSums + i * size;
+            float* rightSum = rightSums + i * size;
+            store(leftSum, multiplyAdd(load(leftSum), voiceOutput, leftGain));
+            store(rightSum, multiplyAdd(load(rightSum), voiceOutput,
+                    rightGain));
+            // Releasing voices stop fading at silence:
+            leftGain = max(add(leftGain, leftStep), zero);
+            rightGain = max(add(rightGain, rightStep), zero);
+        }
+        for (int m = 0; m < modesPerVoice; m++)
+        {
+            store(output1[m] + first, last[m]);
+            store(output2[m] + first, beforeLast[m]);
+        }
+        store(leftGains + first, leftGain);
+        store(rightGains + first, rightGain);
+    }
+    if (right == nullptr)
+    {
+        for (int i = 0; i < numSamples; i++)
+        {
+            left[i] += (sum(load(leftSums + i * size))
+                    + sum(load(rightSums + i * size))) * 0.5f;
+        }
+    }
+    else
+    {
+        for (int i = 0; i < numSamples; i++)
+        {
+            left[i] += sum(load(leftSums + i * size));
+            right[i] += sum(load(rightSums + i * size));
+        }
+    }
+
+    // Stop voices that finished releasing, or decayed to silence or below
+    // the threshold:
+    for (int v = numActive - 1; v >= 0; v--)
+    {
+        if (releaseFramesLeft[v] > 0)
+        {
+            releaseFramesLeft[v] = jmax(0, releaseFramesLeft[v] - numSamples);
+            if (releaseFramesLeft[v] == 0)
+            {
+                removeVoice(v);
+            }
+        }
+        else if (getVoiceLevel(v) <= cullThreshold)
+        {
+            removeVoice(v);
+        }
+    }
+}
+
+
+// Recalculates the resonator coefficients of every note.
+void Audio::ModalSynth::updateNoteModels()
+{
+    for (int i = 0; i < numNotes; i++)
+    {
+        NoteModel& model = notes[i];
+        // Lower tines are longer, and ring for longer:
+        const double decaySeconds = jlimit(minDecaySeconds, maxDecaySeconds,
+                referenceDecaySeconds
+                * std::sqrt(referenceFrequency / pitches[i]));
+        for (int m = 0; m < modesPerVoice; m++)
+        {
+            const double frequency = pitches[i] * modeRatios[m];
+            if (frequency >= sampleRate * maxModeFrequency)
+            {
+                // Silent modes never ring, and are never counted as audible:
+                model.feedback1[m] = 0.0f;
+                model.feedback2[m] = 0.0f;
+                model.strike[m] = 0.0f;
+                model.levelScale[m] = 0.0f;
+                continue;
+            }
+            const double modeDecay = decaySeconds
+                    / std::pow((double) modeRatios[m], modeDecayExponent);
+            // The pole radius that decays by 60dB over modeDecay seconds:
+            const double radius = std::exp(std::log(0.001)
+                    / (modeDecay * sampleRate));
+            const double angle = MathConstants<double>::twoPi * frequency
+                    / sampleRate;
+            model.feedback1[m] = (float) (2.0 * radius * std::cos(angle));
+            model.feedback2[m] = (float) (radius * radius);
+            // With the last output at zero, this makes the resonator output
+            // amplitude * r^n * sin(angle * (n + 1)), so each note starts at
+            // a zero crossing:
+            model.strike[m] = (float) (-strikeAmplitude * modeAmplitudes[m]
+                    * std::sin(angle) / (radius * radius));
+            model.levelScale[m] = (float) (1.0 / std::sin(angle));
+        }
+    }
+}
+
+
+// Starts fading out a voice.
+void Audio::ModalSynth::releaseVoice(const int voice)
+{
+    jassert(voice >= 0 && voice < numActive);
+    if (releaseFrames <= 0)
+    {
+        removeVoice(voice);
+        return;
+    }
+    releaseFramesLeft[voice] = releaseFrames;
+    leftGainSteps[voice] = -leftGains[voice] / releaseFrames;
+    rightGainSteps[voice] = -rightGains[voice] / releaseFrames;
+}
+
+
+// Stops a voice, moving the last active voice into its place so active voices
+// stay packed at the start of each array.
+void Audio::ModalSynth::removeVoice(const int voice)
+{
+    jassert(voice >= 0 && voice < numActive);
+    const int last = --numActive;
+    for (int m = 0; m < modesPerVoice; m++)
+    {
+        output1[m][voice] = output1[m][last];
+        output2[m][voice] = output2[m][last];
+        feedback1[m][voice] = feedback1[m][last];
+        feedback2[m][voice] = feedback2[m][last];
+        levelScale[m][voice] = levelScale[m][last];
+        // Unused lanes must stay silent when their group is rendered:
+        output1[m][last] = 0.0f;
+        output2[m][last] = 0.0f;
+        feedback1[m][last] = 0.0f;
+        feedback2[m][last] = 0.0f;
+    }
+    leftGains[voice] = leftGains[last];
+    rightGains[voice] = rightGains[last];
+    leftGainSteps[voice] = leftGainSteps[last];
+    rightGainSteps[voice] = rightGainSteps[last];
+    releaseFramesLeft[voice] = releaseFramesLeft[last];
+    startOrder[voice] = startOrder[last];
+    leftGains[last] = 0.0f;
+    rightGains[last] = 0.0f;
+    leftGainSteps[last] = 0.0f;
+    rightGainSteps[last] = 0.0f;
+}
+
+
+// Estimates the peak level a voice will reach from now on.
+float Audio::ModalSynth::getVoiceLevel(const int voice) const
+{
+    // A decaying resonator's amplitude follows from its last two outputs:
+    // y1^2 - a1 * y1 * y2 + a2 * y2^2 = (amplitude * sin(w))^2
+    float level = 0.0f;
+    for (int m = 0; m < modesPerVoice; m++)
+    {
+        const float last = output1[m][voice];
+        const float beforeLast = output2[m][voice];
+        const float energy = last * last
+                - feedback1[m][voice] * last * beforeLast
+                + feedback2[m][voice] * beforeLast * beforeLast;
+        level += std::sqrt(jmax(0.0f, energy)) * levelScale[m][voice];
+    }
+    return level * jmax(leftGains[voice], rightGains[voice]);
+}
@@ -0,0 +1,253 @@
+#pragma once
+/**
+ * @file  Audio_ModalSynth.h
+ *
+ * @brief  Synthesizes music box notes from a physical model of each tine.
+ */
+
+#include "JuceHeader.h"
+#include "Audio_VoicePool.h"
+
+namespace Audio { class ModalSynth; }
+
+/**
+ * @brief  Plays notes by modelling each struck tine as a small set of damped
+ *         modal oscillators, so no sample data is needed.
+ *
+ *  Each tine is modelled as a clamped cantilever bar, which vibrates at its
+ * fundamental and at a few inharmonic overtones. Every mode is a two-pole
+ * resonator that rings and decays once struck, with higher modes decaying
+ * faster, as they do on a real tine. Modes above the Nyquist frequency are
+ * left out. Any set of pitches may be played, so music boxes with other
+ * scales or note counts need no new samples.
+ *
+ *  Voice state is stored with each mode of every voice in its own array, so
+ * four voices are processed at once in each SIMD vector. Like the VoicePool,
+ * the synth has a polyphony limit, fades out stolen voices, and culls voices
+ * once they decay below the cull threshold. It never allocates memory after
+ * construction, and should only be used on the audio thread or while the
+ * audio device is stopped.
+ */
+class Audio::ModalSynth
+{
+public:
+    // The number of modes modelled for each tine:
+    static const constexpr int modesPerVoice = 4;
+    // The total number of voices, including voices fading out:
+    static const constexpr int maxVoices = VoicePool::maxVoices;
+    // The largest number of distinct note pitches:
+    static const constexpr int maxNotes = 128;
+
+    ModalSynth();
+
+    virtual ~ModalSynth() { }
+
+    /**
+     * @brief  Gets the pitches of a 15 note music box, matching the built-in
+     *         note samples.
+     *
+     * @return  Each note's fundamental frequency in Hz, in note order.
+     */
+    static juce::Array<double> getMusicBoxPitches();
+
+    /**
+     * @brief  Sets the pitch of every note. Playing voices keep their pitch.
+     *
+     * @param frequencies  Each note's fundamental frequency in Hz, in note
+     *                     order. Only the first maxNotes are used.
+     */
+    void setPitches(const juce::Array<double>& frequencies);
+
+    /**
+     * @brief  Gets the number of notes that can be played.
+     *
+     * @return  The number of note pitches.
+     */
+    int getNumNotes() const;
+
+    /**
+     * @brief  Sets the output sample rate, updating the model of every note.
+     *
+     * @param sampleRate  The output sample rate.
+     */
+    void setSampleRate(const double sampleRate);
+
+    /**
+     * @brief  Sets the maximum number of notes that may play at once.
+     *
+     * @param polyphony  The new limit, which will be clamped between one and
+     *                   VoicePool::maxPolyphony.
+     */
+    void setPolyphony(const int polyphony);
+
+    /**
+     * @brief  Sets the level below which voices are stopped early.
+     *
+     * @param threshold  The cull threshold as a linear gain, or zero to never
+     *                   cull voices.
+     */
+    void setCullThreshold(const float threshold);
+
+    /**
+     * @brief  Strikes a note, releasing the oldest voice first if the
+     *         polyphony limit has been reached.
+     *
+     * @param note  The index of the played note.
+     *
+     * @param gain  The gain applied to the note.
+     *
+     * @param pan   The note's stereo position, from -1 for hard left to 1 for
+     *              hard right.
+     */
+    void startNote(const int note, const float gain = 1.0f,
+            const float pan = 0.0f);
+
+    /**
+     * @brief  Immediately stops all active voices.
+     */
+    void stopAllNotes();
+
+    /**
+     * @brief  Gets the number of voices that are currently playing.
+     *
+     * @return  The number of active voices, including voices fading out.
+     */
+    int getActiveVoiceCount() const;
+
+    /**
+     * @brief  Gets the amount of memory used by the synth.
+     *
+     * @return  The size of all note models and voice state in bytes.
+     */
+    size_t getMemorySize() const;
+
+    /**
+     * @brief  Adds the next block of output from all active voices to a mix
+     *         buffer, and stops any voices that finish.
+     *
+     * @param left        The start of the section of the left or mono mix
+     *                    channel where voice output is added.
+     *
+     * @param right       The start of the section of the right mix channel
+     *                    where voice output is added, or nullptr to create a
+     *                    mono mix.
+     *
+     * @param numSamples  The number of frames to write.
+     */
+    void renderNextBlock(float* left, float* right, const int numSamples);
+
+private:
+    // The largest number of frames rendered in one section:
+    static const constexpr int maxSectionFrames = 256;
+
+    /**
+     * @brief  Adds a section of output from all active voices to a mix
+     *         buffer, and stops any voices that finish.
+     *
+     * @param left        The start of the left or mono mix section.
+     *
+     * @param right       The start of the right mix section, or nullptr to
+     *                    create a mono mix.
+     *
+     * @param numSamples  The number of frames to write, no more than
+     *                    maxSectionFrames.
+     */
+    void renderSection(float* left, float* right, const int numSamples);
+
+    /**
+     * @brief  Recalculates the resonator coefficients of every note.
+     */
+    void updateNoteModels();
+
+    /**
+     * @brief  Starts fading out a voice.
+     *
+     * @param voice  The index of an active voice.
+     */
+    void releaseVoice(const int voice);
+
+    /**
+     * @brief  Stops a voice, moving the last active voice into its place so
+     *         active voices stay packed at the start of each array.
+     *
+     * @param voice  The index of an active voice.
+     */
+    void removeVoice(const int voice);
+
+    /**
+     * @brief  Estimates the peak level a voice will reach from now on.
+     *
+     * @param voice  The index of an active voice.
+     *
+     * @return       The sum of the amplitudes of the voice's modes, scaled by
+     *               its channel gain.
+     */
+    float getVoiceLevel(const int voice) const;
+
+    /**
+     * @brief  The resonator settings of every mode of a single note.
+     */
+    struct NoteModel
+    {
+        // The first feedback coefficient, 2r * cos(w):
+        float feedback1[modesPerVoice];
+        // The second feedback coefficient, r * r:
+        float feedback2[modesPerVoice];
+        // The delayed output that starts the mode ringing at its amplitude:
+        float strike[modesPerVoice];
+        // 1 / sin(w), which converts resonator energy to amplitude:
+        float levelScale[modesPerVoice];
+    };
+
+    // The fundamental frequency of each note:
+    double pitches[maxNotes];
+    // The resonator settings of each note:
+    NoteModel notes[maxNotes];
+    // The number of valid notes:
+    int numNotes = 0;
+    // The output sample rate:
+    double sampleRate = 44100.0;
+
+    // Voice state, with one array for each mode holding every voice's value.
+    // Only the first numActive voices are active, and the rest are zero.
+    // The resonator's last output:
+    alignas(16) float output1[modesPerVoice][maxVoices];
+    // The resonator's output before that:
+    alignas(16) float output2[modesPerVoice][maxVoices];
+    // The resonator's first feedback coefficient:
+    alignas(16) float feedback1[modesPerVoice][maxVoices];
+    // The resonator's second feedback coefficient:
+    alignas(16) float feedback2[modesPerVoice][maxVoices];
+    // Converts resonator energy to amplitude:
+    alignas(16) float levelScale[modesPerVoice][maxVoices];
+    // The gain applied to each voice's left channel:
+    alignas(16) float leftGains[maxVoices];
+    // The gain applied to each voice's right channel:
+    alignas(16) float rightGains[maxVoices];
+    // The per-frame change in left gain while a voice is releasing:
+    alignas(16) float leftGainSteps[maxVoices];
+    // The per-frame change in right gain while a voice is releasing:
+    alignas(16) float rightGainSteps[maxVoices];
+    // Frames left in each voice's release, or zero if it isn't releasing:
+    int releaseFramesLeft[maxVoices];
+    // The order each voice started in, used to find the oldest voice:
+    juce::uint32 startOrder[maxVoices];
+    // The number of active voices:
+    int numActive = 0;
+    // The start order given to the next voice:
+    juce::uint32 nextStartOrder = 0;
+
+    // Partial sums of each output frame, one for each SIMD lane:
+    alignas(16) float leftSums[maxSectionFrames * 4];
+    // Partial sums of each right channel output frame:
+    alignas(16) float rightSums[maxSectionFrames * 4];
+
+    // The maximum number of voices that may play without releasing:
+    int polyphony = VoicePool::defaultPolyphony;
+    // The length of the fade applied to stolen voices, in frames:
+    int releaseFrames = 0;
+    // Voices are culled once they can't rise above this level:
+    float cullThreshold;
+
+    JUCE_DECLARE_NON_COPYABLE(ModalSynth)
+};
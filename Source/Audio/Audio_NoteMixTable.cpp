@@ -0,0 +1,100 @@
+#include "Audio_NoteMixTable.h"
+
+// Creates a table with every note at full gain, spread across the stereo
+// field.
+Audio::NoteMixTable::NoteMixTable(const int numNotes) :
+numNotes(jlimit(0, maxNotes, numNotes))
+{
+    jassert(numNotes >= 0 && numNotes <= maxNotes);
+    for (float& gain : gains)
+    {
+        gain = 1.0f;
+    }
+    setSpread(defaultSpread);
+}
+
+
+// Gets the number of notes in the table.
+int Audio::NoteMixTable::getNumNotes() const
+{
+    return numNotes;
+}
+
+
+// Changes the number of notes, spreading them across the stereo field again.
+void Audio::NoteMixTable::setNumNotes(const int newNumNotes)
+{
+    jassert(newNumNotes >= 0 && newNumNotes <= maxNotes);
+    numNotes = jlimit(0, maxNotes, newNumNotes);
+    setSpread(defaultSpread);
+}
+
+
+// Spreads all notes evenly across the stereo field.
+void Audio::NoteMixTable::setSpread(const float spread)
+{
+    const float clippedSpread = jlimit(0.0f, 1.0f, spread);
+    for (int i = 0; i < maxNotes; i++)
+    {
+        pans[i] = (i >= numNotes || numNotes < 2) ? 0.0f
+                : clippedSpread * (i * 2.0f / (numNotes - 1) - 1.0f);
+    }
+}
+
+
+// Sets a note's stereo position.
+void Audio::NoteMixTable::setPan(const int note, const float pan)
+{
+    jassert(note >= 0 && note < maxNotes);
+    if (note >= 0 && note < maxNotes)
+    {
+        pans[note] = jlimit(-1.0f, 1.0f, pan);
+    }
+}
+
+
+// Gets a note's stereo position, before the stereo width is applied.
+float Audio::NoteMixTable::getPan(const int note) const
+{
+    return (note >= 0 && note < maxNotes) ? pans[note] : 0.0f;
+}
+
+
+// Sets a note's gain.
+void Audio::NoteMixTable::setGain(const int note, const float gain)
+{
+    jassert(note >= 0 && note < maxNotes);
+    if (note >= 0 && note < maxNotes)
+    {
+        gains[note] = jmax(0.0f, gain);
+    }
+}
+
+
+// Gets a note's gain.
+float Audio::NoteMixTable::getGain(const int note) const
+{
+    return (note >= 0 && note < maxNotes) ? gains[note] : 1.0f;
+}
+
+
+// Sets how widely notes are spread across the stereo field.
+void Audio::NoteMixTable::setWidth(const float newWidth)
+{
+    width = jlimit(0.0f, maxWidth, newWidth);
+}
+
+
+// Gets how widely notes are spread across the stereo field.
+float Audio::NoteMixTable::getWidth() const
+{
+    return width;
+}
+
+
+// Gets the stereo position a note starts with, after applying the stereo
+// width.
+float Audio::NoteMixTable::getMixedPan(const int note) const
+{
+    return jlimit(-1.0f, 1.0f, getPan(note) * width);
+}
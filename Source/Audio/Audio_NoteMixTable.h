@@ -0,0 +1,153 @@
+#pragma once
+/**
+ * @file  Audio_NoteMixTable.h
+ *
+ * @brief  Stores where each note is placed in the output mix.
+ */
+
+#include "JuceHeader.h"
+
+namespace Audio { class NoteMixTable; }
+
+/**
+ * @brief  Holds the stereo position and gain of every note, and a stereo
+ *         width that scales all positions together.
+ *
+ *  By default, notes are spread from the lowest note on the left to the
+ * highest note on the right, the way a listener in front of the comb hears
+ * them. Each note's position and gain may then be changed individually.
+ * Space for maxNotes is always held, so changing the number of notes never
+ * allocates, and notes may be set before a kit that plays them is loaded.
+ *
+ *  The table only chooses the channel gains each note starts with. Engines
+ * pass those gains to the mix kernel along with the rest of the voice, so
+ * panning happens in the same vectorised pass that mixes every voice, with no
+ * extra buffer traversal or per-sample work. Changes apply to notes started
+ * after the change.
+ *
+ *  Tables are small value objects, so they may be freely copied. A table
+ * should only be used by one thread at a time.
+ */
+class Audio::NoteMixTable
+{
+public:
+    // The largest number of notes a table may hold:
+    static const constexpr int maxNotes = 128;
+    // How far the lowest and highest notes are panned from the centre by
+    // default:
+    static const constexpr float defaultSpread = 0.6f;
+    // The widest allowed stereo width:
+    static const constexpr float maxWidth = 2.0f;
+
+    /**
+     * @brief  Creates a table with the default spread and unit gain for every
+     *         note, at full stereo width.
+     *
+     * @param numNotes  The number of notes spread across the stereo field, no
+     *                  more than maxNotes.
+     */
+    NoteMixTable(const int numNotes);
+
+    virtual ~NoteMixTable() { }
+
+    /**
+     * @brief  Gets the number of notes in the table.
+     *
+     * @return  The number of notes spread across the stereo field.
+     */
+    int getNumNotes() const;
+
+    /**
+     * @brief  Changes the number of notes, spreading them across the stereo
+     *         field again with the default spread. Note gains and the stereo
+     *         width are kept.
+     *
+     * @param newNumNotes  The new number of notes, no more than maxNotes.
+     */
+    void setNumNotes(const int newNumNotes);
+
+    /**
+     * @brief  Spreads all notes evenly across the stereo field, from the
+     *         lowest note on the left to the highest note on the right.
+     *
+     * @param spread  How far the lowest and highest notes are panned from the
+     *                centre, from 0 to 1.
+     */
+    void setSpread(const float spread);
+
+    /**
+     * @brief  Sets a note's stereo position.
+     *
+     * @param note  The index of a note, below maxNotes.
+     *
+     * @param pan   The note's position, from -1 for hard left to 1 for hard
+     *              right.
+     */
+    void setPan(const int note, const float pan);
+
+    /**
+     * @brief  Gets a note's stereo position, before the stereo width is
+     *         applied.
+     *
+     * @param note  The index of a note in the table.
+     *
+     * @return      The note's position from -1 to 1, or zero for notes
+     *              outside the table.
+     */
+    float getPan(const int note) const;
+
+    /**
+     * @brief  Sets a note's gain.
+     *
+     * @param note  The index of a note, below maxNotes.
+     *
+     * @param gain  The note's linear gain, zero or above.
+     */
+    void setGain(const int note, const float gain);
+
+    /**
+     * @brief  Gets a note's gain.
+     *
+     * @param note  The index of a note in the table.
+     *
+     * @return      The note's linear gain, or one for notes outside the
+     *              table.
+     */
+    float getGain(const int note) const;
+
+    /**
+     * @brief  Sets how widely notes are spread across the stereo field.
+     *
+     * @param newWidth  The multiplier applied to every note's position, from
+     *                  0 for mono to maxWidth. Positions pushed past either
+     *                  side are held at that side.
+     */
+    void setWidth(const float newWidth);
+
+    /**
+     * @brief  Gets how widely notes are spread across the stereo field.
+     *
+     * @return  The multiplier applied to every note's position.
+     */
+    float getWidth() const;
+
+    /**
+     * @brief  Gets the stereo position a note starts with, after applying
+     *         the stereo width.
+     *
+     * @param note  The index of a note in the table.
+     *
+     * @return      The note's position, from -1 to 1.
+     */
+    float getMixedPan(const int note) const;
+
+private:
+    // The number of notes spread across the stereo field:
+    int numNotes;
+    // Each note's position before the stereo width is applied:
+    float pans[maxNotes];
+    // Each note's linear gain:
+    float gains[maxNotes];
+    // The multiplier applied to every note's position:
+    float width = 1.0f;
+};
@@ -0,0 +1,330 @@
+#include "Audio_OfflineRenderer.h"
+
+// The number of frames rendered and written at a time:
+static const constexpr int blockSize = 8192;
+
+// Creates a renderer that plays notes from a sample bank.
+Audio::OfflineRenderer::OfflineRenderer(SampleBank::Ptr sampleBank) :
+sampleBank(sampleBank),
+noteMix(sampleBank->getNumNotes()),
+renderBuffer(1, blockSize),
+silence((size_t) blockSize, true)
+{
+    jassert(sampleBank != nullptr);
+    voicePool.setSampleRate(sampleBank->getSampleRate());
+    limiter.prepare(sampleBank->getSampleRate());
+    if (sampleBank->isStreamed())
+    {
+        voicePool.allocateStreams();
+    }
+}
+
+
+/**
+ * @brief  Creates a writer for a temporary audio file.
+ *
+ * @param tempFile    The temporary file that will replace the output file once
+ *                    writing finishes. Its target file's extension selects the
+ *                    output format, which must be .wav or .flac.
+ *
+ * @param sampleRate  The sample rate of the written audio.
+ *
+ * @param writer      Used to return the new writer.
+ *
+ * @return            Whether the writer was created, or the reason it wasn't.
+ */
+static Result createWriter(const TemporaryFile& tempFile,
+        const double sampleRate, std::unique_ptr<AudioFormatWriter>& writer)
+{
+    const File& outputFile = tempFile.getTargetFile();
+    std::unique_ptr<AudioFormat> format;
+    if (outputFile.hasFileExtension(".wav"))
+    {
+        format.reset(new WavAudioFormat());
+    }
+    else if (outputFile.hasFileExtension(".flac"))
+    {
+        format.reset(new FlacAudioFormat());
+    }
+    else
+    {
+        return Result::fail("Unsupported output format for "
+                + outputFile.getFileName());
+    }
+    std::unique_ptr<OutputStream> outputStream
+            (tempFile.getFile().createOutputStream());
+    if (outputStream == nullptr)
+    {
+        return Result::fail("Couldn't write to "
+                + outputFile.getFullPathName());
+    }
+    writer.reset(format->createWriterFor(outputStream.get(), sampleRate, 1,
+            Audio::OfflineRenderer::outputBitDepth, StringPairArray(), 0));
+    if (writer == nullptr)
+    {
+        return Result::fail("Couldn't create a " + format->getFormatName()
+                + " writer");
+    }
+    // The writer now owns the stream:
+    outputStream.release();
+    return Result::ok();
+}
+
+
+/**
+ * @brief  Closes a finished audio file writer, and replaces its target file
+ *         with the written file.
+ *
+ * @param tempFile  The temporary file that was written.
+ *
+ * @param writer    The writer used to write the file, which will be deleted.
+ *
+ * @return          Whether the target file was replaced, or the reason it
+ *                  wasn't.
+ */
+static Result finishWriting(const TemporaryFile& tempFile,
+        std::unique_ptr<AudioFormatWriter>& writer)
+{
+    writer = nullptr;
+    if (! tempFile.overwriteTargetFileWithTemporary())
+    {
+        return Result::fail("Couldn't replace "
+                + tempFile.getTargetFile().getFullPathName());
+    }
+    return Result::ok();
+}
+
+
+// Turns output limiting on or off.
+void Audio::OfflineRenderer::setLimiting(const bool enabled)
+{
+    limiting = enabled;
+}
+
+
+// Sets the gain and stereo position of each note.
+void Audio::OfflineRenderer::setNoteMix(const NoteMixTable& table)
+{
+    noteMix = table;
+}
+
+
+// Renders a song to an audio file, replacing any existing file.
+Result Audio::OfflineRenderer::renderToFile(EventList::Ptr eventList,
+        const int bpm, const File& outputFile)
+{
+    // Write to a temporary file, so cancelled or failed renders never leave
+    // a partial output file:
+    TemporaryFile tempFile(outputFile);
+    std::unique_ptr<AudioFormatWriter> writer;
+    const Result writerCreated = createWriter(tempFile,
+            sampleBank->getSampleRate(), writer);
+    if (writerCreated.failed())
+    {
+        return writerCreated;
+    }
+    bool writeFailed = false;
+    const bool rendered = renderSong(eventList, bpm,
+            [&writer, &writeFailed](const float* block, const int numSamples)
+            {
+                writeFailed = ! writer->writeFromFloatArrays(&block, 1,
+                        numSamples);
+                return ! writeFailed;
+            });
+    if (! rendered)
+    {
+        return Result::fail(writeFailed
+                ? "Failed writing to " + outputFile.getFullPathName()
+                : "Render cancelled");
+    }
+    return finishWriting(tempFile, writer);
+}
+
+
+// Renders a song into an audio buffer.
+bool Audio::OfflineRenderer::renderToBuffer(EventList::Ptr eventList,
+        const int bpm, AudioBuffer<float>& output)
+{
+    int numRendered = 0;
+    output.setSize(1, blockSize, false, false, true);
+    const bool rendered = renderSong(eventList, bpm,
+            [&output, &numRendered](const float* block, const int numSamples)
+            {
+                if (numRendered + numSamples > output.getNumSamples())
+                {
+                    output.setSize(1, jmax(numRendered + numSamples,
+                            output.getNumSamples() * 2), true, false, true);
+                }
+                output.copyFrom(0, numRendered, block, numSamples);
+                numRendered += numSamples;
+                return true;
+            });
+    output.setSize(1, rendered ? numRendered : 0, true, false, true);
+    return rendered;
+}
+
+
+// Writes mono audio to a file, replacing any existing file.
+Result Audio::OfflineRenderer::writeToFile(const AudioBuffer<float>& audio,
+        const double sampleRate, const File& outputFile)
+{
+    jassert(audio.getNumChannels() == 1);
+    TemporaryFile tempFile(outputFile);
+    std::unique_ptr<AudioFormatWriter> writer;
+    const Result writerCreated = createWriter(tempFile, sampleRate, writer);
+    if (writerCreated.failed())
+    {
+        return writerCreated;
+    }
+    if (! writer->writeFromAudioSampleBuffer(audio, 0, audio.getNumSamples()))
+    {
+        return Result::fail("Failed writing to "
+                + outputFile.getFullPathName());
+    }
+    return finishWriting(tempFile, writer);
+}
+
+
+// Gets the progress of the current or most recent render.
+double Audio::OfflineRenderer::getProgress() const
+{
+    return progress.load();
+}
+
+
+// Stops the current render as soon as possible.
+void Audio::OfflineRenderer::cancel()
+{
+    cancelled = true;
+}
+
+
+// Renders a song one block at a time, passing each block on to be stored.
+bool Audio::OfflineRenderer::renderSong(EventList::Ptr eventList,
+        const int bpm, const BlockHandler& handleBlock)
+{
+    jassert(eventList != nullptr && bpm > 0);
+    // A cancel request made before the render started still stops it, so
+    // the request is only cleared once the render ends:
+    progress = 0;
+    // The song ends once its last note finishes ringing, so the total length
+    // is estimated using the longest sample:
+    const double samplesPerBeat = Sequencer::samplesPerBeat(bpm,
+            sampleBank->getSampleRate());
+    int longestSample = 0;
+    for (int i = 0; i < sampleBank->getNumNotes(); i++)
+    {
+        longestSample = jmax(longestSample, sampleBank->getSampleLength(i));
+    }
+    const double estimatedLength = eventList->getBeatCount() * samplesPerBeat
+            + longestSample;
+
+    // Silent frames are held back until sound follows them, so the song ends
+    // on its last audible frame instead of at the end of a block:
+    int heldSilence = 0;
+    const BlockHandler storeBlock = [this, &handleBlock, &heldSilence]
+            (const float* block, const int numSamples)
+    {
+        int soundEnd = numSamples;
+        while (soundEnd > 0 && block[soundEnd - 1] == 0.0f)
+        {
+            soundEnd--;
+        }
+        if (soundEnd == 0)
+        {
+            heldSilence += numSamples;
+            return true;
+        }
+        while (heldSilence > 0)
+        {
+            const int silentFrames = jmin(heldSilence, blockSize);
+            if (! handleBlock(silence, silentFrames))
+            {
+                return false;
+            }
+            heldSilence -= silentFrames;
+        }
+        heldSilence = numSamples - soundEnd;
+        return handleBlock(block, soundEnd);
+    };
+
+    voicePool.stopAllVoices();
+    limiter.reset();
+    sequencer.start(eventList.get(), samplesPerBeat, 0);
+    int64 samplesRendered = 0;
+    float* renderData = renderBuffer.getWritePointer(0);
+    // Drop the limiter's look-ahead delay from the start of the song:
+    int delayFrames = limiting ? limiter.getLatency() : 0;
+    while (sequencer.isPlaying() || voicePool.getActiveVoiceCount() > 0)
+    {
+        const float* block = renderNextBlock(renderData, blockSize);
+        const int skippedFrames = jmin(delayFrames, blockSize);
+        delayFrames -= skippedFrames;
+        if (cancelled || ! storeBlock(block + skippedFrames,
+                blockSize - skippedFrames))
+        {
+            sequencer.stop();
+            voicePool.stopAllVoices();
+            cancelled = false;
+            return false;
+        }
+        samplesRendered += blockSize;
+        progress = jmin(0.99, samplesRendered / estimatedLength);
+    }
+    if (limiting)
+    {
+        // Flush the end of the song out of the limiter's look-ahead delay:
+        const int tailFrames = limiter.getLatency() - delayFrames;
+        FloatVectorOperations::clear(renderData, tailFrames);
+        limiter.process(renderData, nullptr, tailFrames);
+        if (! storeBlock(renderData, tailFrames))
+        {
+            cancelled = false;
+            return false;
+        }
+    }
+    cancelled = false;
+    progress = 1;
+    return true;
+}
+
+
+// Renders the next block of the song into a mono buffer.
+const float* Audio::OfflineRenderer::renderNextBlock(float* output,
+        const int numSamples)
+{
+    FloatVectorOperations::clear(output, numSamples);
+    // Split the block into sections at each sequence event:
+    int startSample = 0;
+    while (startSample < numSamples)
+    {
+        while (const EventList::Event* event = sequencer.getNextDueEvent())
+        {
+            for (int i = 0; i < event->numNotes; i++)
+            {
+                const int note = event->notes[i];
+                const float gain = noteMix.getGain(note)
+                        * ((event->gains == nullptr) ? 1.0f : event->gains[i]);
+                voicePool.startVoice(note, *sampleBank, gain,
+                        noteMix.getMixedPan(note));
+            }
+        }
+        int sectionSize = numSamples - startSample;
+        if (sampleBank->isStreamed())
+        {
+            // Fill streams before every section they can read at once, so
+            // offline renders never underrun:
+            sectionSize = jmin(sectionSize, SampleStream::maxReadFrames);
+            voicePool.fillStreams();
+        }
+        sectionSize = sequencer.getSamplesUntilNextEvent(sectionSize);
+        voicePool.renderNextBlock(output + startSample, nullptr, sectionSize);
+        sequencer.advance(sectionSize);
+        startSample += sectionSize;
+    }
+    if (limiting)
+    {
+        limiter.process(output, nullptr, numSamples);
+    }
+    return output;
+}
@@ -0,0 +1,192 @@
+#pragma once
+/**
+ * @file  Audio_OfflineRenderer.h
+ *
+ * @brief  Renders songs directly to audio files without using an audio
+ *         device.
+ */
+
+#include "JuceHeader.h"
+#include "Audio_SampleBank.h"
+#include "Audio_EventList.h"
+#include "Audio_VoicePool.h"
+#include "Audio_Sequencer.h"
+#include "Audio_Limiter.h"
+#include "Audio_NoteMixTable.h"
+#include <atomic>
+
+namespace Audio { class OfflineRenderer; }
+
+/**
+ * @brief  Plays an event list through its own voice pool as fast as possible,
+ *         writing the output to a WAV or FLAC file.
+ *
+ *  Rendering uses the same voices, sequencing and note gains as live sample
+ * playback, but writes a dry mono mix of the note samples. Note positions
+ * only change how loud notes are when folded down, as in live mono playback,
+ * and neither the body resonance nor the synth engine is rendered. The
+ * render continues after the last beat until every note finishes ringing,
+ * and ends on the last audible frame. Output passes through the same
+ * limiter used for live playback, with its look-ahead delay removed, unless
+ * limiting is turned off.
+ *
+ *  Rendering runs on the thread that calls renderToFile, which should not be
+ * the message thread for long songs. Progress may be checked and rendering
+ * cancelled from any other thread.
+ */
+class Audio::OfflineRenderer
+{
+public:
+    // The sample rate used for rendering when no other rate is needed. This
+    // matches the note samples, so they never need to be resampled.
+    static const constexpr double defaultSampleRate = 48000;
+
+    // The number of bits per sample written to output files:
+    static const constexpr int outputBitDepth = 24;
+
+    /**
+     * @brief  Creates a renderer that plays notes from a sample bank.
+     *
+     * @param sampleBank  The bank holding all note samples. Files are written
+     *                    at the bank's sample rate.
+     */
+    OfflineRenderer(SampleBank::Ptr sampleBank);
+
+    virtual ~OfflineRenderer() { }
+
+    /**
+     * @brief  Turns output limiting on or off. Renders that will be mixed
+     *         with other audio should turn limiting off, and limit the final
+     *         mix instead.
+     *
+     * @param enabled  Whether rendered audio is limited.
+     */
+    void setLimiting(const bool enabled);
+
+    /**
+     * @brief  Sets the gain and stereo position of each note. Rendered audio
+     *         is mono, so positions only change how loud notes are when
+     *         folded down, exactly as in live mono playback.
+     *
+     * @param table  The pan and gain of every note.
+     */
+    void setNoteMix(const NoteMixTable& table);
+
+    /**
+     * @brief  Renders a song to an audio file, replacing any existing file.
+     *
+     * @param eventList   The song's notes.
+     *
+     * @param bpm         The playback speed in beats per minute.
+     *
+     * @param outputFile  The file to write. Its extension selects the output
+     *                    format, which must be .wav or .flac.
+     *
+     * @return            Whether the file was written, or the reason it
+     *                    wasn't.
+     */
+    juce::Result renderToFile(EventList::Ptr eventList, const int bpm,
+            const juce::File& outputFile);
+
+    /**
+     * @brief  Renders a song into an audio buffer.
+     *
+     * @param eventList  The song's notes.
+     *
+     * @param bpm        The playback speed in beats per minute.
+     *
+     * @param output     A buffer that will be resized to hold the song as mono
+     *                   audio at the sample bank's rate.
+     *
+     * @return           Whether the song was rendered, or false if the render
+     *                   was cancelled.
+     */
+    bool renderToBuffer(EventList::Ptr eventList, const int bpm,
+            juce::AudioBuffer<float>& output);
+
+    /**
+     * @brief  Writes mono audio to a file, replacing any existing file.
+     *
+     * @param audio       A buffer holding one channel of audio data.
+     *
+     * @param sampleRate  The audio's sample rate.
+     *
+     * @param outputFile  The file to write. Its extension selects the output
+     *                    format, which must be .wav or .flac.
+     *
+     * @return            Whether the file was written, or the reason it
+     *                    wasn't.
+     */
+    static juce::Result writeToFile(const juce::AudioBuffer<float>& audio,
+            const double sampleRate, const juce::File& outputFile);
+
+    /**
+     * @brief  Gets the progress of the current or most recent render.
+     *
+     * @return  The fraction of the song rendered, between zero and one.
+     */
+    double getProgress() const;
+
+    /**
+     * @brief  Stops the current render as soon as possible. The output file is
+     *         left unchanged. If no render is running, the next render stops
+     *         before writing anything.
+     */
+    void cancel();
+
+private:
+    // Stores a block of rendered audio, returning false if it failed:
+    typedef std::function<bool(const float* block, const int numSamples)>
+            BlockHandler;
+
+    /**
+     * @brief  Renders a song one block at a time, passing each block on to be
+     *         stored. Silence after the last audible frame is never stored.
+     *
+     * @param eventList    The song's notes.
+     *
+     * @param bpm          The playback speed in beats per minute.
+     *
+     * @param handleBlock  Stores each rendered block.
+     *
+     * @return             Whether the full song was rendered, or false if
+     *                     rendering was cancelled or a block couldn't be
+     *                     stored.
+     */
+    bool renderSong(EventList::Ptr eventList, const int bpm,
+            const BlockHandler& handleBlock);
+
+    /**
+     * @brief  Renders the next block of the song into a mono buffer.
+     *
+     * @param output      The buffer where output is written.
+     *
+     * @param numSamples  The number of frames to write.
+     *
+     * @return            The output buffer.
+     */
+    const float* renderNextBlock(float* output, const int numSamples);
+
+    // Holds each note's sample data at the output sample rate:
+    SampleBank::Ptr sampleBank;
+    // Plays all note samples:
+    VoicePool voicePool;
+    // Schedules each note event:
+    Sequencer sequencer;
+    // Keeps the rendered output from clipping:
+    Limiter limiter;
+    // Whether rendered output is limited:
+    bool limiting = true;
+    // The pan and gain each note starts with:
+    NoteMixTable noteMix;
+    // Holds each rendered block before it is written:
+    juce::AudioBuffer<float> renderBuffer;
+    // A block of silence, written before sound that follows silent frames:
+    juce::HeapBlock<float> silence;
+    // The fraction of the song rendered:
+    std::atomic<double> progress { 0 };
+    // Set when the current render should stop:
+    std::atomic<bool> cancelled { false };
+
+    JUCE_DECLARE_NON_COPYABLE(OfflineRenderer)
+};
@@ -0,0 +1,70 @@
+#include "Audio_ReadAheadThread.h"
+
+// Milliseconds to wait for the thread to stop:
+static const constexpr int stopTimeout = 1000;
+
+// The references held to a bank that no voice or command can still use, one
+// from the thread and one from the bank's release pool:
+static const constexpr int unusedReferenceCount = 2;
+
+// Creates the thread without starting it.
+Audio::ReadAheadThread::ReadAheadThread(VoicePool& voicePool) :
+Thread("ReadAheadThread"), voicePool(voicePool) { }
+
+
+// Stops the thread if it is running.
+Audio::ReadAheadThread::~ReadAheadThread()
+{
+    stopThread(stopTimeout);
+}
+
+
+// Starts filling streams, if the thread isn't already running.
+void Audio::ReadAheadThread::start()
+{
+    if (! isThreadRunning())
+    {
+        // Keep up with the audio thread when the system is busy:
+        startThread(8);
+    }
+}
+
+
+// Holds a reference to a bank that may be streamed.
+void Audio::ReadAheadThread::addSampleBank(SampleBank::Ptr sampleBank)
+{
+    const ScopedLock fillLock(lock);
+    sampleBanks.addIfNotAlreadyThere(sampleBank.get());
+}
+
+
+// Fills all streams until the thread is told to exit.
+void Audio::ReadAheadThread::run()
+{
+    while (! threadShouldExit())
+    {
+        {
+            const ScopedLock fillLock(lock);
+            releaseUnusedBanks();
+            voicePool.fillStreams();
+        }
+        wait(fillInterval);
+    }
+}
+
+
+// Releases all banks only referenced by this thread and their release pool.
+void Audio::ReadAheadThread::releaseUnusedBanks()
+{
+    // Voices stop their streams before releasing their banks, and no fill is
+    // running while the lock is held, so no stream can read these banks
+    // again:
+    for (int i = sampleBanks.size() - 1; i >= 0; i--)
+    {
+        if (sampleBanks.getObjectPointer(i)->getReferenceCount()
+                <= unusedReferenceCount)
+        {
+            sampleBanks.remove(i);
+        }
+    }
+}
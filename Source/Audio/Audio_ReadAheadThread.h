@@ -0,0 +1,81 @@
+#pragma once
+/**
+ * @file  Audio_ReadAheadThread.h
+ *
+ * @brief  Keeps streaming voices supplied with converted sample data.
+ */
+
+#include "JuceHeader.h"
+#include "Audio_VoicePool.h"
+#include "Audio_SampleBank.h"
+
+namespace Audio { class ReadAheadThread; }
+
+/**
+ * @brief  A background thread that regularly fills every streaming voice's
+ *         SampleStream.
+ *
+ *  Streams may still be reading a sample bank's data for a moment after the
+ * audio thread stops using that bank. The thread therefore holds its own
+ * reference to each bank passed to addSampleBank. Each bank must also be held
+ * by a ReleasePool, so once only the pool and this thread reference a bank,
+ * no voice or command can use it again. The thread then releases the bank
+ * between fills, so no fill can still be reading its data when the pool
+ * deletes it.
+ */
+class Audio::ReadAheadThread : private juce::Thread
+{
+public:
+    // Milliseconds between stream fills:
+    static const constexpr int fillInterval = 2;
+
+    /**
+     * @brief  Creates the thread without starting it.
+     *
+     * @param voicePool  The pool whose streams are filled. It must remain
+     *                   valid until the thread is destroyed.
+     */
+    ReadAheadThread(VoicePool& voicePool);
+
+    /**
+     * @brief  Stops the thread if it is running.
+     */
+    virtual ~ReadAheadThread();
+
+    /**
+     * @brief  Starts filling streams, if the thread isn't already running.
+     *         This should only be called on the message thread.
+     */
+    void start();
+
+    /**
+     * @brief  Holds a reference to a bank that may be streamed. This should
+     *         only be called on the message thread, before the bank is sent
+     *         to the audio thread.
+     *
+     * @param sampleBank  A bank that the audio thread may start using, which
+     *                    is already held by a ReleasePool.
+     */
+    void addSampleBank(SampleBank::Ptr sampleBank);
+
+private:
+    /**
+     * @brief  Fills all streams until the thread is told to exit.
+     */
+    void run() override;
+
+    /**
+     * @brief  Releases all banks only referenced by this thread and their
+     *         release pool. The lock must be held while this is called.
+     */
+    void releaseUnusedBanks();
+
+    // Holds the streams to fill:
+    VoicePool& voicePool;
+    // Held while filling streams or releasing banks:
+    juce::CriticalSection lock;
+    // Every bank that may still be streamed:
+    juce::ReferenceCountedArray<SampleBank> sampleBanks;
+
+    JUCE_DECLARE_NON_COPYABLE(ReadAheadThread)
+};
@@ -0,0 +1,76 @@
+#pragma once
+/**
+ * @file  Audio_ReleasePool.h
+ *
+ * @brief  Ensures objects shared with the audio thread are only ever deleted
+ *         on the message thread.
+ */
+
+#include "JuceHeader.h"
+
+namespace Audio { template <class ObjectType> class ReleasePool; }
+
+/**
+ * @brief  Holds a reference to every object shared with the audio thread,
+ *         and periodically deletes objects that nothing else references.
+ *
+ *  The audio thread may freely copy and release ReferenceCountedObjectPtr
+ * objects pointing to pooled objects, as the pool's own reference ensures the
+ * reference count never reaches zero on the audio thread. Once an object is
+ * only referenced by the pool, it is deleted on the next timer callback.
+ *
+ *  The pool must be created and used on the message thread.
+ *
+ * @tparam ObjectType  A juce::ReferenceCountedObject subclass.
+ */
+template <class ObjectType>
+class Audio::ReleasePool : private juce::Timer
+{
+public:
+    /**
+     * @brief  Starts the timer used to release unused objects.
+     */
+    ReleasePool()
+    {
+        startTimer(releaseInterval);
+    }
+
+    virtual ~ReleasePool() { }
+
+    /**
+     * @brief  Adds an object to the pool.
+     *
+     * @param object  An object that will be shared with the audio thread.
+     */
+    void add(ObjectType* object)
+    {
+        if (object != nullptr && ! objects.contains(object))
+        {
+            objects.add(object);
+        }
+    }
+
+private:
+    /**
+     * @brief  Deletes all pooled objects that are no longer referenced
+     *         elsewhere.
+     */
+    void timerCallback() override
+    {
+        for (int i = objects.size() - 1; i >= 0; i--)
+        {
+            if (objects.getObjectPointer(i)->getReferenceCount() == 1)
+            {
+                objects.remove(i);
+            }
+        }
+    }
+
+    // Milliseconds between checks for unused objects:
+    static const constexpr int releaseInterval = 1000;
+
+    // Holds a reference to each pooled object:
+    juce::ReferenceCountedArray<ObjectType> objects;
+
+    JUCE_DECLARE_NON_COPYABLE(ReleasePool)
+};
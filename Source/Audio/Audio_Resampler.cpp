@@ -0,0 +1,134 @@
+#include "Audio_Resampler.h"
+#include "Audio_SIMD.h"
+
+// The Kaiser window shape parameter, trading transition width for stopband
+// attenuation of around 80dB:
+static const constexpr double kaiserBeta = 8.0;
+
+// The sinc cutoff as a fraction of the Nyquist frequency, low enough that the
+// transition band ends at the Nyquist frequency:
+static const constexpr double cutoffFraction = 0.85;
+
+// The number of frames before each output position that are summed:
+static const constexpr int tapsBefore = Audio::Resampler::numTaps / 2 - 1;
+
+/**
+ * @brief  Calculates the zeroth order modified Bessel function of the first
+ *         kind, used to shape the Kaiser window.
+ *
+ * @param x  The function input.
+ *
+ * @return   The function output.
+ */
+static double besselI0(const double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+    const double halfSquared = x * x / 4.0;
+    for (int k = 1; k < 64 && term > sum * 1.0e-12; k++)
+    {
+        term *= halfSquared / (k * k);
+        sum += term;
+    }
+    return sum;
+}
+
+
+// Calculates the filter weights for every phase of a speed ratio.
+Audio::Resampler::Resampler(const double speedRatio) :
+speedRatio(speedRatio),
+weights((size_t) ((numPhases + 1) * numTaps)),
+weightSteps((size_t) (numPhases * numTaps))
+{
+    jassert(speedRatio > 0);
+    static_assert(numTaps % SIMD::size == 0,
+            "Taps must fill whole vectors");
+    // Reading faster than the output rate lowers the output's Nyquist
+    // frequency, so the cutoff is lowered with it:
+    const double cutoff = cutoffFraction * jmin(1.0, 1.0 / speedRatio);
+    const double halfWidth = numTaps / 2.0;
+    const double windowScale = 1.0 / besselI0(kaiserBeta);
+    for (int phase = 0; phase <= numPhases; phase++)
+    {
+        float* phaseWeights = weights + phase * numTaps;
+        const double fraction = (double) phase / numPhases;
+        double weightSum = 0.0;
+        for (int tap = 0; tap < numTaps; tap++)
+        {
+            // The tap's distance from the output position, in input frames:
+            const double offset = tap - tapsBefore - fraction;
+            const double windowPosition = offset / halfWidth;
+            const double window = (std::abs(windowPosition) >= 1.0) ? 0.0
+                    : besselI0(kaiserBeta * std::sqrt(1.0 - windowPosition
+                        * windowPosition)) * windowScale;
+            const double sincInput = MathConstants<double>::pi * cutoff
+                    * offset;
+            const double sinc = (sincInput == 0.0) ? 1.0
+                    : std::sin(sincInput) / sincInput;
+            phaseWeights[tap] = (float) (cutoff * sinc * window);
+            weightSum += phaseWeights[tap];
+        }
+        // Keep the gain of constant input at exactly one at every phase:
+        for (int tap = 0; tap < numTaps; tap++)
+        {
+            phaseWeights[tap] = (float) (phaseWeights[tap] / weightSum);
+        }
+    }
+    for (int i = 0; i < numPhases * numTaps; i++)
+    {
+        weightSteps[i] = weights[i + numTaps] - weights[i];
+    }
+}
+
+
+// Gets the number of input frames read for every output frame.
+double Audio::Resampler::getSpeedRatio() const
+{
+    return speedRatio;
+}
+
+
+// Gets the number of output frames needed to hold all of an input after
+// resampling.
+int Audio::Resampler::getOutputLength(const int inputLength) const
+{
+    return (int) std::ceil(inputLength / speedRatio);
+}
+
+
+// Resamples a mono buffer.
+void Audio::Resampler::process(const float* input, const int inputLength,
+        float* output, const int numOutputs) const
+{
+    using namespace SIMD;
+    // Pad the input with silence, so every sum reads whole vectors without
+    // checking the input bounds:
+    const int padding = numTaps;
+    HeapBlock<float> paddedInput((size_t) (inputLength + padding * 2), true);
+    FloatVectorOperations::copy(paddedInput + padding, input, inputLength);
+    for (int i = 0; i < numOutputs; i++)
+    {
+        const double position = i * speedRatio;
+        const int index = (int) position;
+        if (index - tapsBefore >= inputLength)
+        {
+            // Nothing past this point reaches the input:
+            FloatVectorOperations::clear(output + i, numOutputs - i);
+            return;
+        }
+        const double phasePosition = (position - index) * numPhases;
+        const int phase = jmin((int) phasePosition, numPhases - 1);
+        const Vector phaseFraction = fill((float) (phasePosition - phase));
+        const float* phaseWeights = weights + phase * numTaps;
+        const float* phaseSteps = weightSteps + phase * numTaps;
+        const float* frames = paddedInput + index + padding - tapsBefore;
+        Vector total = fill(0.0f);
+        for (int tap = 0; tap < numTaps; tap += SIMD::size)
+        {
+            const Vector weight = multiplyAdd(load(phaseWeights + tap),
+                    load(phaseSteps + tap), phaseFraction);
+            total = multiplyAdd(total, load(frames + tap), weight);
+        }
+        output[i] = sum(total);
+    }
+}
@@ -0,0 +1,93 @@
+#pragma once
+/**
+ * @file  Audio_Resampler.h
+ *
+ * @brief  Converts sample data between sample rates and pitches.
+ */
+
+#include "JuceHeader.h"
+
+namespace Audio { class Resampler; }
+
+/**
+ * @brief  A polyphase windowed-sinc resampler, used to convert note samples
+ *         to the output rate and to pitch-shift samples to other notes.
+ *
+ *  Each output frame is a weighted sum of the numTaps input frames around
+ * its position in the input. The weights come from a Kaiser-windowed sinc
+ * function, calculated once for numPhases evenly spaced fractional positions
+ * when the resampler is created. Weights for positions between two phases
+ * are linearly interpolated from the neighbouring phases, so any speed ratio
+ * may be used, not just simple fractions.
+ *
+ *  When the input is read faster than the output rate, the sinc cutoff is
+ * lowered to match, so content above the new Nyquist frequency is removed
+ * rather than aliased. Output is aligned with the input, with no added delay.
+ *
+ *  Weight interpolation and the weighted sums are both vectorised with
+ * Audio::SIMD. Resampling allocates temporary memory, so it is intended for
+ * loading and preparing samples rather than for use on the audio thread.
+ */
+class Audio::Resampler
+{
+public:
+    // The number of input frames summed for each output frame:
+    static const constexpr int numTaps = 32;
+    // The number of fractional input positions with precomputed weights:
+    static const constexpr int numPhases = 256;
+
+    /**
+     * @brief  Calculates the weights used to resample at one speed.
+     *
+     * @param speedRatio  The number of input frames read for every output
+     *                    frame. This is the input rate over the output rate
+     *                    when converting sample rates, or the frequency ratio
+     *                    between the new and old pitch when pitch-shifting.
+     */
+    Resampler(const double speedRatio);
+
+    virtual ~Resampler() { }
+
+    /**
+     * @brief  Gets the number of input frames read for every output frame.
+     *
+     * @return  The ratio passed to the constructor.
+     */
+    double getSpeedRatio() const;
+
+    /**
+     * @brief  Gets the number of output frames needed to hold all of an input
+     *         after resampling.
+     *
+     * @param inputLength  The number of input frames.
+     *
+     * @return             The resampled length.
+     */
+    int getOutputLength(const int inputLength) const;
+
+    /**
+     * @brief  Resamples a mono buffer. Frames before the start and past the
+     *         end of the input are treated as silence.
+     *
+     * @param input        The input samples.
+     *
+     * @param inputLength  The number of input frames.
+     *
+     * @param output       The buffer where resampled frames are written.
+     *
+     * @param numOutputs   The number of output frames to write.
+     */
+    void process(const float* input, const int inputLength, float* output,
+            const int numOutputs) const;
+
+private:
+    // The input frames read for every output frame:
+    const double speedRatio;
+    // The weights for each phase, followed by one extra phase equal to the
+    // first phase shifted by one frame:
+    juce::HeapBlock<float> weights;
+    // The difference between each phase's weights and the next phase's:
+    juce::HeapBlock<float> weightSteps;
+
+    JUCE_DECLARE_NON_COPYABLE(Resampler)
+};
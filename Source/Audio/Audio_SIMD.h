@@ -0,0 +1,246 @@
+#pragma once
+/**
+ * @file  Audio_SIMD.h
+ *
+ * @brief  Wraps the few vector operations used by the audio engine's
+ *         vectorised kernels.
+ */
+
+#include "JuceHeader.h"
+
+#if defined(__SSE2__) || defined(_M_X64) \
+        || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define AUDIO_SIMD_SSE 1
+    #define AUDIO_SIMD_NATIVE 1
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+    #include <arm_neon.h>
+    #define AUDIO_SIMD_NEON 1
+    #define AUDIO_SIMD_NATIVE 1
+#else
+    #define AUDIO_SIMD_NATIVE 0
+#endif
+
+namespace Audio
+{
+    /**
+     * @brief  Four-lane float vectors, so the same kernel code works with
+     *         both SSE on Intel processors and NEON on ARM processors.
+     *
+     *  Other processors use a plain array of four floats, so kernels written
+     * with these functions still build and run everywhere, just without the
+     * speedup. Check AUDIO_SIMD_NATIVE where a kernel has a faster scalar
+     * version for those processors.
+     */
+    namespace SIMD
+    {
+        // The number of floats in each vector:
+        static const constexpr int size = 4;
+
+        #if AUDIO_SIMD_SSE
+        typedef __m128 Vector;
+
+        static inline Vector load(const float* data)
+        {
+            return _mm_loadu_ps(data);
+        }
+
+        static inline void store(float* data, const Vector vector)
+        {
+            _mm_storeu_ps(data, vector);
+        }
+
+        static inline Vector fill(const float value)
+        {
+            return _mm_set1_ps(value);
+        }
+
+        // Returns { start, start + step, start + 2 * step, start + 3 * step }:
+        static inline Vector ramp(const float start, const float step)
+        {
+            return _mm_setr_ps(start, start + step, start + 2.0f * step,
+                    start + 3.0f * step);
+        }
+
+        static inline Vector add(const Vector first, const Vector second)
+        {
+            return _mm_add_ps(first, second);
+        }
+
+        static inline Vector subtract(const Vector first, const Vector second)
+        {
+            return _mm_sub_ps(first, second);
+        }
+
+        static inline Vector multiply(const Vector first, const Vector second)
+        {
+            return _mm_mul_ps(first, second);
+        }
+
+        // Returns sum + (vector * multiplier):
+        static inline Vector multiplyAdd(const Vector sum, const Vector vector,
+                const Vector multiplier)
+        {
+            return _mm_add_ps(sum, _mm_mul_ps(vector, multiplier));
+        }
+
+        static inline Vector max(const Vector first, const Vector second)
+        {
+            return _mm_max_ps(first, second);
+        }
+
+        // Returns the sum of all four lanes:
+        static inline float sum(const Vector vector)
+        {
+            const Vector pairs = _mm_add_ps(vector,
+                    _mm_movehl_ps(vector, vector));
+            return _mm_cvtss_f32(_mm_add_ss(pairs,
+                    _mm_shuffle_ps(pairs, pairs, 1)));
+        }
+        #elif AUDIO_SIMD_NEON
+        typedef float32x4_t Vector;
+
+        static inline Vector load(const float* data)
+        {
+            return vld1q_f32(data);
+        }
+
+        static inline void store(float* data, const Vector vector)
+        {
+            vst1q_f32(data, vector);
+        }
+
+        static inline Vector fill(const float value)
+        {
+            return vdupq_n_f32(value);
+        }
+
+        // Returns { start, start + step, start + 2 * step, start + 3 * step }:
+        static inline Vector ramp(const float start, const float step)
+        {
+            const float values[size] = { start, start + step,
+                    start + 2.0f * step, start + 3.0f * step };
+            return vld1q_f32(values);
+        }
+
+        static inline Vector add(const Vector first, const Vector second)
+        {
+            return vaddq_f32(first, second);
+        }
+
+        static inline Vector subtract(const Vector first, const Vector second)
+        {
+            return vsubq_f32(first, second);
+        }
+
+        static inline Vector multiply(const Vector first, const Vector second)
+        {
+            return vmulq_f32(first, second);
+        }
+
+        // Returns sum + (vector * multiplier):
+        static inline Vector multiplyAdd(const Vector sum, const Vector vector,
+                const Vector multiplier)
+        {
+            return vmlaq_f32(sum, vector, multiplier);
+        }
+
+        static inline Vector max(const Vector first, const Vector second)
+        {
+            return vmaxq_f32(first, second);
+        }
+
+        // Returns the sum of all four lanes:
+        static inline float sum(const Vector vector)
+        {
+            const float32x2_t pairs = vadd_f32(vget_low_f32(vector),
+                    vget_high_f32(vector));
+            return vget_lane_f32(vpadd_f32(pairs, pairs), 0);
+        }
+        #else
+        struct Vector
+        {
+            float lanes[size];
+        };
+
+        static inline Vector load(const float* data)
+        {
+            return { { data[0], data[1], data[2], data[3] } };
+        }
+
+        static inline void store(float* data, const Vector vector)
+        {
+            for (int i = 0; i < size; i++)
+            {
+                data[i] = vector.lanes[i];
+            }
+        }
+
+        static inline Vector fill(const float value)
+        {
+            return { { value, value, value, value } };
+        }
+
+        // Returns { start, start + step, start + 2 * step, start + 3 * step }:
+        static inline Vector ramp(const float start, const float step)
+        {
+            return { { start, start + step, start + 2.0f * step,
+                    start + 3.0f * step } };
+        }
+
+        static inline Vector add(const Vector first, const Vector second)
+        {
+            Vector result;
+            for (int i = 0; i < size; i++)
+            {
+                result.lanes[i] = first.lanes[i] + second.lanes[i];
+            }
+            return result;
+        }
+
+        static inline Vector subtract(const Vector first, const Vector second)
+        {
+            Vector result;
+            for (int i = 0; i < size; i++)
+            {
+                result.lanes[i] = first.lanes[i] - second.lanes[i];
+            }
+            return result;
+        }
+
+        static inline Vector multiply(const Vector first, const Vector second)
+        {
+            Vector result;
+            for (int i = 0; i < size; i++)
+            {
+                result.lanes[i] = first.lanes[i] * second.lanes[i];
+            }
+            return result;
+        }
+
+        // Returns sum + (vector * multiplier):
+        static inline Vector multiplyAdd(const Vector sum, const Vector vector,
+                const Vector multiplier)
+        {
+            return add(sum, multiply(vector, multiplier));
+        }
+
+        static inline Vector max(const Vector first, const Vector second)
+        {
+            Vector result;
+            for (int i = 0; i < size; i++)
+            {
+                result.lanes[i] = juce::jmax(first.lanes[i], second.lanes[i]);
+            }
+            return result;
+        }
+
+        // Returns the sum of all four lanes:
+        static inline float sum(const Vector vector)
+        {
+            return (vector.lanes[0] + vector.lanes[1])
+                    + (vector.lanes[2] + vector.lanes[3]);
+        }
+        #endif
+    }
+}
@@ -0,0 +1,525 @@
+#include "Audio_SampleBank.h"
+#include "Audio_Resampler.h"
+#include "Assets.h"
+
+// Each note's sample data starts on a multiple of this many floats, so that
+// note data is aligned to 64 bytes for vector operations:
+static const constexpr int alignment = 16;
+
+/**
+ * @brief  Rounds a frame count up to the next multiple of the alignment.
+ *
+ * @param numFrames  A number of sample frames.
+ *
+ * @return           The aligned frame count.
+ */
+static int alignedSize(const int numFrames)
+{
+    return (numFrames + alignment - 1) / alignment * alignment;
+}
+
+
+/**
+ * @brief  Finds the audible section of a decoded sample, and fades out the
+ *         end of that section.
+ *
+ * @param sample      A decoded mono sample. Frames after the audible section
+ *                    are cleared.
+ *
+ * @param length      The number of frames of sample data in the buffer.
+ *
+ * @param sampleRate  The sample's sample rate.
+ *
+ * @param processing  The trimming thresholds and times.
+ *
+ * @return            The range of frames to keep.
+ */
+static Range<int> trimSample(AudioBuffer<float>& sample, const int length,
+        const double sampleRate,
+        const Audio::SampleBank::Processing& processing)
+{
+    float* data = sample.getWritePointer(0);
+    const float onsetThreshold
+            = Decibels::decibelsToGain(processing.onsetThresholdDb);
+    const float tailThreshold
+            = Decibels::decibelsToGain(processing.tailThresholdDb);
+    int onset = 0;
+    while (onset < length && std::abs(data[onset]) < onsetThreshold)
+    {
+        onset++;
+    }
+    if (onset == length)
+    {
+        // The sample never gets loud enough to have an attack:
+        return Range<int>(0, length);
+    }
+    const int start = jmax(0, onset
+            - (int) (processing.preOnsetSeconds * sampleRate));
+    int lastAudible = length - 1;
+    while (lastAudible > onset && std::abs(data[lastAudible]) < tailThreshold)
+    {
+        lastAudible--;
+    }
+    const int fadeFrames = (int) (processing.tailFadeSeconds * sampleRate);
+    const int end = jmin(length, lastAudible + 1 + fadeFrames);
+    const int fadeStart = jmax(start, end - fadeFrames);
+    if (end > fadeStart)
+    {
+        sample.applyGainRamp(0, fadeStart, end - fadeStart, 1.0f, 0.0f);
+    }
+    sample.clear(end, sample.getNumSamples() - end);
+    return Range<int>(start, end);
+}
+
+
+/**
+ * @brief  Measures the loudness of a note's attack.
+ *
+ * @param data        The note's sample data, starting at its onset.
+ *
+ * @param length      The number of frames of sample data.
+ *
+ * @param sampleRate  The sample's sample rate.
+ *
+ * @param processing  Sets the length of the attack.
+ *
+ * @return            The RMS level of the note's attack.
+ */
+static float attackLevel(const float* data, const int length,
+        const double sampleRate,
+        const Audio::SampleBank::Processing& processing)
+{
+    const int attackLength = jmin(length,
+            jmax(1, (int) (processing.attackSeconds * sampleRate)));
+    double sum = 0;
+    for (int i = 0; i < attackLength; i++)
+    {
+        sum += data[i] * data[i];
+    }
+    return (float) std::sqrt(sum / attackLength);
+}
+
+
+/**
+ * @brief  Finds a note's decay envelope, working back from the end of the
+ *         sample.
+ *
+ * @param data      The note's sample data.
+ *
+ * @param length    The number of frames in the sample data.
+ *
+ * @param envelope  Used to return the highest level reached from the start
+ *                  of each envelope section to the end of the sample.
+ */
+static void findEnvelope(const float* data, const int length,
+        float* envelope)
+{
+    const int resolution = Audio::SampleBank::envelopeResolution;
+    float peak = 0.0f;
+    for (int section = (length - 1) / resolution; section >= 0; section--)
+    {
+        const int start = section * resolution;
+        const Range<float> range = FloatVectorOperations::findMinAndMax(
+                data + start, jmin(resolution, length - start));
+        peak = jmax(peak, -range.getStart(), range.getEnd());
+        envelope[section] = peak;
+    }
+}
+
+
+// Gets the asset names of the music box note samples, in note order.
+const StringArray& Audio::SampleBank::getNoteAssetNames()
+{
+    static const StringArray noteAssets =
+    {
+        "_177947__ubikphonik__ab1_aiff",
+        "_177944__ubikphonik__bb1_aiff",
+        "_177948__ubikphonik__c1_aiff",
+        "_177950__ubikphonik__db1_aiff",
+        "_177954__ubikphonik__eb1_aiff",
+        "_177943__ubikphonik__f1_aiff",
+        "_177941__ubikphonik__g1_aiff",
+        "_177946__ubikphonik__ab2_aiff",
+        "_177949__ubikphonik__bb2_aiff",
+        "_177951__ubikphonik__c2_aiff",
+        "_177952__ubikphonik__db2_aiff",
+        "_177953__ubikphonik__eb2_aiff",
+        "_177942__ubikphonik__f2_aiff",
+        "_177940__ubikphonik__g2_aiff",
+        "_177945__ubikphonik__ab3_aiff"
+    };
+    return noteAssets;
+}
+
+
+// Decodes and converts all note samples.
+Audio::SampleBank::SampleBank(const StringArray& assetNames,
+        const double sampleRate, const Processing& processing) :
+sampleRate(sampleRate)
+{
+    jassert(sampleRate > 0);
+    AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    // Decode all samples at their original rate:
+    OwnedArray<AudioBuffer<float>> decoded;
+    Array<double> decodedRates;
+    for (const String& assetName : assetNames)
+    {
+        // Read directly from the asset data, so no temporary files are needed:
+        std::unique_ptr<InputStream> assetStream
+                = Assets::createAssetInputStream(assetName);
+        std::unique_ptr<AudioFormatReader> noteReader(assetStream == nullptr
+                ? nullptr
+                : formatManager.createReaderFor(assetStream.release()));
+        if (noteReader == nullptr || noteReader->lengthInSamples <= 0)
+        {
+            DBG("SampleBank: failed to load sample " << assetName);
+            jassertfalse;
+            // Keep note indices aligned with their samples:
+            decoded.add(nullptr);
+            decodedRates.add(0);
+            continue;
+        }
+        const int length = (int) noteReader->lengthInSamples;
+        AudioBuffer<float>* noteSample = new AudioBuffer<float>(1, length);
+        noteReader->read(noteSample, 0, length, 0, true, false);
+        decoded.add(noteSample);
+        decodedRates.add(noteReader->sampleRate);
+    }
+
+    // Find the section of each sample to keep, and its gain:
+    Array<Range<int>> keptRanges;
+    Array<float> gains;
+    float averageLevel = 0;
+    int numLevels = 0;
+    for (int i = 0; i < decoded.size(); i++)
+    {
+        Range<int> keptRange;
+        float level = 0;
+        if (decoded[i] != nullptr)
+        {
+            const int sourceLength = decoded[i]->getNumSamples();
+            keptRange = processing.trim ? trimSample(*decoded[i],
+                    sourceLength, decodedRates[i], processing)
+                    : Range<int>(0, sourceLength);
+            level = attackLevel(decoded[i]->getReadPointer(0,
+                    keptRange.getStart()), keptRange.getLength(),
+                    decodedRates[i], processing);
+            if (level > 0)
+            {
+                averageLevel += level;
+                numLevels++;
+            }
+        }
+        keptRanges.add(keptRange);
+        gains.add(level);
+    }
+    averageLevel = (numLevels > 0) ? averageLevel / numLevels : 0;
+    for (float& gain : gains)
+    {
+        gain = (processing.normalise && gain > 0) ? averageLevel / gain : 1.0f;
+    }
+
+    // Find the converted length of each note, and its place in storage:
+    findNoteSources(processing, decoded.size());
+    Array<double> speedRatios;
+    Array<int> lastUses;
+    lastUses.insertMultiple(0, -1, decoded.size());
+    int totalSize = 0;
+    int maxLength = 0;
+    for (int i = 0; i < sourceSamples.size(); i++)
+    {
+        const int source = sourceSamples[i];
+        int length = 0;
+        double speedRatio = 0;
+        if (decoded[source] != nullptr)
+        {
+            // Read faster to raise the pitch, and to lower the sample rate:
+            speedRatio = decodedRates[source] / sampleRate * pitchRatios[i];
+            length = (int) std::ceil(keptRanges[source].getLength()
+                    / speedRatio);
+            untrimmedSize += sizeof(float) * (size_t) std::ceil(
+                    decoded[source]->getNumSamples() / speedRatio);
+            lastUses.set(source, i);
+        }
+        speedRatios.add(speedRatio);
+        offsets.add(totalSize);
+        lengths.add(length);
+        totalSize += alignedSize(length);
+        maxLength = jmax(maxLength, length);
+    }
+
+    // Streamed banks keep every frame as 16-bit data, and only the start of
+    // each note as floats. Each note is converted in a single note buffer,
+    // so the whole bank is never held as floats:
+    const bool streamed = (processing.storage == Storage::pcm16);
+    HeapBlock<float> noteBuffer;
+    totalFrames = totalSize;
+    if (streamed)
+    {
+        pcmFrames = totalSize;
+        pcmData.calloc((size_t) jmax(pcmFrames, 1));
+        pcmOffsets = offsets;
+        offsets.clearQuick();
+        totalFrames = 0;
+        for (int i = 0; i < lengths.size(); i++)
+        {
+            offsets.add(totalFrames);
+            totalFrames += alignedSize(getPreloadLength(i));
+        }
+        noteBuffer.malloc((size_t) jmax(maxLength, 1));
+    }
+    storageSize = (size_t) (totalFrames + alignment);
+    storage.calloc(storageSize);
+    // Align the start of the data, so every aligned offset is also aligned:
+    const size_t alignBytes = alignment * sizeof(float);
+    const size_t misalignment = ((size_t) storage.get()) % alignBytes;
+    float* alignedData = storage.get() + (misalignment == 0 ? 0
+            : (alignBytes - misalignment) / sizeof(float));
+    sampleData = alignedData;
+
+    for (const int& length : lengths)
+    {
+        envelopeOffsets.add(envelopeSize);
+        envelopeSize += (length + envelopeResolution - 1) / envelopeResolution;
+    }
+    envelopes.calloc((size_t) jmax(envelopeSize, 1));
+    envelopeData = envelopes;
+
+    // Convert each note's sample to the output rate and the note's pitch:
+    for (int i = 0; i < sourceSamples.size(); i++)
+    {
+        const int source = sourceSamples[i];
+        if (lengths[i] == 0)
+        {
+            continue;
+        }
+        const float* sourceData = decoded[source]->getReadPointer(0,
+                keptRanges[source].getStart());
+        float* dest = streamed ? noteBuffer.get() : alignedData + offsets[i];
+        if (speedRatios[i] == 1.0)
+        {
+            FloatVectorOperations::copy(dest, sourceData, lengths[i]);
+        }
+        else
+        {
+            const Resampler resampler(speedRatios[i]);
+            resampler.process(sourceData, keptRanges[source].getLength(),
+                    dest, lengths[i]);
+        }
+        if (gains[source] != 1.0f)
+        {
+            FloatVectorOperations::multiply(dest, gains[source], lengths[i]);
+        }
+        findEnvelope(dest, lengths[i], envelopes + envelopeOffsets[i]);
+        if (streamed)
+        {
+            int16* pcmNote = pcmData + pcmOffsets[i];
+            for (int frame = 0; frame < lengths[i]; frame++)
+            {
+                pcmNote[frame] = (int16) jlimit(-32767, 32767,
+                        roundToInt(dest[frame] * 32767.0f));
+            }
+            // Convert back from the 16-bit data the same way SampleStream
+            // does, so preloaded and streamed frames match exactly:
+            float* preload = alignedData + offsets[i];
+            for (int frame = 0; frame < getPreloadLength(i); frame++)
+            {
+                preload[frame] = pcmNote[frame] * (1.0f / 32767.0f);
+            }
+        }
+        // Free each decoded sample once no other note needs it:
+        if (lastUses[source] == i)
+        {
+            decoded.set(source, nullptr);
+        }
+    }
+    DBG("SampleBank: decoded " << decoded.size() << " samples into "
+            << lengths.size() << " notes at "
+            << sampleRate << "Hz, using " << (int) (getMemorySize() / 1024)
+            << " KB, trimmed from " << (int) (untrimmedSize / 1024)
+            << " KB");
+}
+
+
+// Decodes and converts all note samples, using the default sample
+// processing.
+Audio::SampleBank::SampleBank(const StringArray& assetNames,
+        const double sampleRate) :
+SampleBank(assetNames, sampleRate, Processing()) { }
+
+
+// Creates an empty bank, to be filled in by a SampleCache.
+Audio::SampleBank::SampleBank(const double sampleRate) :
+sampleRate(sampleRate) { }
+
+
+// Chooses the recorded sample each note plays, and how far it is
+// pitch-shifted.
+void Audio::SampleBank::findNoteSources(const Processing& processing,
+        const int numSamples)
+{
+    sourceSamples.clearQuick();
+    pitchRatios.clearQuick();
+    noteFrequencies.clearQuick();
+    if (processing.samplePitches.isEmpty()
+            || processing.notePitches.isEmpty())
+    {
+        for (int i = 0; i < numSamples; i++)
+        {
+            sourceSamples.add(i);
+            pitchRatios.add(1.0);
+        }
+        return;
+    }
+    jassert(processing.samplePitches.size() == numSamples);
+    const int numPitches = jmin(numSamples, processing.samplePitches.size());
+    for (const double& notePitch : processing.notePitches)
+    {
+        int nearest = 0;
+        for (int i = 1; i < numPitches; i++)
+        {
+            if (std::abs(processing.samplePitches[i] - notePitch)
+                    < std::abs(processing.samplePitches[nearest] - notePitch))
+            {
+                nearest = i;
+            }
+        }
+        const double shift = notePitch - processing.samplePitches[nearest];
+        sourceSamples.add(nearest);
+        pitchRatios.add((shift == 0.0) ? 1.0 : std::pow(2.0, shift / 12.0));
+        noteFrequencies.add(440.0 * std::pow(2.0, (notePitch - 69.0) / 12.0));
+    }
+}
+
+
+// Gets the sample rate of all stored samples.
+double Audio::SampleBank::getSampleRate() const
+{
+    return sampleRate;
+}
+
+
+// Gets the number of notes in the bank.
+int Audio::SampleBank::getNumNotes() const
+{
+    return lengths.size();
+}
+
+
+// Gets a note's sample data.
+const float* Audio::SampleBank::getSampleData(const int note) const
+{
+    if (getSampleLength(note) == 0)
+    {
+        return nullptr;
+    }
+    return sampleData + offsets[note];
+}
+
+
+// Gets the number of frames of a note's sample data that are stored as
+// floats.
+int Audio::SampleBank::getPreloadLength(const int note) const
+{
+    return isStreamed() ? jmin(getSampleLength(note), preloadFrames)
+            : getSampleLength(note);
+}
+
+
+// Gets a note's complete 16-bit sample data.
+const int16* Audio::SampleBank::getStreamData(const int note) const
+{
+    if (! isStreamed() || getSampleLength(note) == 0)
+    {
+        return nullptr;
+    }
+    return pcmData + pcmOffsets[note];
+}
+
+
+// Checks if notes must be streamed during playback.
+bool Audio::SampleBank::isStreamed() const
+{
+    return pcmData != nullptr;
+}
+
+
+// Gets the length of a note's sample data.
+int Audio::SampleBank::getSampleLength(const int note) const
+{
+    // juce::Array returns zero for out of range indices.
+    return lengths[note];
+}
+
+
+// Gets the amount of memory the bank would use if samples weren't trimmed.
+size_t Audio::SampleBank::getUntrimmedMemorySize() const
+{
+    return untrimmedSize;
+}
+
+
+// Gets a note's decay envelope.
+const float* Audio::SampleBank::getEnvelope(const int note) const
+{
+    if (getSampleLength(note) == 0)
+    {
+        return nullptr;
+    }
+    return envelopeData + envelopeOffsets[note];
+}
+
+
+// Gets the recorded sample a note plays.
+int Audio::SampleBank::getSourceSample(const int note) const
+{
+    return (note >= 0 && note < sourceSamples.size()) ? sourceSamples[note]
+            : -1;
+}
+
+
+// Checks if a note was generated by pitch-shifting a recorded sample of
+// another pitch.
+bool Audio::SampleBank::isGeneratedNote(const int note) const
+{
+    return note >= 0 && note < pitchRatios.size() && pitchRatios[note] != 1.0;
+}
+
+
+// Gets the pitch of every note, if the bank was given a pitch layout.
+const Array<double>& Audio::SampleBank::getNoteFrequencies() const
+{
+    return noteFrequencies;
+}
+
+
+// Gets the amount of memory used to store one note's samples.
+size_t Audio::SampleBank::getNoteMemorySize(const int note) const
+{
+    if (getSampleLength(note) == 0)
+    {
+        return 0;
+    }
+    size_t size = sizeof(float) * (size_t) alignedSize(getPreloadLength(note));
+    if (isStreamed())
+    {
+        size += sizeof(int16) * (size_t) getSampleLength(note);
+    }
+    return size;
+}
+
+
+// Gets the amount of memory used to store all samples.
+size_t Audio::SampleBank::getMemorySize() const
+{
+    return storageSize * sizeof(float) + (size_t) pcmFrames * sizeof(int16);
+}
+
+
+// Checks if the bank's data is mapped from a cache file.
+bool Audio::SampleBank::isMemoryMapped() const
+{
+    return mappedFile != nullptr;
+}
@@ -0,0 +1,338 @@
+#pragma once
+/**
+ * @file  Audio_SampleBank.h
+ *
+ * @brief  Holds all note samples decoded and converted to the output sample
+ *         rate.
+ */
+
+#include "JuceHeader.h"
+
+namespace Audio
+{
+    class SampleBank;
+    class SampleCache;
+}
+
+/**
+ * @brief  Decodes a set of note samples once, converting each to float data at
+ *         the output sample rate.
+ *
+ *  All sample data is stored in a single contiguous allocation, with each
+ * note's data aligned for vector operations. Voices play samples by copying
+ * directly from the bank, so no decoding or rate conversion happens on the
+ * audio thread. A new bank must be created whenever the output sample rate
+ * changes.
+ *
+ *  Samples may be trimmed while loading. Leading silence is removed so each
+ * note's attack starts immediately, and inaudible tails are cut off with a
+ * short fade. Notes may also be normalised, so that every note's attack is
+ * equally loud.
+ *
+ *  Banks may also be read from a SampleCache file, in which case the sample
+ * data is memory-mapped instead of copied into the bank.
+ *
+ *  Banks may hold more notes than there are recorded samples. Each note may
+ * be given a pitch, and plays the recorded sample with the nearest pitch,
+ * resampled to the note's pitch while the bank loads. Rate conversion and
+ * pitch shifting are done in the same pass, so generated notes cost no more
+ * to load than recorded ones, and nothing is resampled during playback.
+ *
+ *  To save memory, samples may instead be stored as 16-bit PCM. Only the
+ * first preloadFrames of each note are then kept as float data. The rest is
+ * converted while the note plays, using each voice's SampleStream.
+ */
+class Audio::SampleBank : public juce::ReferenceCountedObject
+{
+public:
+    typedef juce::ReferenceCountedObjectPtr<SampleBank> Ptr;
+
+    // The number of sample frames covered by each envelope value:
+    static const constexpr int envelopeResolution = 256;
+    // The number of frames at the start of each streamed note that are kept
+    // as float data, so notes can start before any data is streamed:
+    static const constexpr int preloadFrames = 8192;
+
+    /**
+     * @brief  Ways of storing sample data in memory.
+     */
+    enum class Storage
+    {
+        // Store all sample data as floats, ready to mix:
+        decoded,
+        // Store sample data as 16-bit PCM, streamed to floats during
+        // playback:
+        pcm16
+    };
+
+    /**
+     * @brief  Controls how samples are trimmed, adjusted, and stored while
+     *         loading.
+     */
+    struct Processing
+    {
+        // Whether samples are trimmed at all:
+        bool trim = true;
+        // The level in decibels where a note's attack is considered to start:
+        float onsetThresholdDb = -50.0f;
+        // Time kept before each detected onset, in seconds:
+        double preOnsetSeconds = 0.001;
+        // The level in decibels below which tails are cut off:
+        float tailThresholdDb = -70.0f;
+        // The length of the fade applied where tails are cut, in seconds:
+        double tailFadeSeconds = 0.02;
+        // Whether notes are scaled so their attacks are equally loud:
+        bool normalise = false;
+        // The length of each note's attack used to measure loudness when
+        // normalising, in seconds:
+        double attackSeconds = 0.1;
+        // How sample data is stored in memory:
+        Storage storage = Storage::decoded;
+        // The pitch of each recorded sample as a MIDI note number, in asset
+        // order. If this or notePitches is empty, each sample plays the
+        // note with the same index, and no notes are generated:
+        juce::Array<double> samplePitches;
+        // The pitch of each note in the bank as a MIDI note number, which
+        // may include fractions of a semitone for other tunings:
+        juce::Array<double> notePitches;
+    };
+
+    /**
+     * @brief  Decodes and converts all note samples.
+     *
+     * @param assetNames  The asset name of each note's audio sample, in note
+     *                    order.
+     *
+     * @param sampleRate  The output sample rate to convert all samples to.
+     *
+     * @param processing  Controls how samples are trimmed and adjusted.
+     */
+    SampleBank(const juce::StringArray& assetNames, const double sampleRate,
+            const Processing& processing);
+
+    /**
+     * @brief  Decodes and converts all note samples, using the default sample
+     *         processing.
+     *
+     * @param assetNames  The asset name of each note's audio sample, in note
+     *                    order.
+     *
+     * @param sampleRate  The output sample rate to convert all samples to.
+     */
+    SampleBank(const juce::StringArray& assetNames, const double sampleRate);
+
+    virtual ~SampleBank() { }
+
+    /**
+     * @brief  Gets the asset names of the music box note samples.
+     *
+     * @return  The name of each note's sample asset, in note order.
+     */
+    static const juce::StringArray& getNoteAssetNames();
+
+    /**
+     * @brief  Gets the sample rate of all stored samples.
+     *
+     * @return  The output sample rate used when creating the bank.
+     */
+    double getSampleRate() const;
+
+    /**
+     * @brief  Gets the number of notes in the bank.
+     *
+     * @return  The number of note samples, including samples that failed to
+     *          load.
+     */
+    int getNumNotes() const;
+
+    /**
+     * @brief  Gets a note's sample data.
+     *
+     * @param note  The index of a note in the bank.
+     *
+     * @return      The note's sample data, or nullptr if the note is invalid
+     *              or failed to load. In streamed banks, this only holds
+     *              the note's preloaded frames.
+     */
+    const float* getSampleData(const int note) const;
+
+    /**
+     * @brief  Gets the number of frames of a note's sample data that are
+     *         stored as floats.
+     *
+     * @param note  The index of a note in the bank.
+     *
+     * @return      The number of frames available from getSampleData.
+     */
+    int getPreloadLength(const int note) const;
+
+    /**
+     * @brief  Gets a note's complete 16-bit sample data.
+     *
+     * @param note  The index of a note in the bank.
+     *
+     * @return      The note's sample data, or nullptr if the bank isn't
+     *              streamed or the note is invalid.
+     */
+    const juce::int16* getStreamData(const int note) const;
+
+    /**
+     * @brief  Checks if notes must be streamed during playback.
+     *
+     * @return  Whether sample data is stored as 16-bit PCM.
+     */
+    bool isStreamed() const;
+
+    /**
+     * @brief  Gets the length of a note's sample data.
+     *
+     * @param note  The index of a note in the bank.
+     *
+     * @return      The number of sample frames stored for the note, or zero if
+     *              the note is invalid or failed to load.
+     */
+    int getSampleLength(const int note) const;
+
+    /**
+     * @brief  Gets a note's decay envelope.
+     *
+     *  Each envelope value holds the peak absolute sample value from the
+     * start of its envelopeResolution frame section to the end of the sample,
+     * so a value below some level guarantees the rest of the sample never
+     * rises above that level.
+     *
+     * @param note  The index of a note in the bank.
+     *
+     * @return      The note's envelope, with one value for each section of
+     *              envelopeResolution frames, or nullptr if the note is
+     *              invalid or failed to load.
+     */
+    const float* getEnvelope(const int note) const;
+
+    /**
+     * @brief  Gets the recorded sample a note plays.
+     *
+     * @param note  The index of a note in the bank.
+     *
+     * @return      The index of the note's sample asset, or -1 if the note is
+     *              invalid.
+     */
+    int getSourceSample(const int note) const;
+
+    /**
+     * @brief  Checks if a note was generated by pitch-shifting a recorded
+     *         sample of another pitch.
+     *
+     * @param note  The index of a note in the bank.
+     *
+     * @return      Whether the note's sample was pitch-shifted.
+     */
+    bool isGeneratedNote(const int note) const;
+
+    /**
+     * @brief  Gets the pitch of every note, if the bank was given a pitch
+     *         layout.
+     *
+     * @return  Each note's fundamental frequency in Hz, in note order, or an
+     *          empty array if each note plays the sample with its index.
+     */
+    const juce::Array<double>& getNoteFrequencies() const;
+
+    /**
+     * @brief  Gets the amount of memory used to store one note's samples.
+     *
+     * @param note  The index of a note in the bank.
+     *
+     * @return      The size of the note's float and 16-bit sample data in
+     *              bytes, including alignment padding.
+     */
+    size_t getNoteMemorySize(const int note) const;
+
+    /**
+     * @brief  Gets the amount of memory used to store all samples.
+     *
+     * @return  The size of the bank's sample data in bytes, including both
+     *          float and 16-bit data.
+     */
+    size_t getMemorySize() const;
+
+    /**
+     * @brief  Gets the amount of memory the bank would use if samples weren't
+     *         trimmed.
+     *
+     * @return  The size of all untrimmed sample data in bytes, or zero if
+     *          the bank was mapped from a cache file.
+     */
+    size_t getUntrimmedMemorySize() const;
+
+    /**
+     * @brief  Checks if the bank's data is mapped from a cache file.
+     *
+     * @return  Whether the bank was loaded by a SampleCache.
+     */
+    bool isMemoryMapped() const;
+
+private:
+    // Only SampleCache may create empty banks and access their layout.
+    friend SampleCache;
+
+    /**
+     * @brief  Creates an empty bank, to be filled in by a SampleCache.
+     *
+     * @param sampleRate  The sample rate of the cached sample data.
+     */
+    explicit SampleBank(const double sampleRate);
+
+    /**
+     * @brief  Chooses the recorded sample each note plays, and how far it is
+     *         pitch-shifted.
+     *
+     * @param processing  Holds the sample and note pitches.
+     *
+     * @param numSamples  The number of recorded samples.
+     */
+    void findNoteSources(const Processing& processing, const int numSamples);
+
+    // The output sample rate:
+    double sampleRate;
+    // Holds all sample data, unless the bank is memory-mapped:
+    juce::HeapBlock<float> storage;
+    // Holds the bank's cache file, if the bank is memory-mapped:
+    std::unique_ptr<juce::MemoryMappedFile> mappedFile;
+    // The aligned start of the sample data:
+    const float* sampleData = nullptr;
+    // The number of frames between the start of the sample data and the end
+    // of the last note's aligned data:
+    int totalFrames = 0;
+    // The index of each note's first frame within the sample data:
+    juce::Array<int> offsets;
+    // The number of frames stored for each note:
+    juce::Array<int> lengths;
+    // The index of the recorded sample each note plays:
+    juce::Array<int> sourceSamples;
+    // The frequency ratio between each note and its recorded sample:
+    juce::Array<double> pitchRatios;
+    // Each note's fundamental frequency in Hz, if notes were given pitches:
+    juce::Array<double> noteFrequencies;
+    // Holds all 16-bit sample data, if the bank is streamed:
+    juce::HeapBlock<juce::int16> pcmData;
+    // The index of each note's first frame within the 16-bit data:
+    juce::Array<int> pcmOffsets;
+    // The number of frames stored in the 16-bit data:
+    int pcmFrames = 0;
+    // The number of floats allocated in the storage block:
+    size_t storageSize = 0;
+    // The size in bytes of all sample data before trimming:
+    size_t untrimmedSize = 0;
+    // Holds the decay envelopes of all notes, unless the bank is
+    // memory-mapped:
+    juce::HeapBlock<float> envelopes;
+    // The start of the envelope data:
+    const float* envelopeData = nullptr;
+    // The number of values in the envelope data:
+    int envelopeSize = 0;
+    // The index of each note's first value within the envelope data:
+    juce::Array<int> envelopeOffsets;
+
+    JUCE_DECLARE_NON_COPYABLE(SampleBank)
+};
@@ -0,0 +1,386 @@
+#include "Audio_SampleCache.h"
+#include "Assets.h"
+
+// Identifies sample cache files, and detects files written with a different
+// byte order:
+static const constexpr uint32 cacheMagic = 0x4D425343;
+
+// Sample and envelope data start on a multiple of this many bytes:
+static const constexpr int dataAlignment = 64;
+
+// The cache file extension:
+static const constexpr char* cacheExtension = ".cache";
+
+// The cache file name prefix:
+static const constexpr char* cachePrefix = "samples_";
+
+// The cache file name prefix for banks from sample kits:
+static const constexpr char* kitCachePrefix = "kit_";
+
+// Bytes between pages touched when preloading a mapped file:
+static const constexpr size_t pageSize = 4096;
+
+/**
+ * @brief  The fixed-size header at the start of each cache file.
+ *
+ *  The header is followed by three tables holding each note's data offset,
+ * data length, and envelope offset, then by the sample data and envelope
+ * data, each aligned to dataAlignment bytes.
+ */
+struct CacheHeader
+{
+    uint32 magic;
+    uint32 version;
+    int64 assetKey;
+    double sampleRate;
+    int32 numNotes;
+    int32 totalFrames;
+    int32 envelopeSize;
+    int32 reserved;
+    int64 untrimmedSize;
+};
+
+/**
+ * @brief  Rounds a byte offset up to the data alignment.
+ *
+ * @param offset  A byte offset within a cache file.
+ *
+ * @return        The aligned offset.
+ */
+static size_t alignedOffset(const size_t offset)
+{
+    return (offset + dataAlignment - 1) / dataAlignment * dataAlignment;
+}
+
+
+/**
+ * @brief  Adds data to a 64-bit FNV-1a hash.
+ *
+ * @param hash      The hash value to update.
+ *
+ * @param data      The data to add.
+ *
+ * @param numBytes  The size of the data in bytes.
+ */
+static void addToHash(uint64& hash, const void* data, const size_t numBytes)
+{
+    const uint8* bytes = static_cast<const uint8*>(data);
+    for (size_t i = 0; i < numBytes; i++)
+    {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+    }
+}
+
+
+/**
+ * @brief  Adds a value to a 64-bit FNV-1a hash.
+ *
+ * @param hash   The hash value to update.
+ *
+ * @param value  The value to add.
+ */
+template <typename ValueType>
+static void addToHash(uint64& hash, const ValueType value)
+{
+    addToHash(hash, &value, sizeof(ValueType));
+}
+
+
+// Creates a cache that stores files in a directory.
+Audio::SampleCache::SampleCache(const File& cacheDirectory) :
+cacheDirectory(cacheDirectory) { }
+
+
+// Creates a cache that stores files in the default directory.
+Audio::SampleCache::SampleCache() : SampleCache(getDefaultDirectory()) { }
+
+
+// Gets the directory where sample caches are stored by default.
+File Audio::SampleCache::getDefaultDirectory()
+{
+    return File::getSpecialLocation(File::userApplicationDataDirectory)
+            .getChildFile("MusicBox").getChildFile("SampleCache");
+}
+
+
+// Loads a sample bank from its cache file, or decodes it and saves a new
+// cache file if no valid cache file exists.
+Audio::SampleBank::Ptr Audio::SampleCache::loadBank(
+        const StringArray& assetNames, const double sampleRate,
+        const SampleBank::Processing& processing)
+{
+    return loadBank(String(), assetNames, sampleRate, processing);
+}
+
+
+// Loads a sample bank using the default sample processing.
+Audio::SampleBank::Ptr Audio::SampleCache::loadBank(
+        const StringArray& assetNames, const double sampleRate)
+{
+    return loadBank(assetNames, sampleRate, SampleBank::Processing());
+}
+
+
+// Loads a sample kit's bank from its cache file, or decodes it and saves a
+// new cache file if no valid cache file exists.
+Audio::SampleBank::Ptr Audio::SampleCache::loadBank(
+        const SampleKit& sampleKit, const double sampleRate)
+{
+    return loadBank(sampleKit.getId(), sampleKit.getSampleAssets(),
+            sampleRate, sampleKit.getProcessing());
+}
+
+
+// Loads a sample bank from a kit's cache file, or decodes it and saves a new
+// cache file.
+Audio::SampleBank::Ptr Audio::SampleCache::loadBank(const String& kitId,
+        const StringArray& assetNames, const double sampleRate,
+        const SampleBank::Processing& processing)
+{
+    if (processing.storage != SampleBank::Storage::decoded)
+    {
+        // Only fully decoded banks are cached, as streamed banks are meant
+        // to stay small in memory rather than load quickly:
+        return new SampleBank(assetNames, sampleRate, processing);
+    }
+    const int64 assetKey = getAssetKey(assetNames, processing);
+    SampleBank::Ptr sampleBank = mapBank(getCacheFile(kitId, assetKey,
+            sampleRate), assetKey, sampleRate);
+    if (sampleBank != nullptr)
+    {
+        // Cache files only store note data, not where it came from:
+        sampleBank->findNoteSources(processing, assetNames.size());
+        return sampleBank;
+    }
+    sampleBank = new SampleBank(assetNames, sampleRate, processing);
+    if (! saveBank(kitId, *sampleBank, assetKey))
+    {
+        DBG("SampleCache: failed to save sample cache to "
+                << cacheDirectory.getFullPathName());
+    }
+    return sampleBank;
+}
+
+
+// Finds the cache key for a set of sample assets.
+int64 Audio::SampleCache::getAssetKey(const StringArray& assetNames,
+        const SampleBank::Processing& processing)
+{
+    uint64 hash = 0xcbf29ce484222325ULL;
+    addToHash(hash, formatVersion);
+    addToHash(hash, processing.trim);
+    addToHash(hash, processing.onsetThresholdDb);
+    addToHash(hash, processing.preOnsetSeconds);
+    addToHash(hash, processing.tailThresholdDb);
+    addToHash(hash, processing.tailFadeSeconds);
+    addToHash(hash, processing.normalise);
+    addToHash(hash, processing.attackSeconds);
+    addToHash(hash, processing.samplePitches.size());
+    for (const double& pitch : processing.samplePitches)
+    {
+        addToHash(hash, pitch);
+    }
+    addToHash(hash, processing.notePitches.size());
+    for (const double& pitch : processing.notePitches)
+    {
+        addToHash(hash, pitch);
+    }
+    HeapBlock<char> buffer(pageSize * 16);
+    for (const String& assetName : assetNames)
+    {
+        addToHash(hash, assetName.toRawUTF8(),
+                assetName.getNumBytesAsUTF8());
+        std::unique_ptr<InputStream> assetStream
+                = Assets::createAssetInputStream(assetName);
+        if (assetStream == nullptr)
+        {
+            addToHash(hash, (int64) -1);
+            continue;
+        }
+        addToHash(hash, assetStream->getTotalLength());
+        int bytesRead;
+        while ((bytesRead = assetStream->read(buffer, pageSize * 16)) > 0)
+        {
+            addToHash(hash, buffer, (size_t) bytesRead);
+        }
+    }
+    return (int64) hash;
+}
+
+
+// Gets the file used to cache a sample bank.
+File Audio::SampleCache::getCacheFile(const String& kitId,
+        const int64 assetKey, const double sampleRate) const
+{
+    const String prefix = kitId.isEmpty() ? String(cachePrefix)
+            : kitCachePrefix + kitId + "_";
+    return cacheDirectory.getChildFile(prefix
+            + String::toHexString(assetKey).paddedLeft('0', 16) + "_"
+            + String(roundToInt(sampleRate)) + cacheExtension);
+}
+
+
+// Maps a sample bank from a cache file, checking that the file is valid and
+// matches the expected key and rate.
+Audio::SampleBank::Ptr Audio::SampleCache::mapBank(const File& cacheFile,
+        const int64 assetKey, const double sampleRate)
+{
+    if (! cacheFile.existsAsFile())
+    {
+        return nullptr;
+    }
+    std::unique_ptr<MemoryMappedFile> mappedFile(new MemoryMappedFile(
+            cacheFile, MemoryMappedFile::readOnly));
+    const char* fileData = static_cast<const char*>(mappedFile->getData());
+    const size_t fileSize = mappedFile->getSize();
+    if (fileData == nullptr || fileSize < sizeof(CacheHeader))
+    {
+        return nullptr;
+    }
+    CacheHeader header;
+    memcpy(&header, fileData, sizeof(CacheHeader));
+    if (header.magic != cacheMagic || header.version != formatVersion
+            || header.assetKey != assetKey || header.sampleRate != sampleRate
+            || header.numNotes < 0 || header.totalFrames < 0
+            || header.envelopeSize < 0)
+    {
+        DBG("SampleCache: ignoring outdated cache file "
+                << cacheFile.getFileName());
+        return nullptr;
+    }
+    const size_t tableSize = sizeof(int32) * 3 * (size_t) header.numNotes;
+    const size_t dataStart = alignedOffset(sizeof(CacheHeader) + tableSize);
+    const size_t envelopeStart = alignedOffset(dataStart
+            + sizeof(float) * (size_t) header.totalFrames);
+    const size_t expectedSize = envelopeStart
+            + sizeof(float) * (size_t) header.envelopeSize;
+    if (fileSize != expectedSize)
+    {
+        DBG("SampleCache: ignoring truncated cache file "
+                << cacheFile.getFileName());
+        return nullptr;
+    }
+
+    SampleBank::Ptr sampleBank = new SampleBank(sampleRate);
+    const int32* table = reinterpret_cast<const int32*>(fileData
+            + sizeof(CacheHeader));
+    for (int i = 0; i < header.numNotes; i++)
+    {
+        const int32 offset = table[i];
+        const int32 length = table[header.numNotes + i];
+        const int32 envelopeOffset = table[2 * header.numNotes + i];
+        const int32 envelopeLength = (length
+                + SampleBank::envelopeResolution - 1)
+                / SampleBank::envelopeResolution;
+        if (offset < 0 || length < 0 || offset > header.totalFrames - length
+                || envelopeOffset < 0
+                || envelopeOffset > header.envelopeSize - envelopeLength)
+        {
+            DBG("SampleCache: ignoring invalid cache file "
+                    << cacheFile.getFileName());
+            return nullptr;
+        }
+        sampleBank->offsets.add(offset);
+        sampleBank->lengths.add(length);
+        sampleBank->envelopeOffsets.add(envelopeOffset);
+    }
+    sampleBank->sampleData = reinterpret_cast<const float*>(fileData
+            + dataStart);
+    sampleBank->totalFrames = header.totalFrames;
+    sampleBank->storageSize = (size_t) header.totalFrames;
+    sampleBank->untrimmedSize = (size_t) header.untrimmedSize;
+    sampleBank->envelopeData = reinterpret_cast<const float*>(fileData
+            + envelopeStart);
+    sampleBank->envelopeSize = header.envelopeSize;
+
+    // Touch every page now, so the audio thread never waits on a page fault
+    // the first time it plays a note:
+    volatile char pageSum = 0;
+    for (size_t i = 0; i < fileSize; i += pageSize)
+    {
+        pageSum += fileData[i];
+    }
+    sampleBank->mappedFile = std::move(mappedFile);
+    DBG("SampleCache: mapped " << header.numNotes << " samples at "
+            << sampleRate << "Hz from " << cacheFile.getFileName());
+    return sampleBank;
+}
+
+
+// Saves a sample bank to a cache file, replacing any other cache files for
+// the same sample rate.
+bool Audio::SampleCache::saveBank(const String& kitId,
+        const SampleBank& sampleBank, const int64 assetKey) const
+{
+    if (! cacheDirectory.createDirectory().wasOk())
+    {
+        return false;
+    }
+    const File cacheFile = getCacheFile(kitId, assetKey,
+            sampleBank.sampleRate);
+    CacheHeader header = {};
+    header.magic = cacheMagic;
+    header.version = formatVersion;
+    header.assetKey = assetKey;
+    header.sampleRate = sampleBank.sampleRate;
+    header.numNotes = sampleBank.lengths.size();
+    header.totalFrames = sampleBank.totalFrames;
+    header.envelopeSize = sampleBank.envelopeSize;
+    header.untrimmedSize = (int64) sampleBank.untrimmedSize;
+
+    // Write to a temporary file first, so a partly written cache is never
+    // mapped:
+    TemporaryFile tempFile(cacheFile);
+    {
+        std::unique_ptr<FileOutputStream> output(
+                tempFile.getFile().createOutputStream());
+        if (output == nullptr || output->failedToOpen())
+        {
+            return false;
+        }
+        output->write(&header, sizeof(CacheHeader));
+        const Array<int>* tables[] = { &sampleBank.offsets,
+                &sampleBank.lengths, &sampleBank.envelopeOffsets };
+        for (const Array<int>* table : tables)
+        {
+            for (const int& value : *table)
+            {
+                const int32 tableValue = value;
+                output->write(&tableValue, sizeof(int32));
+            }
+        }
+        output->writeRepeatedByte(0, alignedOffset((size_t)
+                output->getPosition()) - (size_t) output->getPosition());
+        output->write(sampleBank.sampleData,
+                sizeof(float) * (size_t) sampleBank.totalFrames);
+        output->writeRepeatedByte(0, alignedOffset((size_t)
+                output->getPosition()) - (size_t) output->getPosition());
+        output->write(sampleBank.envelopeData,
+                sizeof(float) * (size_t) sampleBank.envelopeSize);
+        output->flush();
+        if (output->getStatus().failed())
+        {
+            return false;
+        }
+    }
+    if (! tempFile.overwriteTargetFileWithTemporary())
+    {
+        return false;
+    }
+
+    // Remove caches for this kit and rate that were made from different
+    // assets:
+    const String rateSuffix = "_" + String(roundToInt(sampleBank.sampleRate))
+            + cacheExtension;
+    const String prefix = kitId.isEmpty() ? String(cachePrefix)
+            : kitCachePrefix + kitId + "_";
+    for (const File& oldFile : cacheDirectory.findChildFiles(
+            File::findFiles, false, prefix + "*" + rateSuffix))
+    {
+        if (oldFile != cacheFile)
+        {
+            oldFile.deleteFile();
+        }
+    }
+    return true;
+}
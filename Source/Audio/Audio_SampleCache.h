@@ -0,0 +1,183 @@
+#pragma once
+/**
+ * @file  Audio_SampleCache.h
+ *
+ * @brief  Saves decoded sample banks to disk, so later launches can map them
+ *         into memory instead of decoding them again.
+ */
+
+#include "JuceHeader.h"
+#include "Audio_SampleBank.h"
+#include "Audio_SampleKit.h"
+
+namespace Audio { class SampleCache; }
+
+/**
+ * @brief  Stores decoded sample banks in versioned binary cache files.
+ *
+ *  Each cache file holds one bank's note layout, sample data, and decay
+ * envelopes, laid out so the file can be memory-mapped and used directly.
+ * Files are keyed by a hash of the source asset data and sample processing
+ * options, and by the output sample rate. Whenever the assets, processing
+ * options, sample rate, or cache format change, the old file no longer
+ * matches, so the bank is decoded again and the stale file is replaced.
+ * Each sample kit keeps its own cache files, so switching kits never
+ * replaces another kit's cache. Only fully decoded banks are cached.
+ */
+class Audio::SampleCache
+{
+public:
+    // Increase this whenever the cache file layout or the way samples are
+    // processed changes:
+    static const constexpr juce::uint32 formatVersion = 2;
+
+    /**
+     * @brief  Creates a cache that stores files in a directory.
+     *
+     * @param cacheDirectory  The directory holding cache files. It will be
+     *                        created if needed when the first file is saved.
+     */
+    SampleCache(const juce::File& cacheDirectory);
+
+    /**
+     * @brief  Creates a cache that stores files in the default directory.
+     */
+    SampleCache();
+
+    virtual ~SampleCache() { }
+
+    /**
+     * @brief  Gets the directory where sample caches are stored by default.
+     *
+     * @return  A directory within the user's application data directory.
+     */
+    static juce::File getDefaultDirectory();
+
+    /**
+     * @brief  Loads a sample bank from its cache file, or decodes it and
+     *         saves a new cache file if no valid cache file exists.
+     *
+     * @param assetNames  The asset name of each note's audio sample, in note
+     *                    order.
+     *
+     * @param sampleRate  The output sample rate.
+     *
+     * @param processing  Controls how samples are trimmed and adjusted.
+     *
+     * @return            The loaded bank, which may be memory-mapped.
+     */
+    SampleBank::Ptr loadBank(const juce::StringArray& assetNames,
+            const double sampleRate,
+            const SampleBank::Processing& processing);
+
+    /**
+     * @brief  Loads a sample bank using the default sample processing.
+     *
+     * @param assetNames  The asset name of each note's audio sample, in note
+     *                    order.
+     *
+     * @param sampleRate  The output sample rate.
+     *
+     * @return            The loaded bank, which may be memory-mapped.
+     */
+    SampleBank::Ptr loadBank(const juce::StringArray& assetNames,
+            const double sampleRate);
+
+    /**
+     * @brief  Loads a sample kit's bank from its cache file, or decodes it
+     *         and saves a new cache file if no valid cache file exists.
+     *
+     * @param sampleKit   The kit's samples and processing options.
+     *
+     * @param sampleRate  The output sample rate.
+     *
+     * @return            The loaded bank, which may be memory-mapped.
+     */
+    SampleBank::Ptr loadBank(const SampleKit& sampleKit,
+            const double sampleRate);
+
+    /**
+     * @brief  Finds the cache key for a set of sample assets.
+     *
+     * @param assetNames  The asset name of each note's audio sample, in note
+     *                    order.
+     *
+     * @param processing  Controls how samples are trimmed and adjusted.
+     *
+     * @return            A hash of all asset data, the processing options,
+     *                    and the cache format version.
+     */
+    static juce::int64 getAssetKey(const juce::StringArray& assetNames,
+            const SampleBank::Processing& processing);
+
+    /**
+     * @brief  Gets the file used to cache a sample bank.
+     *
+     * @param kitId       The ID of the bank's sample kit, or the empty string
+     *                    for banks using the default samples.
+     *
+     * @param assetKey    The bank's asset key.
+     *
+     * @param sampleRate  The bank's sample rate.
+     *
+     * @return            The cache file, which may not exist yet.
+     */
+    juce::File getCacheFile(const juce::String& kitId,
+            const juce::int64 assetKey, const double sampleRate) const;
+
+private:
+    /**
+     * @brief  Loads a sample bank from a kit's cache file, or decodes it and
+     *         saves a new cache file.
+     *
+     * @param kitId       The ID of the bank's sample kit.
+     *
+     * @param assetNames  The asset name of each note's audio sample, in note
+     *                    order.
+     *
+     * @param sampleRate  The output sample rate.
+     *
+     * @param processing  Controls how samples are trimmed and adjusted.
+     *
+     * @return            The loaded bank, which may be memory-mapped.
+     */
+    SampleBank::Ptr loadBank(const juce::String& kitId,
+            const juce::StringArray& assetNames, const double sampleRate,
+            const SampleBank::Processing& processing);
+
+    /**
+     * @brief  Maps a sample bank from a cache file, checking that the file is
+     *         valid and matches the expected key and rate.
+     *
+     * @param cacheFile   The bank's cache file.
+     *
+     * @param assetKey    The expected asset key.
+     *
+     * @param sampleRate  The expected sample rate.
+     *
+     * @return            The mapped bank, or nullptr if the file is missing
+     *                    or invalid.
+     */
+    static SampleBank::Ptr mapBank(const juce::File& cacheFile,
+            const juce::int64 assetKey, const double sampleRate);
+
+    /**
+     * @brief  Saves a sample bank to a cache file, replacing any other cache
+     *         files for the same kit and sample rate.
+     *
+     * @param kitId       The ID of the bank's sample kit.
+     *
+     * @param sampleBank  A bank decoded from its assets.
+     *
+     * @param assetKey    The bank's asset key.
+     *
+     * @return            Whether the file was written.
+     */
+    bool saveBank(const juce::String& kitId, const SampleBank& sampleBank,
+            const juce::int64 assetKey) const;
+
+    // The directory holding cache files:
+    juce::File cacheDirectory;
+
+    JUCE_DECLARE_NON_COPYABLE(SampleCache)
+};
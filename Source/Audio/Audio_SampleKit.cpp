@@ -0,0 +1,233 @@
+#include "Audio_SampleKit.h"
+
+// The directory within the system temp directory where archives are
+// extracted:
+static const constexpr char* extractDirectoryName = "MusicBoxKits";
+
+/**
+ * @brief  Checks if a manifest value is a number.
+ *
+ * @param value  A value parsed from a kit manifest.
+ *
+ * @return       Whether the value holds an integer or decimal number.
+ */
+static bool isNumber(const var& value)
+{
+    return value.isInt() || value.isInt64() || value.isDouble();
+}
+
+
+// Creates the default kit, which plays the built-in samples.
+Audio::SampleKit::SampleKit() :
+name("Music box"), sampleAssets(SampleBank::getNoteAssetNames())
+{
+    jassert(sampleAssets.size() == numNotes);
+}
+
+
+// Replaces this kit with one loaded from a kit manifest.
+Result Audio::SampleKit::loadFromFile(const File& kitFile)
+{
+    if (! kitFile.exists())
+    {
+        return Result::fail("Kit not found: " + kitFile.getFullPathName());
+    }
+    const String kitId = String::toHexString(
+            kitFile.getFullPathName().hashCode64()).paddedLeft('0', 16);
+    Result result = Result::ok();
+    const File manifest = findManifest(kitFile, kitId, result);
+    if (result.failed())
+    {
+        return result;
+    }
+    var manifestData;
+    result = JSON::parse(manifest.loadFileAsString(), manifestData);
+    if (result.failed())
+    {
+        return Result::fail("Invalid kit manifest "
+                + manifest.getFullPathName() + ": "
+                + result.getErrorMessage());
+    }
+    const Array<var>* noteFiles = manifestData["notes"].getArray();
+    const Array<var>* notePitches = manifestData["pitches"].getArray();
+    SampleBank::Processing kitProcessing;
+    if (notePitches == nullptr)
+    {
+        if (noteFiles == nullptr || noteFiles->size() != numNotes)
+        {
+            return Result::fail("Kit manifest must list exactly "
+                    + String(numNotes) + " note files, or a pitch layout");
+        }
+    }
+    else
+    {
+        if (notePitches->isEmpty() || notePitches->size() > maxNotes)
+        {
+            return Result::fail("Kit pitch layouts must hold between 1 and "
+                    + String(maxNotes) + " notes");
+        }
+        if (noteFiles == nullptr || noteFiles->isEmpty())
+        {
+            return Result::fail("Kit manifest must list at least one sample");
+        }
+        for (const var& pitch : *notePitches)
+        {
+            if (! isNumber(pitch))
+            {
+                return Result::fail("Invalid kit note pitch \""
+                        + pitch.toString() + "\"");
+            }
+            kitProcessing.notePitches.add(pitch);
+        }
+    }
+    StringArray kitAssets;
+    for (const var& noteFile : *noteFiles)
+    {
+        // Pitch layouts describe each sample with its path and pitch:
+        const var path = (notePitches == nullptr) ? noteFile
+                : noteFile["file"];
+        const File sampleFile = manifest.getSiblingFile(path.toString());
+        if (! path.isString() || ! sampleFile.existsAsFile())
+        {
+            return Result::fail("Missing kit sample: "
+                    + sampleFile.getFullPathName());
+        }
+        if (notePitches != nullptr)
+        {
+            const var pitch = noteFile["pitch"];
+            if (! isNumber(pitch))
+            {
+                return Result::fail("Kit sample " + path.toString()
+                        + " needs a numeric pitch");
+            }
+            kitProcessing.samplePitches.add(pitch);
+        }
+        kitAssets.add(sampleFile.getFullPathName());
+    }
+    const var storage = manifestData["storage"];
+    if (storage.toString() == "pcm16")
+    {
+        kitProcessing.storage = SampleBank::Storage::pcm16;
+    }
+    else if (! storage.isVoid() && storage.toString() != "decoded")
+    {
+        return Result::fail("Unknown kit storage \"" + storage.toString()
+                + "\"");
+    }
+    kitProcessing.trim = manifestData.getProperty("trim", kitProcessing.trim);
+    kitProcessing.normalise = manifestData.getProperty("normalise",
+            kitProcessing.normalise);
+
+    name = manifestData.getProperty("name",
+            kitFile.getFileNameWithoutExtension()).toString();
+    sampleAssets = kitAssets;
+    processing = kitProcessing;
+    id = kitId;
+    return Result::ok();
+}
+
+
+// Gets the kit's display name.
+const String& Audio::SampleKit::getName() const
+{
+    return name;
+}
+
+
+// Gets the asset name or path of each note's sample file.
+const StringArray& Audio::SampleKit::getSampleAssets() const
+{
+    return sampleAssets;
+}
+
+
+// Gets the number of notes the kit plays.
+int Audio::SampleKit::getNumNotes() const
+{
+    return processing.notePitches.isEmpty() ? sampleAssets.size()
+            : processing.notePitches.size();
+}
+
+
+// Gets the options used when creating banks from the kit.
+const Audio::SampleBank::Processing& Audio::SampleKit::getProcessing() const
+{
+    return processing;
+}
+
+
+// Sets the options used when creating banks from the kit.
+void Audio::SampleKit::setProcessing(const SampleBank::Processing& processing)
+{
+    this->processing = processing;
+}
+
+
+// Gets a short ID that distinguishes the kit's cached banks from those of
+// other kits.
+const String& Audio::SampleKit::getId() const
+{
+    return id;
+}
+
+
+// Checks if this is the default kit.
+bool Audio::SampleKit::isDefault() const
+{
+    return id.isEmpty();
+}
+
+
+// Finds the manifest file for a kit, extracting the kit first if it is an
+// archive.
+File Audio::SampleKit::findManifest(const File& kitFile, const String& id,
+        Result& result)
+{
+    File kitDirectory = kitFile;
+    if (kitFile.getFileName() == manifestName)
+    {
+        return kitFile;
+    }
+    if (kitFile.hasFileExtension(".zip"))
+    {
+        // Archives are extracted again whenever they change:
+        kitDirectory = File::getSpecialLocation(File::tempDirectory)
+                .getChildFile(extractDirectoryName).getChildFile(id + "_"
+                + String::toHexString(kitFile.getLastModificationTime()
+                    .toMilliseconds()));
+        if (! kitDirectory.isDirectory())
+        {
+            // Extract next to the final directory, so a partly extracted kit
+            // is never used:
+            const File extracting = kitDirectory.getSiblingFile(
+                    kitDirectory.getFileName() + "_extracting");
+            extracting.deleteRecursively();
+            ZipFile archive(kitFile);
+            result = archive.uncompressTo(extracting);
+            if (result.failed() || ! extracting.moveFileTo(kitDirectory))
+            {
+                extracting.deleteRecursively();
+                result = Result::fail("Failed to extract kit archive "
+                        + kitFile.getFullPathName() + ": "
+                        + result.getErrorMessage());
+                return File();
+            }
+        }
+    }
+    if (kitDirectory.getChildFile(manifestName).existsAsFile())
+    {
+        return kitDirectory.getChildFile(manifestName);
+    }
+    // Archives often hold a single directory containing the kit:
+    for (const File& subdirectory : kitDirectory.findChildFiles(
+            File::findDirectories, false))
+    {
+        if (subdirectory.getChildFile(manifestName).existsAsFile())
+        {
+            return subdirectory.getChildFile(manifestName);
+        }
+    }
+    result = Result::fail("No " + String(manifestName) + " found in "
+            + kitFile.getFullPathName());
+    return File();
+}
@@ -0,0 +1,151 @@
+#pragma once
+/**
+ * @file  Audio_SampleKit.h
+ *
+ * @brief  Describes a set of note samples and how they should be loaded.
+ */
+
+#include "JuceHeader.h"
+#include "Audio_SampleBank.h"
+
+namespace Audio { class SampleKit; }
+
+/**
+ * @brief  Lists the sample file for each music box note, along with the
+ *         processing options used when creating a SampleBank from them.
+ *
+ *  The default kit plays the built-in music box samples. Other kits are
+ * loaded from a manifest file named kit.json, found either in a kit
+ * directory or in a .zip archive. Archives are extracted to a temporary
+ * directory the first time they are loaded. The manifest is a JSON object
+ * with these properties:
+ *
+ *  - "notes": An array with one sample file path for each note, in note
+ *             order. Paths are relative to the manifest's directory. Kits
+ *             with a "pitches" layout instead list one object for each
+ *             recorded sample, holding the sample's "file" path and its
+ *             MIDI "pitch".
+ *  - "pitches": An optional array with the MIDI pitch of each note the kit
+ *               plays, in note order. Pitches may include fractions of a
+ *               semitone for other tunings. Notes with no sample recorded
+ *               at their pitch are generated from the sample with the
+ *               nearest pitch. Without this, kits must list exactly numNotes
+ *               samples.
+ *  - "name": The kit's display name. This is optional, and defaults to the
+ *            kit's file name.
+ *  - "storage": Either "decoded" or "pcm16". This is optional, and selects
+ *               the kit's SampleBank::Storage.
+ *  - "trim", "normalise": Optional boolean sample processing options.
+ *
+ *  Kits are small value objects, so they may be freely copied between
+ * threads.
+ */
+class Audio::SampleKit
+{
+public:
+    // The number of notes in the default layout, played by the built-in
+    // samples and by kits without a "pitches" layout:
+    static const constexpr int numNotes = 15;
+    // The largest number of notes a kit's layout may hold:
+    static const constexpr int maxNotes = 128;
+    // The name of the manifest file in every kit:
+    static const constexpr char* manifestName = "kit.json";
+
+    /**
+     * @brief  Creates the default kit, which plays the built-in samples.
+     */
+    SampleKit();
+
+    virtual ~SampleKit() { }
+
+    /**
+     * @brief  Replaces this kit with one loaded from a kit manifest. This may
+     *         take some time when loading an archive, so it should not be
+     *         called on the message thread.
+     *
+     * @param kitFile  A kit directory, a kit.json manifest, or a .zip
+     *                 archive holding a kit.
+     *
+     * @return         Whether the kit was loaded, and if not, why. The kit is
+     *                 left unchanged if loading failed.
+     */
+    juce::Result loadFromFile(const juce::File& kitFile);
+
+    /**
+     * @brief  Gets the kit's display name.
+     *
+     * @return  The name given in the manifest, or the kit file's name.
+     */
+    const juce::String& getName() const;
+
+    /**
+     * @brief  Gets the asset name or path of each note's sample file.
+     *
+     * @return  One sample asset for each note, in note order.
+     */
+    const juce::StringArray& getSampleAssets() const;
+
+    /**
+     * @brief  Gets the number of notes the kit plays.
+     *
+     * @return  The number of notes in the kit's layout.
+     */
+    int getNumNotes() const;
+
+    /**
+     * @brief  Gets the options used when creating banks from the kit.
+     *
+     * @return  The kit's sample processing options.
+     */
+    const SampleBank::Processing& getProcessing() const;
+
+    /**
+     * @brief  Sets the options used when creating banks from the kit.
+     *
+     * @param processing  The new sample processing options.
+     */
+    void setProcessing(const SampleBank::Processing& processing);
+
+    /**
+     * @brief  Gets a short ID that distinguishes the kit's cached banks from
+     *         those of other kits.
+     *
+     * @return  An empty string for the default kit, or a hash of the kit
+     *          file's path.
+     */
+    const juce::String& getId() const;
+
+    /**
+     * @brief  Checks if this is the default kit.
+     *
+     * @return  Whether the kit plays the built-in samples.
+     */
+    bool isDefault() const;
+
+private:
+    /**
+     * @brief  Finds the manifest file for a kit, extracting the kit first if
+     *         it is an archive.
+     *
+     * @param kitFile  A kit directory, manifest, or archive.
+     *
+     * @param id       The ID of the kit, used to name its extraction
+     *                 directory.
+     *
+     * @param result   Used to return an error if the manifest couldn't be
+     *                 found.
+     *
+     * @return         The kit's manifest file.
+     */
+    static juce::File findManifest(const juce::File& kitFile,
+            const juce::String& id, juce::Result& result);
+
+    // The kit's display name:
+    juce::String name;
+    // Each note's sample asset name or absolute path:
+    juce::StringArray sampleAssets;
+    // How banks created from the kit are processed:
+    SampleBank::Processing processing;
+    // Distinguishes the kit from other kits, or empty for the default kit:
+    juce::String id;
+};
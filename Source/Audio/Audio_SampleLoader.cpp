@@ -0,0 +1,209 @@
+#include "Audio_SampleLoader.h"
+
+// Milliseconds to wait for a loading bank to finish before forcing the thread
+// to stop:
+static const constexpr int stopTimeout = 10000;
+
+// Starts the loading thread.
+Audio::SampleLoader::SampleLoader(Listener& listener) :
+Thread("SampleLoader"), listener(listener)
+{
+    startThread();
+}
+
+
+// Waits for any bank being loaded to finish, then stops the loading thread.
+Audio::SampleLoader::~SampleLoader()
+{
+    signalThreadShouldExit();
+    notify();
+    stopThread(stopTimeout);
+    cancelPendingUpdate();
+}
+
+
+// Requests a new sample bank.
+void Audio::SampleLoader::loadSamples(const double sampleRate)
+{
+    jassert(sampleRate > 0);
+    {
+        const ScopedLock requestLock(lock);
+        double pendingRate = requestedRate;
+        if (pendingRate == 0)
+        {
+            pendingRate = loadingRate;
+        }
+        if (pendingRate == 0 && loadedBank != nullptr)
+        {
+            pendingRate = loadedBank->getSampleRate();
+        }
+        if (pendingRate == sampleRate)
+        {
+            return;
+        }
+        requestedRate = sampleRate;
+        lastRequestedRate = sampleRate;
+        loading = true;
+    }
+    notify();
+}
+
+
+// Requests a new sample kit, loading a bank from it at the last requested
+// sample rate once the kit is read.
+void Audio::SampleLoader::loadKit(const File& kitFile)
+{
+    {
+        const ScopedLock requestLock(lock);
+        requestedKitFile = kitFile;
+        loading = true;
+    }
+    notify();
+}
+
+
+// Changes how the current kit's samples are stored, reloading the last
+// requested bank with the new storage.
+bool Audio::SampleLoader::setStorage(const SampleBank::Storage storage)
+{
+    {
+        const ScopedLock requestLock(lock);
+        SampleBank::Processing processing = kit.getProcessing();
+        processing.storage = storage;
+        kit.setProcessing(processing);
+        if (lastRequestedRate <= 0)
+        {
+            return false;
+        }
+        requestedRate = lastRequestedRate;
+        loading = true;
+    }
+    notify();
+    return true;
+}
+
+
+// Gets the name of the kit used to load banks.
+String Audio::SampleLoader::getKitName() const
+{
+    const ScopedLock requestLock(lock);
+    return kit.getName();
+}
+
+
+// Checks if a requested bank hasn't yet been delivered to the listener.
+bool Audio::SampleLoader::isLoading() const
+{
+    return loading.load();
+}
+
+
+// Loads each requested bank until the thread is told to exit.
+void Audio::SampleLoader::run()
+{
+    while (! threadShouldExit())
+    {
+        double sampleRate;
+        File kitFile;
+        SampleKit bankKit;
+        {
+            const ScopedLock requestLock(lock);
+            sampleRate = requestedRate;
+            kitFile = requestedKitFile;
+            bankKit = kit;
+            requestedRate = 0;
+            requestedKitFile = File();
+            loadingRate = sampleRate;
+        }
+        if (kitFile != File())
+        {
+            // The kit copy is left unchanged if the new kit fails to load:
+            const Result kitResult = bankKit.loadFromFile(kitFile);
+            const ScopedLock requestLock(lock);
+            if (requestedKitFile != File())
+            {
+                // A newer kit was requested while this one loaded, so skip
+                // straight to the newer kit without losing the rate request:
+                if (requestedRate == 0)
+                {
+                    requestedRate = sampleRate;
+                }
+                loadingRate = 0;
+                continue;
+            }
+            if (kitResult.failed())
+            {
+                DBG("SampleLoader: " << kitResult.getErrorMessage());
+                kitError = kitResult;
+            }
+            else
+            {
+                kit = bankKit;
+                if (sampleRate <= 0)
+                {
+                    sampleRate = lastRequestedRate;
+                    loadingRate = sampleRate;
+                }
+            }
+            triggerAsyncUpdate();
+        }
+        if (sampleRate <= 0)
+        {
+            if (kitFile == File())
+            {
+                wait(-1);
+            }
+            continue;
+        }
+        // Banks are mapped from the sample cache when possible, and only
+        // decoded if the cache is missing or outdated:
+        SampleBank::Ptr sampleBank = sampleCache.loadBank(bankKit,
+                sampleRate);
+        for (int note = 0; note < sampleBank->getNumNotes(); note++)
+        {
+            if (sampleBank->isGeneratedNote(note))
+            {
+                DBG("SampleLoader: generated note " << note << " from sample "
+                        << sampleBank->getSourceSample(note) << ", using "
+                        << (int) (sampleBank->getNoteMemorySize(note) / 1024)
+                        << " KB");
+            }
+        }
+        const ScopedLock requestLock(lock);
+        loadingRate = 0;
+        // Only deliver the bank if no newer request arrived while loading:
+        if (requestedRate == 0 && requestedKitFile == File())
+        {
+            loadedBank = sampleBank;
+        }
+        triggerAsyncUpdate();
+    }
+}
+
+
+// Passes the last loaded bank to the listener on the message thread.
+void Audio::SampleLoader::handleAsyncUpdate()
+{
+    SampleBank::Ptr sampleBank;
+    Result error = Result::ok();
+    {
+        const ScopedLock requestLock(lock);
+        sampleBank = loadedBank;
+        loadedBank = nullptr;
+        error = kitError;
+        kitError = Result::ok();
+        if (requestedRate == 0 && loadingRate == 0
+                && requestedKitFile == File())
+        {
+            loading = false;
+        }
+    }
+    if (error.failed())
+    {
+        listener.sampleKitFailed(error);
+    }
+    if (sampleBank != nullptr)
+    {
+        listener.sampleBankLoaded(sampleBank);
+    }
+}
@@ -0,0 +1,163 @@
+#pragma once
+/**
+ * @file  Audio_SampleLoader.h
+ *
+ * @brief  Creates sample banks on a background thread.
+ */
+
+#include "JuceHeader.h"
+#include "Audio_SampleBank.h"
+#include "Audio_SampleCache.h"
+#include "Audio_SampleKit.h"
+#include <atomic>
+
+namespace Audio { class SampleLoader; }
+
+/**
+ * @brief  Decodes note samples on a dedicated thread, so that neither the
+ *         message thread nor the audio device has to wait for samples to load.
+ *
+ *  Each call to loadSamples replaces any request that hasn't started yet. If
+ * a new request arrives while a bank is loading, the loading bank is
+ * discarded once it finishes, so only the most recently requested bank is
+ * ever delivered. Finished banks are passed to the loader's listener on the
+ * message thread. Banks are read from a SampleCache, so samples are only
+ * decoded when no valid cache file exists.
+ *
+ *  Banks are created from the loader's current SampleKit. New kits are also
+ * read on the loading thread, and once a kit loads, it replaces the current
+ * kit and a new bank is loaded from it. If a kit fails to load, the listener
+ * is notified and the current kit is kept.
+ */
+class Audio::SampleLoader : private juce::Thread, private juce::AsyncUpdater
+{
+public:
+    /**
+     * @brief  An abstract basis for classes that receive loaded sample banks.
+     */
+    class Listener
+    {
+    public:
+        // Only SampleLoader may call sampleBankLoaded()
+        friend SampleLoader;
+
+        Listener() { }
+
+        virtual ~Listener() { }
+
+    private:
+        /**
+         * @brief  Receives a newly loaded sample bank on the message thread.
+         *
+         * @param sampleBank  The bank created for the last loadSamples
+         *                    request.
+         */
+        virtual void sampleBankLoaded(SampleBank::Ptr sampleBank) = 0;
+
+        /**
+         * @brief  Receives the reason a requested kit couldn't be loaded, on
+         *         the message thread.
+         *
+         * @param error  The failed result of loading the kit.
+         */
+        virtual void sampleKitFailed(const juce::Result& error) = 0;
+    };
+
+    /**
+     * @brief  Starts the loading thread.
+     *
+     * @param listener  The object that will receive all loaded banks. It
+     *                  must remain valid until the loader is destroyed.
+     */
+    SampleLoader(Listener& listener);
+
+    /**
+     * @brief  Waits for any bank being loaded to finish, then stops the
+     *         loading thread.
+     */
+    virtual ~SampleLoader();
+
+    /**
+     * @brief  Requests a new sample bank. This may be called on any thread.
+     *         Requests for the rate that is already being loaded are ignored.
+     *
+     * @param sampleRate  The sample rate the new bank should use.
+     */
+    void loadSamples(const double sampleRate);
+
+    /**
+     * @brief  Requests a new sample kit, loading a bank from it at the last
+     *         requested sample rate once the kit is read. This may be called
+     *         on any thread.
+     *
+     * @param kitFile  A kit directory, manifest, or archive, as accepted by
+     *                 SampleKit::loadFromFile.
+     */
+    void loadKit(const juce::File& kitFile);
+
+    /**
+     * @brief  Changes how the current kit's samples are stored, reloading
+     *         the last requested bank with the new storage. This may be
+     *         called on any thread.
+     *
+     * @param storage  The new sample storage.
+     *
+     * @return         Whether a new bank is being loaded.
+     */
+    bool setStorage(const SampleBank::Storage storage);
+
+    /**
+     * @brief  Gets the name of the kit used to load banks. This may be
+     *         called on any thread.
+     *
+     * @return  The current kit's name.
+     */
+    juce::String getKitName() const;
+
+    /**
+     * @brief  Checks if a requested bank hasn't yet been delivered to the
+     *         listener.
+     *
+     * @return  Whether a bank is waiting to load, loading, or waiting to be
+     *          passed to the listener.
+     */
+    bool isLoading() const;
+
+private:
+    /**
+     * @brief  Loads each requested bank until the thread is told to exit.
+     */
+    void run() override;
+
+    /**
+     * @brief  Passes the last loaded bank to the listener on the message
+     *         thread.
+     */
+    void handleAsyncUpdate() override;
+
+    // Receives loaded banks:
+    Listener& listener;
+    // Stores decoded banks between launches:
+    SampleCache sampleCache;
+    // Protects the requested sample rate and kit, the current kit, and the
+    // loaded bank:
+    juce::CriticalSection lock;
+    // The samples and processing options used to create new banks:
+    SampleKit kit;
+    // The next kit to load, or the default File if none is requested:
+    juce::File requestedKitFile;
+    // The reason the last requested kit failed to load:
+    juce::Result kitError = juce::Result::ok();
+    // The sample rate of the last requested bank:
+    double lastRequestedRate = 0;
+    // The sample rate of the next bank to load, or zero if none is requested:
+    double requestedRate = 0;
+    // The sample rate of the bank being loaded, or zero if none is loading:
+    double loadingRate = 0;
+    // The last loaded bank, waiting to be passed to the listener:
+    SampleBank::Ptr loadedBank;
+    // Whether a requested bank hasn't yet been delivered:
+    std::atomic<bool> loading { false };
+
+    JUCE_DECLARE_NON_COPYABLE(SampleLoader)
+};
@@ -0,0 +1,137 @@
+#include "Audio_SampleStream.h"
+
+// Converts 16-bit sample values to floats between -1 and 1:
+static const constexpr float pcmScale = 1.0f / 32767.0f;
+
+// Selects the converted frame count from the write state:
+static const constexpr uint64 framesMask = 0xffffffffULL;
+
+// Allocates the ring buffer if it hasn't been allocated yet.
+void Audio::SampleStream::allocate()
+{
+    if (ring == nullptr)
+    {
+        ring.calloc((size_t) (ringFrames + maxReadFrames));
+    }
+}
+
+
+// Checks if the ring buffer has been allocated.
+bool Audio::SampleStream::isAllocated() const
+{
+    return ring != nullptr;
+}
+
+
+// Gets the amount of memory used by the ring buffer.
+size_t Audio::SampleStream::getMemorySize() const
+{
+    return (ring == nullptr) ? 0
+            : sizeof(float) * (size_t) (ringFrames + maxReadFrames);
+}
+
+
+// Starts streaming a new sample.
+void Audio::SampleStream::start(const int16* sourceData, const int length,
+        const int firstFrame)
+{
+    jassert(ring != nullptr && firstFrame >= 0 && firstFrame <= length);
+    // An odd generation marks the values below as changing, so the read-ahead
+    // thread never converts frames using a mix of old and new values:
+    generation++;
+    writeState.store(((uint64) generation) << 32, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    startFrame = firstFrame;
+    this->sourceData.store(sourceData, std::memory_order_relaxed);
+    sourceLength.store(length, std::memory_order_relaxed);
+    this->firstFrame.store(firstFrame, std::memory_order_relaxed);
+    readFrame.store(0, std::memory_order_relaxed);
+    // Publish the new even generation last, so the read-ahead thread sees
+    // all of the values above once it sees the generation:
+    generation++;
+    writeState.store(((uint64) generation) << 32, std::memory_order_release);
+}
+
+
+// Stops streaming, so the read-ahead thread ignores the stream.
+void Audio::SampleStream::stop()
+{
+    generation++;
+    writeState.store(((uint64) generation) << 32, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    sourceData.store(nullptr, std::memory_order_relaxed);
+    generation++;
+    writeState.store(((uint64) generation) << 32, std::memory_order_release);
+}
+
+
+// Gets converted sample data for the next section of the sample.
+int Audio::SampleStream::read(const int frame, const int numFrames,
+        const float*& data)
+{
+    const int streamFrame = frame - startFrame;
+    jassert(streamFrame >= 0 && numFrames <= maxReadFrames);
+    readFrame.store(streamFrame, std::memory_order_release);
+    const int converted = (int) (writeState.load(std::memory_order_acquire)
+            & framesMask);
+    data = ring + (streamFrame % ringFrames);
+    const int available = jlimit(0, numFrames, converted - streamFrame);
+    if (available < numFrames)
+    {
+        underruns.fetch_add(1, std::memory_order_relaxed);
+    }
+    return available;
+}
+
+
+// Converts as many frames as the ring buffer has room for.
+void Audio::SampleStream::fill()
+{
+    const uint64 state = writeState.load(std::memory_order_acquire);
+    if (((state >> 32) & 1) != 0 || ring == nullptr)
+    {
+        return;
+    }
+    const int16* source = sourceData.load(std::memory_order_relaxed);
+    const int first = firstFrame.load(std::memory_order_relaxed);
+    const int streamLength = sourceLength.load(std::memory_order_relaxed)
+            - first;
+    // If the stream was restarted or stopped while the values above were
+    // read, they may not belong together, so none of them may be used:
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if ((writeState.load(std::memory_order_relaxed) >> 32) != (state >> 32)
+            || source == nullptr)
+    {
+        return;
+    }
+    const int converted = (int) (state & framesMask);
+    const int reading = readFrame.load(std::memory_order_acquire);
+    const int numFrames = jmin(streamLength - converted,
+            ringFrames - (converted - reading));
+    if (numFrames <= 0)
+    {
+        return;
+    }
+    for (int i = 0; i < numFrames; i++)
+    {
+        const int ringIndex = (converted + i) % ringFrames;
+        const float value = source[first + converted + i] * pcmScale;
+        ring[ringIndex] = value;
+        if (ringIndex < maxReadFrames)
+        {
+            ring[ringFrames + ringIndex] = value;
+        }
+    }
+    // Only publish the frames if the stream wasn't restarted or stopped while
+    // they were converted:
+    uint64 expected = state;
+    writeState.compare_exchange_strong(expected, state + (uint64) numFrames,
+            std::memory_order_release, std::memory_order_relaxed);
+}
+
+
+// Gets the number of reads that found too few converted frames.
+int Audio::SampleStream::getUnderrunCount() const
+{
+    return underruns.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,142 @@
+#pragma once
+/**
+ * @file  Audio_SampleStream.h
+ *
+ * @brief  Converts a voice's 16-bit sample data to float ahead of playback.
+ */
+
+#include "JuceHeader.h"
+#include <atomic>
+
+namespace Audio { class SampleStream; }
+
+/**
+ * @brief  A single-voice ring buffer, filled with converted sample data by a
+ *         read-ahead thread and read by the audio thread.
+ *
+ *  The audio thread starts and stops the stream and reads converted frames,
+ * while exactly one other thread calls fill to convert frames ahead of the
+ * read position. Neither thread locks or waits on the other. Each start or
+ * stop begins a new stream generation, and frames converted for an old
+ * generation are never published, so a voice can be restarted at any time.
+ * The generation is odd while the stream's source values change, and the
+ * read-ahead thread only converts frames after reading the same even
+ * generation before and after the source values.
+ *
+ *  The first maxReadFrames of the ring are mirrored after its end, so every
+ * read of up to maxReadFrames frames is contiguous and can be passed to the
+ * mix kernel directly.
+ */
+class Audio::SampleStream
+{
+public:
+    // The number of converted frames the ring buffer can hold:
+    static const constexpr int ringFrames = 4096;
+    // The largest number of frames that may be read at once:
+    static const constexpr int maxReadFrames = 1024;
+
+    SampleStream() { }
+
+    virtual ~SampleStream() { }
+
+    /**
+     * @brief  Allocates the ring buffer if it hasn't been allocated yet. This
+     *         must not be called on the audio thread, or while the stream is
+     *         playing or being filled.
+     */
+    void allocate();
+
+    /**
+     * @brief  Checks if the ring buffer has been allocated.
+     *
+     * @return  Whether the stream can be started.
+     */
+    bool isAllocated() const;
+
+    /**
+     * @brief  Gets the amount of memory used by the ring buffer.
+     *
+     * @return  The ring buffer size in bytes, or zero if it isn't allocated.
+     */
+    size_t getMemorySize() const;
+
+    /**
+     * @brief  Starts streaming a new sample. This should only be called on
+     *         the audio thread.
+     *
+     * @param sourceData   The sample's complete 16-bit data.
+     *
+     * @param length       The number of frames in the sample.
+     *
+     * @param firstFrame   The first sample frame to convert.
+     */
+    void start(const juce::int16* sourceData, const int length,
+            const int firstFrame);
+
+    /**
+     * @brief  Stops streaming, so the read-ahead thread ignores the stream.
+     *         This should only be called on the audio thread.
+     */
+    void stop();
+
+    /**
+     * @brief  Gets converted sample data for the next section of the sample.
+     *         This should only be called on the audio thread.
+     *
+     *  Each read releases the frames before it for reuse, so the returned
+     * data remains valid until the stream is read again or restarted.
+     *
+     * @param frame      The sample frame to start reading from. This must not
+     *                   be before the previous read, or before the first
+     *                   frame of the stream.
+     *
+     * @param numFrames  The number of frames to read, no more than
+     *                   maxReadFrames.
+     *
+     * @param data       Used to return the converted data.
+     *
+     * @return           The number of converted frames available, which is
+     *                   less than numFrames if the read-ahead thread fell
+     *                   behind.
+     */
+    int read(const int frame, const int numFrames, const float*& data);
+
+    /**
+     * @brief  Converts as many frames as the ring buffer has room for. This
+     *         should only be called on the read-ahead thread.
+     */
+    void fill();
+
+    /**
+     * @brief  Gets the number of reads that found too few converted frames.
+     *         This may be called on any thread.
+     *
+     * @return  The number of underruns since the stream was created.
+     */
+    int getUnderrunCount() const;
+
+private:
+    // The converted frames, followed by a copy of the first maxReadFrames:
+    juce::HeapBlock<float> ring;
+    // The sample data being streamed, or nullptr if the stream is stopped:
+    std::atomic<const juce::int16*> sourceData { nullptr };
+    // The number of frames in the streamed sample:
+    std::atomic<int> sourceLength { 0 };
+    // The sample frame stored at the start of the stream:
+    std::atomic<int> firstFrame { 0 };
+    // The stream generation in the high 32 bits, and the number of frames
+    // converted for that generation in the low 32 bits. The generation is
+    // odd while the source values are changing:
+    std::atomic<juce::uint64> writeState { 0 };
+    // The stream frame the audio thread is reading from. Frames before this
+    // may be overwritten:
+    std::atomic<int> readFrame { 0 };
+    // The current stream generation, only used on the audio thread:
+    juce::uint32 generation = 0;
+    // The first streamed frame, only used on the audio thread:
+    int startFrame = 0;
+    // The number of reads that found too few converted frames:
+    std::atomic<int> underruns { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE(SampleStream)
+};
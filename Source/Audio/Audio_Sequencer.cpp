@@ -0,0 +1,149 @@
+#include "Audio_Sequencer.h"
+
+// Milliseconds per beat when playing at one beat per minute. Music box beats
+// are half-steps on the music strip, so this isn't the usual 60000.
+static const constexpr double msPerBeatAtOneBPM = 18000.0;
+
+// Gets the length of a beat in output samples.
+double Audio::Sequencer::samplesPerBeat(const int bpm, const double sampleRate)
+{
+    return msPerBeat(bpm) / 1000.0 * sampleRate;
+}
+
+
+// Gets the exact length of a beat in milliseconds.
+double Audio::Sequencer::msPerBeat(const int bpm)
+{
+    jassert(bpm > 0);
+    return msPerBeatAtOneBPM / bpm;
+}
+
+
+// Starts playing an event list from its first beat.
+void Audio::Sequencer::start(EventList* eventList,
+        const double samplesPerBeat, const uint32 sequenceId)
+{
+    jassert(samplesPerBeat > 0);
+    this->eventList = eventList;
+    this->sequenceId = sequenceId;
+    beatLength = samplesPerBeat;
+    position = 0;
+    nextEvent = 0;
+    endPosition = (eventList == nullptr) ? 0
+            : getBeatPosition(eventList->getBeatCount());
+}
+
+
+// Replaces the playing event list with an edited version, without moving the
+// playback position.
+void Audio::Sequencer::replaceEventList(EventList* eventList)
+{
+    jassert(eventList != nullptr);
+    if (this->eventList == nullptr)
+    {
+        return;
+    }
+    this->eventList = eventList;
+    endPosition = getBeatPosition(eventList->getBeatCount());
+    // Every event before the position has already been played, and events
+    // are never played before their position, so this skips exactly the
+    // events the old list already played:
+    nextEvent = eventList->findFirstEvent((int) (position / beatLength));
+    while (nextEvent < eventList->getNumEvents() && getBeatPosition(
+            eventList->getEvent(nextEvent).beat) < position)
+    {
+        nextEvent++;
+    }
+}
+
+
+// Stops playback and releases the event list.
+void Audio::Sequencer::stop()
+{
+    eventList = nullptr;
+    position = 0;
+    nextEvent = 0;
+}
+
+
+// Checks if an event list is currently playing.
+bool Audio::Sequencer::isPlaying() const
+{
+    return eventList != nullptr;
+}
+
+
+// Gets the ID of the current or most recent playback sequence.
+uint32 Audio::Sequencer::getSequenceId() const
+{
+    return sequenceId;
+}
+
+
+// Gets the beat at the current playback position.
+int Audio::Sequencer::getCurrentBeat() const
+{
+    if (eventList == nullptr)
+    {
+        return -1;
+    }
+    return (int) (position / beatLength);
+}
+
+
+// Gets the next event due to start at the current playback position, and moves
+// on to the following event.
+const Audio::EventList::Event* Audio::Sequencer::getNextDueEvent()
+{
+    if (eventList == nullptr || nextEvent >= eventList->getNumEvents())
+    {
+        return nullptr;
+    }
+    const EventList::Event& event = eventList->getEvent(nextEvent);
+    if (getBeatPosition(event.beat) > position)
+    {
+        return nullptr;
+    }
+    nextEvent++;
+    return &event;
+}
+
+
+// Finds how many samples can be rendered before the next event starts or
+// playback ends.
+int Audio::Sequencer::getSamplesUntilNextEvent(const int maxSamples) const
+{
+    if (eventList == nullptr)
+    {
+        return maxSamples;
+    }
+    int64 nextPosition = endPosition;
+    if (nextEvent < eventList->getNumEvents())
+    {
+        nextPosition = getBeatPosition(eventList->getEvent(nextEvent).beat);
+    }
+    return (int) jlimit<int64>(1, maxSamples, nextPosition - position);
+}
+
+
+// Advances the playback position, stopping playback if the end of the
+// sequence is reached.
+void Audio::Sequencer::advance(const int numSamples)
+{
+    if (eventList == nullptr)
+    {
+        return;
+    }
+    position += numSamples;
+    if (position >= endPosition && nextEvent >= eventList->getNumEvents())
+    {
+        stop();
+    }
+}
+
+
+// Gets the sample position where a beat starts.
+int64 Audio::Sequencer::getBeatPosition(const int beat) const
+{
+    return (int64) std::llround(beat * beatLength);
+}
@@ -0,0 +1,157 @@
+#pragma once
+/**
+ * @file  Audio_Sequencer.h
+ *
+ * @brief  Schedules song playback on the audio thread with sample accuracy.
+ */
+
+#include "JuceHeader.h"
+#include "Audio_EventList.h"
+
+namespace Audio { class Sequencer; }
+
+/**
+ * @brief  Tracks the playback position within an EventList using the audio
+ *         clock, and finds the exact sample offset where each event starts.
+ *
+ *  The onset of each event is calculated directly from its beat index, the
+ * tempo, and the output sample rate, so timing never drifts no matter how long
+ * the song plays. The sequencer should only be used on the audio thread.
+ */
+class Audio::Sequencer
+{
+public:
+    Sequencer() { }
+
+    virtual ~Sequencer() { }
+
+    /**
+     * @brief  Gets the length of a beat in output samples.
+     *
+     * @param bpm         The playback speed in beats per minute.
+     *
+     * @param sampleRate  The output sample rate.
+     *
+     * @return            The number of samples in each beat.
+     */
+    static double samplesPerBeat(const int bpm, const double sampleRate);
+
+    /**
+     * @brief  Gets the exact length of a beat in milliseconds, so anything
+     *         that follows playback can use the same beat length as the
+     *         audio.
+     *
+     * @param bpm  The playback speed in beats per minute.
+     *
+     * @return     The number of milliseconds in each beat.
+     */
+    static double msPerBeat(const int bpm);
+
+    /**
+     * @brief  Starts playing an event list from its first beat.
+     *
+     * @param eventList       The events to play. This should be held in a
+     *                        ReleasePool, so that releasing it here never
+     *                        deletes it.
+     *
+     * @param samplesPerBeat  The length of each beat in output samples.
+     *
+     * @param sequenceId      An ID used to identify this playback sequence.
+     */
+    void start(EventList* eventList, const double samplesPerBeat,
+            const uint32 sequenceId);
+
+    /**
+     * @brief  Replaces the playing event list with an edited version, without
+     *         moving the playback position. Events in the new list that start
+     *         before the current position are skipped.
+     *
+     * @param eventList  The edited events to play. This should be held in a
+     *                   ReleasePool, so that releasing it here never deletes
+     *                   it.
+     */
+    void replaceEventList(EventList* eventList);
+
+    /**
+     * @brief  Stops playback and releases the event list.
+     */
+    void stop();
+
+    /**
+     * @brief  Checks if an event list is currently playing.
+     *
+     * @return  Whether an event list is playing.
+     */
+    bool isPlaying() const;
+
+    /**
+     * @brief  Gets the ID of the current or most recent playback sequence.
+     *
+     * @return  The ID passed to the last start call.
+     */
+    uint32 getSequenceId() const;
+
+    /**
+     * @brief  Gets the beat at the current playback position.
+     *
+     * @return  The current beat index, or -1 if nothing is playing.
+     */
+    int getCurrentBeat() const;
+
+    /**
+     * @brief  Gets the next event due to start at the current playback
+     *         position, and moves on to the following event.
+     *
+     * @return  The next due event, or nullptr if no event starts at the
+     *          current position.
+     */
+    const EventList::Event* getNextDueEvent();
+
+    /**
+     * @brief  Finds how many samples can be rendered before the next event
+     *         starts or playback ends.
+     *
+     *  This should only be called after handling all events returned by
+     * getNextDueEvent.
+     *
+     * @param maxSamples  The largest value to return.
+     *
+     * @return            The number of samples until the next event or the end
+     *                    of the sequence, between one and maxSamples.
+     */
+    int getSamplesUntilNextEvent(const int maxSamples) const;
+
+    /**
+     * @brief  Advances the playback position, stopping playback if the end of
+     *         the sequence is reached.
+     *
+     * @param numSamples  The number of samples rendered since the last update.
+     */
+    void advance(const int numSamples);
+
+private:
+    /**
+     * @brief  Gets the sample position where a beat starts.
+     *
+     * @param beat  A beat index.
+     *
+     * @return      The number of samples between the start of the sequence
+     *              and the start of the beat.
+     */
+    int64 getBeatPosition(const int beat) const;
+
+    // The playing event list, or nullptr if stopped:
+    EventList::Ptr eventList;
+    // The length of each beat in output samples:
+    double beatLength = 0;
+    // Samples played since the sequence started:
+    int64 position = 0;
+    // The sample position where playback ends:
+    int64 endPosition = 0;
+    // The index of the next event to play:
+    int nextEvent = 0;
+    // Identifies the current or most recent sequence:
+    uint32 sequenceId = 0;
+
+    JUCE_DECLARE_NON_COPYABLE(Sequencer)
+};
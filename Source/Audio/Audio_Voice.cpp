@@ -0,0 +1,218 @@
+#include "Audio_Voice.h"
+
+// The number of frames checked when estimating a voice's level:
+static const constexpr int levelWindow = 256;
+
+// Starts playing a note sample from its beginning.
+void Audio::Voice::start(const int note, const float* sampleData,
+        const int length, const float* envelope, const float gain,
+        const float pan)
+{
+    jassert(sampleData != nullptr && length > 0);
+    if (streaming)
+    {
+        stream.stop();
+        streaming = false;
+    }
+    this->note = note;
+    this->sampleData = sampleData;
+    this->length = length;
+    preloadLength = length;
+    this->envelope = envelope;
+    sampleBank = nullptr;
+    position = 0;
+    releaseFramesLeft = 0;
+    leftGainStep = 0.0f;
+    rightGainStep = 0.0f;
+    MixKernel::getPanGains(gain, pan, leftGain, rightGain);
+}
+
+
+// Streams the rest of the note once the voice reaches the end of its
+// preloaded data.
+void Audio::Voice::startStream(const int16* streamData,
+        const int preloadLength)
+{
+    jassert(sampleData != nullptr && position == 0);
+    this->preloadLength = jmin(preloadLength, length);
+    if (this->preloadLength < length)
+    {
+        // Start streaming before the end of the preloaded data, so any block
+        // that crosses the end can be read from the stream in one piece:
+        stream.start(streamData, length, jmax(0,
+                this->preloadLength - SampleStream::maxReadFrames));
+        streaming = true;
+    }
+}
+
+
+// Keeps the bank holding the note's sample data alive until the voice stops.
+void Audio::Voice::setSampleBank(SampleBank* sampleBank)
+{
+    jassert(this->sampleData != nullptr && position == 0);
+    this->sampleBank = sampleBank;
+}
+
+
+// Gets the stream used to play notes from streamed sample banks.
+Audio::SampleStream& Audio::Voice::getStream()
+{
+    return stream;
+}
+
+
+// Gets the stream used to play notes from streamed sample banks.
+const Audio::SampleStream& Audio::Voice::getStream() const
+{
+    return stream;
+}
+
+
+// Immediately stops the voice.
+void Audio::Voice::stop()
+{
+    if (streaming)
+    {
+        stream.stop();
+        streaming = false;
+    }
+    // Release the bank only after stopping the stream, so the read-ahead
+    // thread never sees a stream reading from an unused bank:
+    sampleBank = nullptr;
+    sampleData = nullptr;
+    note = -1;
+    finished = false;
+    releaseFramesLeft = 0;
+}
+
+
+// Fades the voice out, stopping it once the fade finishes.
+void Audio::Voice::release(const int fadeFrames)
+{
+    if (sampleData == nullptr || isReleasing())
+    {
+        return;
+    }
+    if (fadeFrames <= 0)
+    {
+        stop();
+        return;
+    }
+    releaseFramesLeft = fadeFrames;
+    leftGainStep = -leftGain / fadeFrames;
+    rightGainStep = -rightGain / fadeFrames;
+}
+
+
+// Checks if the voice is fading out after being released.
+bool Audio::Voice::isReleasing() const
+{
+    return releaseFramesLeft > 0;
+}
+
+
+// Estimates how loud the voice will be over the next few frames.
+float Audio::Voice::getLevel() const
+{
+    if (sampleData == nullptr)
+    {
+        return 0.0f;
+    }
+    const float gain = jmax(leftGain, rightGain);
+    if (envelope != nullptr)
+    {
+        return envelope[position / SampleBank::envelopeResolution] * gain;
+    }
+    if (position >= preloadLength)
+    {
+        // Streamed data can't be checked ahead of time:
+        return gain;
+    }
+    const Range<float> range = FloatVectorOperations::findMinAndMax(
+            sampleData + position, jmin(levelWindow, preloadLength - position));
+    return jmax(-range.getStart(), range.getEnd()) * gain;
+}
+
+
+// Gets the number of frames the voice has left to play.
+int Audio::Voice::getFramesLeft() const
+{
+    if (sampleData == nullptr)
+    {
+        return 0;
+    }
+    if (isReleasing())
+    {
+        return jmin(releaseFramesLeft, length - position);
+    }
+    return length - position;
+}
+
+
+// Checks if the voice is currently playing a note.
+bool Audio::Voice::isActive() const
+{
+    return sampleData != nullptr;
+}
+
+
+// Checks if the voice played the last of its note in the last mix block, and
+// is waiting to be stopped.
+bool Audio::Voice::isFinished() const
+{
+    return finished;
+}
+
+
+// Gets the note the voice is playing.
+int Audio::Voice::getNote() const
+{
+    return note;
+}
+
+
+// Gets the voice's contribution to the next mix block, and moves past that
+// block.
+bool Audio::Voice::getNextBlock(const int numSamples,
+        MixKernel::Source& source)
+{
+    if (sampleData == nullptr || finished)
+    {
+        return false;
+    }
+    int numFrames = jmin(numSamples, length - position);
+    if (isReleasing())
+    {
+        numFrames = jmin(numFrames, releaseFramesLeft);
+    }
+    source.data = sampleData + position;
+    source.numFrames = numFrames;
+    source.leftGain = leftGain;
+    source.rightGain = rightGain;
+    source.leftGainStep = leftGainStep;
+    source.rightGainStep = rightGainStep;
+    if (position + numFrames > preloadLength)
+    {
+        // If the stream fell behind, the missing frames are left silent so
+        // the note stays in time:
+        jassert(streaming);
+        source.numFrames = stream.read(position, numFrames, source.data);
+    }
+    if (isReleasing())
+    {
+        releaseFramesLeft -= numFrames;
+        leftGain += leftGainStep * numFrames;
+        rightGain += rightGainStep * numFrames;
+        if (releaseFramesLeft == 0)
+        {
+            finished = true;
+        }
+    }
+    position += numFrames;
+    // Stopping here would release the bank before the block is mixed:
+    if (position >= length)
+    {
+        finished = true;
+    }
+    return true;
+}
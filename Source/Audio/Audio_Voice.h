@@ -0,0 +1,216 @@
+#pragma once
+/**
+ * @file  Audio_Voice.h
+ *
+ * @brief  Plays back a single music box note sample.
+ */
+
+#include "JuceHeader.h"
+#include "Audio_MixKernel.h"
+#include "Audio_SampleStream.h"
+#include "Audio_SampleBank.h"
+
+namespace Audio { class Voice; }
+
+/**
+ * @brief  A single playback slot that can play any note sample.
+ *
+ *  Voices are allocated once by the VoicePool and reused for every note it
+ * plays. Starting a voice only stores a pointer to the note's sample data, so
+ * starting and rendering voices never allocates memory. Sample data must
+ * already be at the output sample rate, so rendering is a direct copy.
+ * Released voices fade out linearly, so stealing a voice never clicks.
+ *
+ *  Notes from streamed sample banks play their preloaded float data first,
+ * then read the rest of the note from the voice's SampleStream.
+ *
+ *  A voice may hold a reference to the sample bank it plays from, so the
+ * bank's data stays valid until the note finishes even if the player has
+ * already switched to another bank.
+ */
+class Audio::Voice
+{
+public:
+    Voice() { }
+
+    virtual ~Voice() { }
+
+    /**
+     * @brief  Starts playing a note sample from its beginning.
+     *
+     * @param note        The index of the played note.
+     *
+     * @param sampleData  The note's sample data at the output sample rate.
+     *                    This must remain valid until the voice stops.
+     *
+     * @param length      The number of frames in the sample data.
+     *
+     * @param envelope    The sample's decay envelope, as created by the
+     *                    SampleBank, or nullptr if the sample has no envelope.
+     *
+     * @param gain        The gain applied to the sample.
+     *
+     * @param pan         The note's stereo position, from -1 for hard left to
+     *                    1 for hard right.
+     */
+    void start(const int note, const float* sampleData, const int length,
+            const float* envelope, const float gain = 1.0f,
+            const float pan = 0.0f);
+
+    /**
+     * @brief  Streams the rest of the note once the voice reaches the end of
+     *         its preloaded data. This must be called just after start, and
+     *         the voice's stream must be allocated.
+     *
+     * @param streamData     The note's complete 16-bit sample data. This must
+     *                       remain valid until the voice stops.
+     *
+     * @param preloadLength  The number of frames available as float data
+     *                       from the start of the note.
+     */
+    void startStream(const juce::int16* streamData, const int preloadLength);
+
+    /**
+     * @brief  Keeps the bank holding the note's sample data alive until the
+     *         voice stops. This must be called just after start.
+     *
+     * @param sampleBank  The bank holding the data passed to start. If the
+     *                    bank is shared with other threads, it must be held
+     *                    by a ReleasePool, so the voice never deletes it.
+     */
+    void setSampleBank(SampleBank* sampleBank);
+
+    /**
+     * @brief  Gets the stream used to play notes from streamed sample banks.
+     *
+     * @return  The voice's sample stream.
+     */
+    SampleStream& getStream();
+
+    /**
+     * @brief  Gets the stream used to play notes from streamed sample banks.
+     *
+     * @return  The voice's sample stream.
+     */
+    const SampleStream& getStream() const;
+
+    /**
+     * @brief  Immediately stops the voice.
+     */
+    void stop();
+
+    /**
+     * @brief  Fades the voice out, stopping it once the fade finishes.
+     *
+     * @param fadeFrames  The length of the fade in output frames. If this is
+     *                    zero, the voice stops immediately.
+     */
+    void release(const int fadeFrames);
+
+    /**
+     * @brief  Checks if the voice is fading out after being released.
+     *
+     * @return  Whether the voice is active and releasing.
+     */
+    bool isReleasing() const;
+
+    /**
+     * @brief  Estimates how loud the voice will be from its current position.
+     *
+     *  When the sample has a decay envelope, this is the highest level the
+     * voice will reach before it ends. Otherwise, it is the peak level over
+     * the next few frames.
+     *
+     * @return  The peak output level of the voice, or zero if the voice is
+     *          inactive.
+     */
+    float getLevel() const;
+
+    /**
+     * @brief  Gets the number of frames the voice has left to play.
+     *
+     * @return  The frames remaining before the voice stops, or zero if it is
+     *          inactive.
+     */
+    int getFramesLeft() const;
+
+    /**
+     * @brief  Checks if the voice is currently playing a note.
+     *
+     * @return  Whether the voice has sample data left to play.
+     */
+    bool isActive() const;
+
+    /**
+     * @brief  Checks if the voice played the last of its note in the last
+     *         mix block, and is waiting to be stopped.
+     *
+     * @return  Whether the voice has nothing left to play.
+     */
+    bool isFinished() const;
+
+    /**
+     * @brief  Gets the note the voice is playing.
+     *
+     * @return  The index of the played note, or -1 if the voice is inactive.
+     */
+    int getNote() const;
+
+    /**
+     * @brief  Gets the voice's contribution to the next mix block, and moves
+     *         past that block.
+     *
+     *  Once the voice reaches the end of its sample or release, it is marked
+     * as finished but keeps its sample bank, so the returned sample data stays
+     * valid until the block is mixed. Finished voices must then be stopped
+     * with stop(). If the voice's stream fell behind, the returned block is
+     * shorter than the frames the voice moved past.
+     *
+     * @param numSamples  The number of frames in the mix block, no more than
+     *                    SampleStream::maxReadFrames.
+     *
+     * @param source      Used to return the voice's data and gains for the
+     *                    block. This is left unchanged if the voice is
+     *                    inactive.
+     *
+     * @return            Whether the voice had data to add to the block.
+     *                    Finished voices have no data to add.
+     */
+    bool getNextBlock(const int numSamples, MixKernel::Source& source);
+
+private:
+    // The played note's sample data, or nullptr if the voice is inactive:
+    const float* sampleData = nullptr;
+    // The number of frames in the sample:
+    int length = 0;
+    // The number of frames available in the float sample data:
+    int preloadLength = 0;
+    // Whether frames after the preloaded data are read from the stream:
+    bool streaming = false;
+    // Converts streamed notes to float data:
+    SampleStream stream;
+    // The bank holding the played note's data, or nullptr if the voice
+    // doesn't hold a bank:
+    SampleBank::Ptr sampleBank;
+    // The sample's decay envelope, or nullptr if it has none:
+    const float* envelope = nullptr;
+    // The index of the played note:
+    int note = -1;
+    // The next frame to read from the sample data:
+    int position = 0;
+    // The gain applied to the left channel:
+    float leftGain = 1.0f;
+    // The gain applied to the right channel:
+    float rightGain = 1.0f;
+    // Whether the voice reached the end of its note and is waiting to be
+    // stopped:
+    bool finished = false;
+    // Frames left in the release fade, or zero if the voice isn't releasing:
+    int releaseFramesLeft = 0;
+    // The per-frame change in left channel gain while releasing:
+    float leftGainStep = 0.0f;
+    // The per-frame change in right channel gain while releasing:
+    float rightGainStep = 0.0f;
+
+    JUCE_DECLARE_NON_COPYABLE(Voice)
+};
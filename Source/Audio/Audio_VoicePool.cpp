@@ -0,0 +1,366 @@
+#include "Audio_VoicePool.h"
+
+// Creates a voice pool with no active voices.
+Audio::VoicePool::VoicePool() :
+cullThreshold(Decibels::decibelsToGain(defaultCullThresholdDb))
+{
+    for (Voice*& voice : activeVoices)
+    {
+        voice = nullptr;
+    }
+}
+
+
+// Sets the output sample rate, used to find the length of the release fade.
+void Audio::VoicePool::setSampleRate(const double sampleRate)
+{
+    releaseFrames = (int) std::ceil(sampleRate * releaseSeconds);
+}
+
+
+// Sets the maximum number of notes that may play at once.
+void Audio::VoicePool::setPolyphony(const int polyphony)
+{
+    this->polyphony = jlimit(1, maxPolyphony, polyphony);
+    int numExcess = countPlayingVoices() - this->polyphony;
+    for (int i = 0; i < numActive && numExcess > 0; i++)
+    {
+        if (! activeVoices[i]->isReleasing())
+        {
+            activeVoices[i]->release(releaseFrames);
+            numExcess--;
+        }
+    }
+}
+
+
+// Gets the maximum number of notes that may play at once.
+int Audio::VoicePool::getPolyphony() const
+{
+    return polyphony;
+}
+
+
+// Sets how voices are chosen when the polyphony limit is reached.
+void Audio::VoicePool::setStealingPolicy(const StealingPolicy policy)
+{
+    stealingPolicy = policy;
+}
+
+
+// Gets how voices are chosen when the polyphony limit is reached.
+Audio::VoicePool::StealingPolicy Audio::VoicePool::getStealingPolicy() const
+{
+    return stealingPolicy;
+}
+
+
+// Sets the level below which voices are stopped early.
+void Audio::VoicePool::setCullThreshold(const float threshold)
+{
+    cullThreshold = jmax(0.0f, threshold);
+}
+
+
+// Gets the level below which voices are stopped early.
+float Audio::VoicePool::getCullThreshold() const
+{
+    return cullThreshold;
+}
+
+
+// Gets the number of voices stopped early because they fell below the cull
+// threshold.
+int64 Audio::VoicePool::getCulledVoiceCount() const
+{
+    return culledVoices.load();
+}
+
+
+// Gets the number of sample frames that culled voices would have played.
+int64 Audio::VoicePool::getCulledFrameCount() const
+{
+    return culledFrames.load();
+}
+
+
+// Starts playing a note in an unused voice, stealing a voice first if the
+// polyphony limit has been reached.
+void Audio::VoicePool::startVoice(const int note, const float* sampleData,
+        const int length, const float* envelope, const float gain,
+        const float pan)
+{
+    if (countPlayingVoices() >= polyphony)
+    {
+        const int stolenIndex = findVoiceToSteal(note);
+        if (stolenIndex >= 0)
+        {
+            activeVoices[stolenIndex]->release(releaseFrames);
+            if (! activeVoices[stolenIndex]->isActive())
+            {
+                removeActiveVoice(stolenIndex);
+            }
+        }
+    }
+    Voice* voice = nullptr;
+    if (numActive < maxVoices)
+    {
+        for (Voice& unusedVoice : voices)
+        {
+            if (! unusedVoice.isActive())
+            {
+                voice = &unusedVoice;
+                break;
+            }
+        }
+        jassert(voice != nullptr);
+    }
+    else
+    {
+        // Every release voice is still fading, so cut off the oldest fade:
+        int index = 0;
+        while (index < numActive - 1 && ! activeVoices[index]->isReleasing())
+        {
+            index++;
+        }
+        voice = activeVoices[index];
+        removeActiveVoice(index);
+    }
+    voice->start(note, sampleData, length, envelope, gain, pan);
+    activeVoices[numActive] = voice;
+    numActive++;
+}
+
+
+// Starts playing a note from a sample bank, streaming the note if the bank is
+// streamed.
+void Audio::VoicePool::startVoice(const int note, SampleBank& sampleBank,
+        const float gain, const float pan)
+{
+    const float* sampleData = sampleBank.getSampleData(note);
+    if (sampleData == nullptr)
+    {
+        return;
+    }
+    const int16* streamData = sampleBank.getStreamData(note);
+    const bool canStream = voices[0].getStream().isAllocated();
+    jassert(streamData == nullptr || canStream);
+    // Without streams, streamed notes are cut short after their preloaded
+    // data:
+    const int length = (streamData != nullptr && ! canStream)
+            ? sampleBank.getPreloadLength(note)
+            : sampleBank.getSampleLength(note);
+    startVoice(note, sampleData, length, sampleBank.getEnvelope(note), gain,
+            pan);
+    Voice* voice = activeVoices[numActive - 1];
+    voice->setSampleBank(&sampleBank);
+    if (streamData != nullptr && canStream)
+    {
+        voice->startStream(streamData, sampleBank.getPreloadLength(note));
+    }
+}
+
+
+// Allocates each voice's sample stream, so notes from streamed sample banks
+// can play.
+void Audio::VoicePool::allocateStreams()
+{
+    for (Voice& voice : voices)
+    {
+        voice.getStream().allocate();
+    }
+}
+
+
+// Converts streamed sample data ahead of each streaming voice.
+void Audio::VoicePool::fillStreams()
+{
+    for (Voice& voice : voices)
+    {
+        voice.getStream().fill();
+    }
+}
+
+
+// Gets the memory used by voice sample streams.
+size_t Audio::VoicePool::getStreamMemorySize() const
+{
+    size_t size = 0;
+    for (const Voice& voice : voices)
+    {
+        size += voice.getStream().getMemorySize();
+    }
+    return size;
+}
+
+
+// Gets the number of times a streaming voice ran out of converted data.
+int Audio::VoicePool::getStreamUnderrunCount() const
+{
+    int underruns = 0;
+    for (const Voice& voice : voices)
+    {
+        underruns += voice.getStream().getUnderrunCount();
+    }
+    return underruns;
+}
+
+
+// Immediately stops all active voices.
+void Audio::VoicePool::stopAllVoices()
+{
+    for (int i = 0; i < numActive; i++)
+    {
+        activeVoices[i]->stop();
+        activeVoices[i] = nullptr;
+    }
+    numActive = 0;
+}
+
+
+// Gets the number of voices that are currently playing.
+int Audio::VoicePool::getActiveVoiceCount() const
+{
+    return numActive;
+}
+
+
+// Adds the next block of output from all active voices to a mix buffer, and
+// releases any voices that finish.
+void Audio::VoicePool::renderNextBlock(float* left, float* right,
+        const int numSamples)
+{
+    // Streams can only provide a limited number of frames at once:
+    for (int offset = 0; offset < numSamples;
+            offset += SampleStream::maxReadFrames)
+    {
+        renderSection(left + offset,
+                (right == nullptr) ? nullptr : right + offset,
+                jmin(SampleStream::maxReadFrames, numSamples - offset));
+    }
+}
+
+
+// Adds a section of output from all active voices to a mix buffer, and
+// releases any voices that finish.
+void Audio::VoicePool::renderSection(float* left, float* right,
+        const int numSamples)
+{
+    int numSources = 0;
+    int numStillActive = 0;
+    for (int i = 0; i < numActive; i++)
+    {
+        Voice* voice = activeVoices[i];
+        if (cullThreshold > 0.0f && ! voice->isReleasing()
+                && voice->getLevel() < cullThreshold)
+        {
+            culledVoices++;
+            culledFrames += voice->getFramesLeft();
+            voice->stop();
+        }
+        else if (voice->getNextBlock(numSamples, mixSources[numSources]))
+        {
+            numSources++;
+        }
+    }
+    if (right == nullptr)
+    {
+        MixKernel::mixMono(mixSources, numSources, left, numSamples);
+    }
+    else
+    {
+        MixKernel::mixStereo(mixSources, numSources, left, right, numSamples);
+    }
+    // Finished voices may hold the last reference to the bank their mixed
+    // data came from, so they're only stopped once mixing is done:
+    for (int i = 0; i < numActive; i++)
+    {
+        Voice* voice = activeVoices[i];
+        if (voice->isFinished())
+        {
+            voice->stop();
+        }
+        // Keep active voices packed at the start of the list in start order:
+        if (voice->isActive())
+        {
+            activeVoices[numStillActive] = voice;
+            numStillActive++;
+        }
+    }
+    for (int i = numStillActive; i < numActive; i++)
+    {
+        activeVoices[i] = nullptr;
+    }
+    numActive = numStillActive;
+}
+
+
+// Counts the active voices that aren't fading out.
+int Audio::VoicePool::countPlayingVoices() const
+{
+    int numPlaying = 0;
+    for (int i = 0; i < numActive; i++)
+    {
+        if (! activeVoices[i]->isReleasing())
+        {
+            numPlaying++;
+        }
+    }
+    return numPlaying;
+}
+
+
+// Chooses a voice to release using the stealing policy.
+int Audio::VoicePool::findVoiceToSteal(const int note) const
+{
+    int oldest = -1;
+    int quietest = -1;
+    float quietestLevel = 0.0f;
+    for (int i = 0; i < numActive; i++)
+    {
+        const Voice* voice = activeVoices[i];
+        if (voice->isReleasing())
+        {
+            continue;
+        }
+        switch (stealingPolicy)
+        {
+            case StealingPolicy::oldest:
+                return i;
+            case StealingPolicy::samePitch:
+                if (voice->getNote() == note)
+                {
+                    return i;
+                }
+                break;
+            case StealingPolicy::quietest:
+            {
+                const float level = voice->getLevel();
+                if (quietest < 0 || level < quietestLevel)
+                {
+                    quietest = i;
+                    quietestLevel = level;
+                }
+                break;
+            }
+        }
+        if (oldest < 0)
+        {
+            oldest = i;
+        }
+    }
+    return (quietest >= 0) ? quietest : oldest;
+}
+
+
+// Removes a voice from the active voice list, keeping the list in start order.
+void Audio::VoicePool::removeActiveVoice(const int index)
+{
+    jassert(index >= 0 && index < numActive);
+    for (int i = index + 1; i < numActive; i++)
+    {
+        activeVoices[i - 1] = activeVoices[i];
+    }
+    numActive--;
+    activeVoices[numActive] = nullptr;
+}
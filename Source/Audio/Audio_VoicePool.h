@@ -0,0 +1,306 @@
+#pragma once
+/**
+ * @file  Audio_VoicePool.h
+ *
+ * @brief  Manages a fixed set of preallocated note voices.
+ */
+
+#include "JuceHeader.h"
+#include "Audio_Voice.h"
+#include "Audio_SampleBank.h"
+#include <atomic>
+
+namespace Audio { class VoicePool; }
+
+/**
+ * @brief  Assigns notes to a fixed number of reusable voices and mixes all
+ *         active voices together.
+ *
+ *  Every voice can play any note, so a note that is played again while still
+ * ringing starts in a new voice and overlaps the previous one. The number of
+ * notes that may play at once is limited by a configurable polyphony limit.
+ * When a new note would exceed that limit, an existing voice is chosen using
+ * the current stealing policy, and is faded out over a short release while
+ * the new note starts in another voice. A small set of extra voices is kept
+ * for these releases, so the number of voices processed in each block never
+ * exceeds the polyphony limit plus that fixed reserve.
+ *
+ *  Only the active voices are processed when rendering, so silent voices cost
+ * nothing. Voices are also culled as soon as their decay envelope shows they
+ * will never again rise above the cull threshold, so long inaudible tails
+ * aren't processed either. All active voices are summed in a single call to
+ * the vectorised MixKernel. VoicePool is not thread-safe, and should only be
+ * accessed on the audio thread, except where noted below.
+ *
+ *  Notes from streamed sample banks need each voice's SampleStream to be
+ * allocated first, and fillStreams must be called regularly while they play,
+ * either on a read-ahead thread or between rendered blocks.
+ */
+class Audio::VoicePool
+{
+public:
+    // The largest allowed polyphony limit:
+    static const constexpr int maxPolyphony = 64;
+    // The polyphony limit used until another limit is set:
+    static const constexpr int defaultPolyphony = 32;
+    // Extra voices reserved for fading out stolen voices:
+    static const constexpr int releaseVoices = 16;
+    // The total number of voices, including release voices:
+    static const constexpr int maxVoices = maxPolyphony + releaseVoices;
+    // The length of the fade applied to stolen voices, in seconds:
+    static const constexpr double releaseSeconds = 0.01;
+    // The default level below which voices are culled, in decibels:
+    static const constexpr float defaultCullThresholdDb = -70.0f;
+
+    /**
+     * @brief  Ways to choose which voice to replace when the polyphony limit
+     *         is reached.
+     */
+    enum class StealingPolicy
+    {
+        // Replace the voice that started first:
+        oldest,
+        // Replace the voice with the lowest output level:
+        quietest,
+        // Replace the oldest voice playing the same note, or the oldest voice
+        // if no voice is playing that note:
+        samePitch
+    };
+
+    VoicePool();
+
+    virtual ~VoicePool() { }
+
+    /**
+     * @brief  Sets the output sample rate, used to find the length of the
+     *         release fade.
+     *
+     * @param sampleRate  The output sample rate.
+     */
+    void setSampleRate(const double sampleRate);
+
+    /**
+     * @brief  Sets the maximum number of notes that may play at once. If more
+     *         notes than the new limit are playing, the oldest voices are
+     *         released.
+     *
+     * @param polyphony  The new limit, which will be clamped between one and
+     *                   maxPolyphony.
+     */
+    void setPolyphony(const int polyphony);
+
+    /**
+     * @brief  Gets the maximum number of notes that may play at once.
+     *
+     * @return  The polyphony limit.
+     */
+    int getPolyphony() const;
+
+    /**
+     * @brief  Sets how voices are chosen when the polyphony limit is reached.
+     *
+     * @param policy  The new voice stealing policy.
+     */
+    void setStealingPolicy(const StealingPolicy policy);
+
+    /**
+     * @brief  Gets how voices are chosen when the polyphony limit is reached.
+     *
+     * @return  The voice stealing policy.
+     */
+    StealingPolicy getStealingPolicy() const;
+
+    /**
+     * @brief  Sets the level below which voices are stopped early.
+     *
+     * @param threshold  The cull threshold as a linear gain, or zero to never
+     *                   cull voices.
+     */
+    void setCullThreshold(const float threshold);
+
+    /**
+     * @brief  Gets the level below which voices are stopped early.
+     *
+     * @return  The cull threshold as a linear gain.
+     */
+    float getCullThreshold() const;
+
+    /**
+     * @brief  Gets the number of voices stopped early because they fell below
+     *         the cull threshold. This may be called on any thread.
+     *
+     * @return  The number of culled voices since the pool was created.
+     */
+    int64 getCulledVoiceCount() const;
+
+    /**
+     * @brief  Gets the number of sample frames that culled voices would have
+     *         played. This may be called on any thread.
+     *
+     * @return  The number of frames skipped by culling since the pool was
+     *          created.
+     */
+    int64 getCulledFrameCount() const;
+
+    /**
+     * @brief  Starts playing a note in an unused voice, stealing a voice first
+     *         if the polyphony limit has been reached.
+     *
+     * @param note        The index of the played note.
+     *
+     * @param sampleData  The note's sample data at the output sample rate.
+     *                    This must remain valid until the voice finishes.
+     *
+     * @param length      The number of frames in the sample data.
+     *
+     * @param envelope    The sample's decay envelope, as created by the
+     *                    SampleBank, or nullptr if the sample has no envelope.
+     *
+     * @param gain        The gain applied to the sample.
+     *
+     * @param pan         The note's stereo position, from -1 for hard left to
+     *                    1 for hard right.
+     */
+    void startVoice(const int note, const float* sampleData,
+            const int length, const float* envelope, const float gain = 1.0f,
+            const float pan = 0.0f);
+
+    /**
+     * @brief  Starts playing a note from a sample bank, streaming the note if
+     *         the bank is streamed.
+     *
+     * @param note        The index of the played note.
+     *
+     * @param sampleBank  The bank holding the note's sample. The voice holds
+     *                    a reference to the bank until it finishes, so if the
+     *                    bank is shared with other threads, it must be held by
+     *                    a ReleasePool.
+     *
+     * @param gain        The gain applied to the sample.
+     *
+     * @param pan         The note's stereo position, from -1 for hard left to
+     *                    1 for hard right.
+     */
+    void startVoice(const int note, SampleBank& sampleBank,
+            const float gain = 1.0f, const float pan = 0.0f);
+
+    /**
+     * @brief  Allocates each voice's sample stream, so notes from streamed
+     *         sample banks can play. This must not be called on the audio
+     *         thread, or while any voice is streaming.
+     */
+    void allocateStreams();
+
+    /**
+     * @brief  Converts streamed sample data ahead of each streaming voice.
+     *         Only one thread may call this, but it may be called while the
+     *         audio thread is rendering.
+     */
+    void fillStreams();
+
+    /**
+     * @brief  Gets the memory used by voice sample streams. This may be called
+     *         on any thread.
+     *
+     * @return  The size of all stream ring buffers in bytes.
+     */
+    size_t getStreamMemorySize() const;
+
+    /**
+     * @brief  Gets the number of times a streaming voice ran out of converted
+     *         data. This may be called on any thread.
+     *
+     * @return  The number of stream underruns since the pool was created.
+     */
+    int getStreamUnderrunCount() const;
+
+    /**
+     * @brief  Immediately stops all active voices.
+     */
+    void stopAllVoices();
+
+    /**
+     * @brief  Gets the number of voices that are currently playing.
+     *
+     * @return  The number of active voices, including voices fading out.
+     */
+    int getActiveVoiceCount() const;
+
+    /**
+     * @brief  Adds the next block of output from all active voices to a mix
+     *         buffer, and releases any voices that finish.
+     *
+     * @param left        The start of the section of the left or mono mix
+     *                    channel where voice output is added.
+     *
+     * @param right       The start of the section of the right mix channel
+     *                    where voice output is added, or nullptr to create a
+     *                    mono mix.
+     *
+     * @param numSamples  The number of frames to write.
+     */
+    void renderNextBlock(float* left, float* right, const int numSamples);
+
+private:
+    /**
+     * @brief  Adds a section of output from all active voices to a mix
+     *         buffer, and releases any voices that finish.
+     *
+     * @param left        The start of the left or mono mix section.
+     *
+     * @param right       The start of the right mix section, or nullptr to
+     *                    create a mono mix.
+     *
+     * @param numSamples  The number of frames to write, no more than
+     *                    SampleStream::maxReadFrames.
+     */
+    void renderSection(float* left, float* right, const int numSamples);
+
+    /**
+     * @brief  Counts the active voices that aren't fading out.
+     *
+     * @return  The number of voices counted against the polyphony limit.
+     */
+    int countPlayingVoices() const;
+
+    /**
+     * @brief  Chooses a voice to release using the stealing policy.
+     *
+     * @param note  The note that needs a voice.
+     *
+     * @return      The index in activeVoices of a playing voice, or -1 if no
+     *              voice is playing.
+     */
+    int findVoiceToSteal(const int note) const;
+
+    /**
+     * @brief  Removes a voice from the active voice list, keeping the list in
+     *         start order.
+     *
+     * @param index  The voice's index in activeVoices.
+     */
+    void removeActiveVoice(const int index);
+
+    // All voices, active or not:
+    Voice voices[maxVoices];
+    // Points to each active voice, in the order they were started:
+    Voice* activeVoices[maxVoices];
+    // The number of valid pointers in activeVoices:
+    int numActive = 0;
+    // Holds each active voice's contribution to the mix block being rendered:
+    MixKernel::Source mixSources[maxVoices];
+    // The maximum number of voices that may play without releasing:
+    int polyphony = defaultPolyphony;
+    // Chooses voices to release when the polyphony limit is reached:
+    StealingPolicy stealingPolicy = StealingPolicy::oldest;
+    // The length of the fade applied to stolen voices, in frames:
+    int releaseFrames = 0;
+    // Voices are culled once they can't rise above this level:
+    float cullThreshold;
+    // The number of voices culled since the pool was created:
+    std::atomic<int64> culledVoices { 0 };
+    // The number of frames skipped by culling since the pool was created:
+    std::atomic<int64> culledFrames { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE(VoicePool)
+};
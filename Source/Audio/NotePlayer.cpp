@@ -1,72 +1,110 @@
 #include "NotePlayer.h"
-#include "Assets.h"
-
-static const StringArray samples =
-{
-    "_177947__ubikphonik__ab1_aiff",
-    "_177944__ubikphonik__bb1_aiff",
-    "_177948__ubikphonik__c1_aiff",
-    "_177950__ubikphonik__db1_aiff",
-    "_177954__ubikphonik__eb1_aiff",
-    "_177943__ubikphonik__f1_aiff",
-    "_177941__ubikphonik__g1_aiff",
-    "_177946__ubikphonik__ab2_aiff",
-    "_177949__ubikphonik__bb2_aiff",
-    "_177951__ubikphonik__c2_aiff",
-    "_177952__ubikphonik__db2_aiff",
-    "_177953__ubikphonik__eb2_aiff",
-    "_177942__ubikphonik__f2_aiff",
-    "_177940__ubikphonik__g2_aiff",
-    "_177945__ubikphonik__ab3_aiff"
-};
-
-NotePlayer::NotePlayer(AudioDeviceManager& deviceManager) :
-    deviceManager(deviceManager)
-{
-
-    formatManager.registerBasicFormats();
-    for (const String& sample : samples)
-    {
-        File audioFile = Assets::findAssetFile(sample);
-        AudioFormatReader* noteReader 
-                = formatManager.createReaderFor(audioFile);
-        if (noteReader != nullptr)
-        {
-            std::unique_ptr<AudioFormatReaderSource> newSource 
-                    = std::make_unique<AudioFormatReaderSource>(noteReader,
-                    true);
-            sampleRates.add(noteReader->sampleRate);
-            noteSources.add(newSource.release());
-            transportSources.add(new AudioTransportSource);
-        }
-        else
+#include "Audio_AllocationGuard.h"
+
+// Maximum number of commands that may wait for the next audio block:
+static const constexpr int commandQueueSize = 512;
+
+NotePlayer::NotePlayer() :
+noteMix(Audio::SampleKit::numNotes),
+activeNoteMix(Audio::SampleKit::numNotes),
+musicBoxPitches(Audio::ModalSynth::getMusicBoxPitches()),
+readAheadThread(voicePool),
+commandQueue(commandQueueSize),
+sampleLoader(*this)
+{
+    // Make sure debug builds catch allocation in the audio callback:
+    jassert(Audio::ScopedNoAllocation::detectsBufferAllocation());
+}
+
+NotePlayer::~NotePlayer()
+{
+    resetPlayback();
+    for (const Audio::CommandQueue::Command& command : heldCommands)
+    {
+        discardCommand(command);
+    }
+}
+
+bool NotePlayer::isReady() const
+{
+    return ready.load();
+}
+
+void NotePlayer::setEarlyNotePolicy(const EarlyNotePolicy policy)
+{
+    earlyNotePolicy = policy;
+}
+
+void NotePlayer::setSampleStorage(const Audio::SampleBank::Storage storage)
+{
+    sampleLoader.setStorage(storage);
+}
+
+void NotePlayer::setEngine(const Engine newEngine)
+{
+    if (newEngine == engine)
+    {
+        return;
+    }
+    engine = newEngine;
+    Audio::CommandQueue::Command command = {};
+    command.type = Audio::CommandQueue::Command::Type::setEngine;
+    command.intValue = (int) newEngine;
+    sendCommand(command);
+    if (engine == Engine::modalSynth)
+    {
+        // The synth needs no samples, so notes can play immediately:
+        if (! ready.load())
         {
-            jassertfalse;
+            setReady();
         }
+        return;
+    }
+    // The audio thread released its bank when the synth was selected:
+    if (ready.exchange(false))
+    {
+        sendChangeMessage();
+    }
+    const double sampleRate = preparedSampleRate.load();
+    if (sampleRate > 0)
+    {
+        sampleLoader.loadSamples(sampleRate);
     }
 }
 
-NotePlayer::~NotePlayer()
+NotePlayer::Engine NotePlayer::getEngine() const
+{
+    return engine;
+}
+
+void NotePlayer::loadSampleKit(const File& kitFile)
+{
+    sampleKitResult = Result::ok();
+    sampleLoader.loadKit(kitFile);
+}
+
+String NotePlayer::getSampleKitName() const
+{
+    return sampleLoader.getKitName();
+}
+
+Result NotePlayer::getSampleKitResult() const
 {
-    transportSources.clear();
-    noteSources.clear();
+    return sampleKitResult;
 }
 
 void NotePlayer::playNote(int note)
 {
-    const ScopedLock audioLock(deviceManager.getAudioCallbackLock());
-    AudioTransportSource* transport = transportSources[note];
-    AudioFormatReaderSource* noteSource = noteSources[note];
-    if (transport != nullptr && noteSource != nullptr)
-    {
-        transport->setSource(noteSource, 0, nullptr, sampleRates[note]);
-        transport->start();
-    }
-    else
+    if (note < 0 || note >= Audio::SampleKit::maxNotes)
     {
         DBG("Failed to start note " << note);
         jassertfalse;
+        return;
     }
+    Audio::CommandQueue::Command command = {};
+    command.type = Audio::CommandQueue::Command::Type::playNote;
+    command.note = note;
+    sendCommand(command);
 }
 
 void NotePlayer::playNotes(Array<int> notes)
@@ -77,52 +115,574 @@ void NotePlayer::playNotes(Array<int> notes)
     }
 }
 
+void NotePlayer::stopAllNotes()
+{
+    Audio::CommandQueue::Command command = {};
+    command.type = Audio::CommandQueue::Command::Type::stopAllNotes;
+    sendCommand(command);
+}
+
+void NotePlayer::setPolyphony(const int polyphony)
+{
+    Audio::CommandQueue::Command command = {};
+    command.type = Audio::CommandQueue::Command::Type::setPolyphony;
+    command.intValue = polyphony;
+    sendCommand(command);
+}
+
+void NotePlayer::setStealingPolicy(
+        const Audio::VoicePool::StealingPolicy policy)
+{
+    Audio::CommandQueue::Command command = {};
+    command.type = Audio::CommandQueue::Command::Type::setStealingPolicy;
+    command.intValue = (int) policy;
+    sendCommand(command);
+}
+
+void NotePlayer::setCullThreshold(const float thresholdDb)
+{
+    Audio::CommandQueue::Command command = {};
+    command.type = Audio::CommandQueue::Command::Type::setCullThreshold;
+    command.floatValue = Decibels::decibelsToGain(thresholdDb);
+    sendCommand(command);
+}
+
+void NotePlayer::setBodyResonance(const bool enabled)
+{
+    Audio::CommandQueue::Command command = {};
+    command.type = Audio::CommandQueue::Command::Type::setBodyResonance;
+    command.intValue = enabled ? 1 : 0;
+    sendCommand(command);
+}
+
+void NotePlayer::setLimiterCeiling(const float ceilingDb)
+{
+    Audio::CommandQueue::Command command = {};
+    command.type = Audio::CommandQueue::Command::Type::setLimiterCeiling;
+    command.floatValue = ceilingDb;
+    sendCommand(command);
+}
+
+void NotePlayer::setSoftClip(const bool enabled)
+{
+    Audio::CommandQueue::Command command = {};
+    command.type = Audio::CommandQueue::Command::Type::setSoftClip;
+    command.intValue = enabled ? 1 : 0;
+    sendCommand(command);
+}
+
+void NotePlayer::setNotePan(const int note, const float pan)
+{
+    noteMix.setPan(note, pan);
+    Audio::CommandQueue::Command command = {};
+    command.type = Audio::CommandQueue::Command::Type::setNotePan;
+    command.note = note;
+    command.floatValue = noteMix.getPan(note);
+    sendCommand(command);
+}
+
+float NotePlayer::getNotePan(const int note) const
+{
+    return noteMix.getPan(note);
+}
+
+void NotePlayer::setNoteGain(const int note, const float gain)
+{
+    noteMix.setGain(note, gain);
+    Audio::CommandQueue::Command command = {};
+    command.type = Audio::CommandQueue::Command::Type::setNoteGain;
+    command.note = note;
+    command.floatValue = noteMix.getGain(note);
+    sendCommand(command);
+}
+
+float NotePlayer::getNoteGain(const int note) const
+{
+    return noteMix.getGain(note);
+}
+
+void NotePlayer::setStereoWidth(const float width)
+{
+    noteMix.setWidth(width);
+    Audio::CommandQueue::Command command = {};
+    command.type = Audio::CommandQueue::Command::Type::setStereoWidth;
+    command.floatValue = noteMix.getWidth();
+    sendCommand(command);
+}
+
+float NotePlayer::getStereoWidth() const
+{
+    return noteMix.getWidth();
+}
+
+float NotePlayer::getGainReductionDb()
+{
+    return outputLimiter.getGainReductionDb();
+}
+
+int64 NotePlayer::getCulledVoiceCount() const
+{
+    return voicePool.getCulledVoiceCount();
+}
+
+int64 NotePlayer::getCulledFrameCount() const
+{
+    return voicePool.getCulledFrameCount();
+}
+
+void NotePlayer::startSequence(Audio::EventList::Ptr eventList, const int bpm)
+{
+    jassert(eventList != nullptr && bpm > 0);
+    eventListPool.add(eventList.get());
+    lastSequenceId++;
+    // This reference is removed by the audio thread:
+    eventList->incReferenceCount();
+    Audio::CommandQueue::Command command = {};
+    command.type = Audio::CommandQueue::Command::Type::startSequence;
+    command.bpm = bpm;
+    command.sequenceId = lastSequenceId;
+    command.eventList = eventList.get();
+    sendCommand(command);
+}
+
+void NotePlayer::updateSequence(Audio::EventList::Ptr eventList)
+{
+    jassert(eventList != nullptr);
+    if (! isSequencePlaying())
+    {
+        return;
+    }
+    eventListPool.add(eventList.get());
+    // This reference is removed by the audio thread:
+    eventList->incReferenceCount();
+    Audio::CommandQueue::Command command = {};
+    command.type = Audio::CommandQueue::Command::Type::updateSequence;
+    command.sequenceId = lastSequenceId;
+    command.eventList = eventList.get();
+    sendCommand(command);
+}
+
+void NotePlayer::stopSequence()
+{
+    Audio::CommandQueue::Command command = {};
+    command.type = Audio::CommandQueue::Command::Type::stopSequence;
+    command.sequenceId = lastSequenceId;
+    sendCommand(command);
+}
+
+bool NotePlayer::isSequencePlaying() const
+{
+    return finishedSequenceId.load() != lastSequenceId;
+}
+
+int NotePlayer::getSequenceBeat() const
+{
+    return sequenceBeat.load();
+}
+
+void NotePlayer::sendCommand(const Audio::CommandQueue::Command& command)
+{
+    typedef Audio::CommandQueue::Command::Type CommandType;
+    if (! ready.load() && command.type != CommandType::setSampleBank
+            && command.type != CommandType::setNoteLayout
+            && command.type != CommandType::setEngine)
+    {
+        if (earlyNotePolicy == EarlyNotePolicy::queue)
+        {
+            // Hold every command, so they still run in order once ready:
+            if (heldCommands.size() < commandQueueSize)
+            {
+                heldCommands.add(command);
+            }
+            else
+            {
+                discardCommand(command);
+            }
+            return;
+        }
+        if (command.type == CommandType::playNote
+                || command.type == CommandType::startSequence)
+        {
+            discardCommand(command);
+            return;
+        }
+    }
+    if (! commandQueue.push(command))
+    {
+        // The queue only fills up if the audio thread isn't running.
+        DBG("NotePlayer: command queue full, dropping command");
+        discardCommand(command);
+    }
+}
+
+void NotePlayer::discardCommand(const Audio::CommandQueue::Command& command)
+{
+    typedef Audio::CommandQueue::Command::Type CommandType;
+    if (command.eventList != nullptr)
+    {
+        command.eventList->decReferenceCountWithoutDeleting();
+    }
+    if (command.sampleBank != nullptr)
+    {
+        command.sampleBank->decReferenceCountWithoutDeleting();
+    }
+    if (command.type == CommandType::startSequence
+            || command.type == CommandType::stopSequence)
+    {
+        finishedSequenceId = command.sequenceId;
+    }
+}
+
+void NotePlayer::setReady()
+{
+    ready = true;
+    const Array<Audio::CommandQueue::Command> waitingCommands = heldCommands;
+    heldCommands.clear();
+    for (const Audio::CommandQueue::Command& waiting : waitingCommands)
+    {
+        sendCommand(waiting);
+    }
+    sendChangeMessage();
+}
+
+void NotePlayer::sampleBankLoaded(Audio::SampleBank::Ptr sampleBank)
+{
+    sampleBankPool.add(sampleBank.get());
+    // Every engine plays the notes of the last loaded kit:
+    if (sampleBank->getNumNotes() != noteMix.getNumNotes())
+    {
+        noteMix.setNumNotes(sampleBank->getNumNotes());
+    }
+    // This reference is removed by the audio thread:
+    sampleBank->incReferenceCount();
+    Audio::CommandQueue::Command layoutCommand = {};
+    layoutCommand.type = Audio::CommandQueue::Command::Type::setNoteLayout;
+    layoutCommand.sampleBank = sampleBank.get();
+    sendCommand(layoutCommand);
+    if (engine != Engine::samples)
+    {
+        // The bank was requested before the synth was selected:
+        return;
+    }
+    if (sampleBank->isStreamed())
+    {
+        readAheadThread.addSampleBank(sampleBank);
+        // No voice can be streaming yet, as this is the first streamed bank
+        // if the streams aren't allocated:
+        voicePool.allocateStreams();
+        readAheadThread.start();
+    }
+    // This reference is removed by the audio thread:
+    sampleBank->incReferenceCount();
+    Audio::CommandQueue::Command command = {};
+    command.type = Audio::CommandQueue::Command::Type::setSampleBank;
+    command.sampleBank = sampleBank.get();
+    sendCommand(command);
+    if (sampleLoader.isLoading())
+    {
+        // A newer bank was requested after this one finished:
+        return;
+    }
+    setReady();
+}
+
+void NotePlayer::sampleKitFailed(const Result& error)
+{
+    sampleKitResult = error;
+    sendChangeMessage();
+}
+
+void NotePlayer::setSampleBank(Audio::SampleBank* newBank)
+{
+    // Only adopt banks at the current output sample rate. The sample pool
+    // still holds a reference, so releasing either bank never deletes it.
+    // Playing voices hold their own reference to the old bank, so they
+    // finish with its samples:
+    if (activeEngine == Engine::samples
+            && newBank->getSampleRate() == outputSampleRate)
+    {
+        sampleBank = newBank;
+    }
+    newBank->decReferenceCountWithoutDeleting();
+}
+
+void NotePlayer::setNoteLayout(Audio::SampleBank* noteBank)
+{
+    // Both mix tables always hold space for every note, and change their
+    // note count the same way, so they stay in step without allocating:
+    if (noteBank->getNumNotes() != activeNoteMix.getNumNotes())
+    {
+        activeNoteMix.setNumNotes(noteBank->getNumNotes());
+    }
+    // The synth copies the pitches into its own fixed note table, so it plays
+    // the same notes as the samples would:
+    const Array<double>& frequencies = noteBank->getNoteFrequencies();
+    modalSynth.setPitches(frequencies.isEmpty() ? musicBoxPitches
+            : frequencies);
+    noteBank->decReferenceCountWithoutDeleting();
+}
+
+void NotePlayer::setActiveEngine(const Engine newEngine)
+{
+    activeEngine = newEngine;
+    if (activeEngine == Engine::modalSynth)
+    {
+        // The release pool frees the bank's samples once the voices still
+        // playing it finish:
+        sampleBank = nullptr;
+    }
+}
+
+void NotePlayer::handleCommand(const Audio::CommandQueue::Command& command)
+{
+    typedef Audio::CommandQueue::Command::Type CommandType;
+    switch (command.type)
+    {
+        case CommandType::playNote:
+            startNote(command.note);
+            break;
+        case CommandType::stopAllNotes:
+            voicePool.stopAllVoices();
+            modalSynth.stopAllNotes();
+            break;
+        case CommandType::startSequence:
+            sequencer.start(command.eventList,
+                    Audio::Sequencer::samplesPerBeat(command.bpm,
+                        outputSampleRate),
+                    command.sequenceId);
+            // The release pool still holds a reference, so this never
+            // deletes the list:
+            command.eventList->decReferenceCountWithoutDeleting();
+            break;
+        case CommandType::updateSequence:
+            // Edits to a sequence that already finished or was replaced are
+            // ignored:
+            if (sequencer.getSequenceId() == command.sequenceId)
+            {
+                sequencer.replaceEventList(command.eventList);
+            }
+            command.eventList->decReferenceCountWithoutDeleting();
+            break;
+        case CommandType::stopSequence:
+            sequencer.stop();
+            finishedSequenceId = command.sequenceId;
+            break;
+        case CommandType::setPolyphony:
+            voicePool.setPolyphony(command.intValue);
+            modalSynth.setPolyphony(command.intValue);
+            break;
+        case CommandType::setStealingPolicy:
+            voicePool.setStealingPolicy((Audio::VoicePool::StealingPolicy)
+                    command.intValue);
+            break;
+        case CommandType::setCullThreshold:
+            voicePool.setCullThreshold(command.floatValue);
+            modalSynth.setCullThreshold(command.floatValue);
+            break;
+        case CommandType::setSampleBank:
+            setSampleBank(command.sampleBank);
+            break;
+        case CommandType::setNoteLayout:
+            setNoteLayout(command.sampleBank);
+            break;
+        case CommandType::setEngine:
+            setActiveEngine((Engine) command.intValue);
+            break;
+        case CommandType::setBodyResonance:
+            if (command.intValue != 0 && ! bodyResonance)
+            {
+                // Don't replay the tail left from the last time it was
+                // enabled:
+                bodyConvolver.reset();
+            }
+            bodyResonance = (command.intValue != 0);
+            break;
+        case CommandType::setLimiterCeiling:
+            outputLimiter.setCeiling(command.floatValue);
+            break;
+        case CommandType::setSoftClip:
+            outputLimiter.setSoftClip(command.intValue != 0);
+            break;
+        case CommandType::setNotePan:
+            activeNoteMix.setPan(command.note, command.floatValue);
+            break;
+        case CommandType::setNoteGain:
+            activeNoteMix.setGain(command.note, command.floatValue);
+            break;
+        case CommandType::setStereoWidth:
+            activeNoteMix.setWidth(command.floatValue);
+            break;
+    }
+}
+
+void NotePlayer::handleCommands()
+{
+    Audio::CommandQueue::Command command;
+    while (commandQueue.pop(command))
+    {
+        handleCommand(command);
+    }
+}
+
+void NotePlayer::startNote(const int note, const float gain)
+{
+    // Note gains are folded into each voice's mix gain, so they add nothing
+    // to the cost of mixing:
+    const float voiceGain = activeNoteMix.getGain(note) * gain;
+    if (activeEngine == Engine::modalSynth)
+    {
+        modalSynth.startNote(note, voiceGain,
+                activeNoteMix.getMixedPan(note));
+        return;
+    }
+    if (sampleBank == nullptr)
+    {
+        return;
+    }
+    voicePool.startVoice(note, *sampleBank, voiceGain,
+            activeNoteMix.getMixedPan(note));
+}
+
 void NotePlayer::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
 {
-    for (AudioTransportSource* source : transportSources)
+    resetPlayback();
+    outputSampleRate = sampleRate;
+    preparedSampleRate = sampleRate;
+    voicePool.setSampleRate(sampleRate);
+    modalSynth.setSampleRate(sampleRate);
+    // Samples only need to be decoded again if the sample rate changed:
+    if (activeEngine == Engine::samples && (sampleBank == nullptr
+            || sampleBank->getSampleRate() != sampleRate))
     {
-        if (source != nullptr)
+        sampleBank = nullptr;
+        if (ready.exchange(false))
         {
-            source->prepareToPlay(samplesPerBlockExpected, sampleRate);
+            sendChangeMessage();
         }
+        sampleLoader.loadSamples(sampleRate);
     }
+    mixBuffer.setSize(2, jmax(samplesPerBlockExpected, 1));
+    mixBuffer.clear();
+    bodyConvolver.prepare(Audio::Convolver::createBodyResponse(sampleRate),
+            sampleRate, samplesPerBlockExpected);
+    outputLimiter.prepare(sampleRate);
 }
 
 void NotePlayer::getNextAudioBlock(const AudioSourceChannelInfo& bufferToFill)
 {
-    const int numChannels = 2;
-    const int numSamples = bufferToFill.numSamples;
-    const int startSample = bufferToFill.startSample;
-    bool sourcePlaying = false;
-    for (AudioTransportSource* source : transportSources)
+    const Audio::ScopedNoAllocation noAllocation;
+    handleCommands();
+    AudioBuffer<float>& output = *bufferToFill.buffer;
+    if (mixBuffer.getNumSamples() == 0 || output.getNumChannels() == 0)
+    {
+        bufferToFill.clearActiveBufferRegion();
+        return;
+    }
+    // Split the block into sections at each sequence event, and so that no
+    // section is larger than the mix buffer:
+    int startSample = bufferToFill.startSample;
+    int samplesLeft = bufferToFill.numSamples;
+    while (samplesLeft > 0)
     {
-        if (source != nullptr && source->isPlaying())
+        while (const Audio::EventList::Event* event
+                = sequencer.getNextDueEvent())
         {
-            sourcePlaying = true;
-            AudioBuffer<float> tempBuffer(numChannels, numSamples);
-            AudioSourceChannelInfo tempInfo(&tempBuffer, startSample,
-                    numSamples);
-            source->getNextAudioBlock(tempInfo);
-            for (int i = 0; i < numChannels; i++)
+            for (int i = 0; i < event->numNotes; i++)
             {
-                bufferToFill.buffer->addFrom(i, startSample, tempBuffer, i,
-                        startSample, numSamples);
+                startNote(event->notes[i],
+                        (event->gains == nullptr) ? 1.0f : event->gains[i]);
             }
         }
+        const int numSamples = sequencer.getSamplesUntilNextEvent(
+                jmin(samplesLeft, mixBuffer.getNumSamples()));
+        renderSection(output, startSample, numSamples);
+        const bool wasPlaying = sequencer.isPlaying();
+        sequencer.advance(numSamples);
+        if (wasPlaying && ! sequencer.isPlaying())
+        {
+            finishedSequenceId = sequencer.getSequenceId();
+        }
+        startSample += numSamples;
+        samplesLeft -= numSamples;
     }
-    if(!sourcePlaying)
+    sequenceBeat = sequencer.getCurrentBeat();
+}
+
+void NotePlayer::renderSection(AudioBuffer<float>& output,
+        const int startSample, const int numSamples)
+{
+    if (voicePool.getActiveVoiceCount() == 0
+            && modalSynth.getActiveVoiceCount() == 0
+            && ! (bodyResonance && bodyConvolver.isRinging())
+            && ! outputLimiter.isRinging())
     {
-        bufferToFill.clearActiveBufferRegion();
+        output.clear(startSample, numSamples);
+        return;
+    }
+    // Mono output is mixed directly in mono, so the second channel is never
+    // rendered only to be folded away:
+    const int numChannels = output.getNumChannels();
+    float* left = mixBuffer.getWritePointer(0);
+    float* right = (numChannels == 1) ? nullptr : mixBuffer.getWritePointer(1);
+    FloatVectorOperations::clear(left, numSamples);
+    if (right != nullptr)
+    {
+        FloatVectorOperations::clear(right, numSamples);
+    }
+    voicePool.renderNextBlock(left, right, numSamples);
+    modalSynth.renderNextBlock(left, right, numSamples);
+    if (bodyResonance)
+    {
+        bodyConvolver.process(left, right, numSamples);
+    }
+    outputLimiter.process(left, right, numSamples);
+    output.copyFrom(0, startSample, left, numSamples);
+    if (right != nullptr)
+    {
+        output.copyFrom(1, startSample, right, numSamples);
+    }
+    // Any channels past the first two only receive silence:
+    for (int i = 2; i < numChannels; i++)
+    {
+        output.clear(i, startSample, numSamples);
     }
 }
 
 void NotePlayer::releaseResources()
 {
-    for (AudioTransportSource* source : transportSources)
+    resetPlayback();
+    mixBuffer.setSize(0, 0);
+}
+
+void NotePlayer::resetPlayback()
+{
+    typedef Audio::CommandQueue::Command::Type CommandType;
+    voicePool.stopAllVoices();
+    modalSynth.stopAllNotes();
+    bodyConvolver.reset();
+    outputLimiter.reset();
+    // Discard all queued notes and sequences, as they're no longer relevant,
+    // but keep every new sample bank and setting:
+    Audio::CommandQueue::Command command;
+    while (commandQueue.pop(command))
     {
-        if (source != nullptr)
+        if (command.type == CommandType::playNote
+                || command.type == CommandType::stopAllNotes
+                || command.type == CommandType::startSequence
+                || command.type == CommandType::updateSequence
+                || command.type == CommandType::stopSequence)
+        {
+            discardCommand(command);
+        }
+        else
         {
-            source->releaseResources();
+            handleCommand(command);
         }
     }
+    if (sequencer.isPlaying())
+    {
+        finishedSequenceId = sequencer.getSequenceId();
+        sequencer.stop();
+    }
+    sequenceBeat = -1;
 }
@@ -1,22 +1,362 @@
 /**
  * @file  NotePlayer.h
  *
- * @brief  Plays music box notes using audio samples.
+ * @brief  Plays music box notes using audio samples or a synthesized model.
  */
 
 #pragma once
 #include "JuceHeader.h"
+#include "Audio_VoicePool.h"
+#include "Audio_SampleBank.h"
+#include "Audio_CommandQueue.h"
+#include "Audio_Sequencer.h"
+#include "Audio_ReleasePool.h"
+#include "Audio_SampleLoader.h"
+#include "Audio_ReadAheadThread.h"
+#include "Audio_ModalSynth.h"
+#include "Audio_Convolver.h"
+#include "Audio_Limiter.h"
+#include "Audio_NoteMixTable.h"
+#include <atomic>
 
-class NotePlayer : public AudioSource
+/**
+ * @brief  Plays notes and note sequences on the audio thread.
+ *
+ *  Note samples are loaded on a background thread whenever the output sample
+ * rate changes, so neither the window nor the audio device waits for samples
+ * to decode. Until the samples are ready, commands that would start notes are
+ * either held until loading finishes or discarded, depending on the early
+ * note policy. A change message is sent whenever the player becomes ready or
+ * starts loading again.
+ *
+ *  Other sample kits may be loaded while notes are playing. The new kit's
+ * samples are loaded in the background, then swapped in on the audio thread
+ * without stopping anything: notes started before the swap finish with the
+ * old kit's samples, and later notes use the new kit.
+ *
+ *  Notes may instead be played by a ModalSynth, which needs no samples at
+ * all. The synth plays the notes of the last loaded kit, at the pitches of
+ * its layout. While the synth engine is selected, sample banks are released
+ * once notes already playing from them finish, and samples are loaded again
+ * when the sample engine is selected.
+ *
+ *  The mixed output of both engines may be passed through a convolution with
+ * the impulse response of a wooden music box, adding the resonance of the
+ * box and the table it rests on. This delays all output by one convolution
+ * partition, at most Audio::Convolver::maxPartitionSize frames.
+ *
+ *  Finally, the output passes through a look-ahead limiter, so dense chords
+ * never clip. The limiter adds Audio::Limiter::lookaheadSeconds of latency.
+ *
+ *  The mix follows the output buffer's channel layout. Mono output is mixed
+ * in mono throughout, and stereo output places each note using a
+ * configurable pan and gain table, by default spreading low notes to the left
+ * and high notes to the right. Any output channels past the first two are
+ * left silent.
+ */
+class NotePlayer : public AudioSource, public ChangeBroadcaster,
+    private Audio::SampleLoader::Listener
 {
 public:
-    NotePlayer(AudioDeviceManager& deviceManager);
+    /**
+     * @brief  Ways to handle notes played before samples finish loading.
+     */
+    enum class EarlyNotePolicy
+    {
+        // Hold notes and sequences, starting them once samples are ready:
+        queue,
+        // Discard notes and sequences started before samples are ready:
+        drop
+    };
+
+    /**
+     * @brief  The ways notes can be played.
+     */
+    enum class Engine
+    {
+        // Play the current sample kit's note samples:
+        samples,
+        // Synthesize notes with a physical model of each tine:
+        modalSynth
+    };
+
+    NotePlayer();
     virtual ~NotePlayer();
 
-    void playNote(int notes);
+    /**
+     * @brief  Checks if note samples are loaded and ready to play. This
+     *         should only be called on the message thread.
+     *
+     * @return  Whether notes played now will be heard.
+     */
+    bool isReady() const;
+
+    /**
+     * @brief  Sets how notes played before samples are ready are handled.
+     *         This should only be called on the message thread.
+     *
+     * @param policy  The new early note policy.
+     */
+    void setEarlyNotePolicy(const EarlyNotePolicy policy);
+
+    /**
+     * @brief  Sets how note samples are stored in memory, reloading samples
+     *         if they were already loaded. Notes keep playing with the old
+     *         samples until the new ones are ready. This should only be
+     *         called on the message thread.
+     *
+     * @param storage  Whether samples are fully decoded, or stored as 16-bit
+     *                 data and streamed during playback.
+     */
+    void setSampleStorage(const Audio::SampleBank::Storage storage);
+
+    /**
+     * @brief  Selects the engine used to play new notes. Notes that are
+     *         already playing finish with their old engine. This should only
+     *         be called on the message thread.
+     *
+     * @param newEngine  The engine that will play all new notes.
+     */
+    void setEngine(const Engine newEngine);
 
+    /**
+     * @brief  Gets the engine used to play new notes. This should only be
+     *         called on the message thread.
+     *
+     * @return  The last engine passed to setEngine.
+     */
+    Engine getEngine() const;
+
+    /**
+     * @brief  Starts loading a sample kit in the background, replacing the
+     *         current kit once it loads. Notes keep playing with the current
+     *         kit until then. This should only be called on the message
+     *         thread.
+     *
+     * @param kitFile  A kit directory, kit.json manifest, or .zip archive.
+     */
+    void loadSampleKit(const File& kitFile);
+
+    /**
+     * @brief  Gets the name of the sample kit used to play notes. This
+     *         should only be called on the message thread.
+     *
+     * @return  The name of the last kit that loaded successfully.
+     */
+    String getSampleKitName() const;
+
+    /**
+     * @brief  Checks whether the last kit passed to loadSampleKit failed to
+     *         load. A change message is sent when a kit fails. This should
+     *         only be called on the message thread.
+     *
+     * @return  A failed result describing the error if the kit failed, or an
+     *          ok result otherwise.
+     */
+    Result getSampleKitResult() const;
+
+    /**
+     * @brief  Queues a note to start playing in the next audio block. This
+     *         should only be called on the message thread.
+     *
+     * @param note  The index of the note to play.
+     */
+    void playNote(int note);
+
+    /**
+     * @brief  Queues a set of notes to start playing together in the next
+     *         audio block. This should only be called on the message thread.
+     *
+     * @param notes  The indices of all notes to play.
+     */
     void playNotes(Array<int> notes);
 
+    /**
+     * @brief  Queues a command to stop all playing notes. This should only be
+     *         called on the message thread.
+     */
+    void stopAllNotes();
+
+    /**
+     * @brief  Sets the maximum number of notes that may play at once. This
+     *         should only be called on the message thread.
+     *
+     * @param polyphony  The new voice limit, between one and
+     *                   Audio::VoicePool::maxPolyphony.
+     */
+    void setPolyphony(const int polyphony);
+
+    /**
+     * @brief  Sets how voices are chosen when new notes would exceed the
+     *         polyphony limit. The synth engine always steals its oldest
+     *         voice. This should only be called on the message thread.
+     *
+     * @param policy  The new voice stealing policy.
+     */
+    void setStealingPolicy(const Audio::VoicePool::StealingPolicy policy);
+
+    /**
+     * @brief  Sets the level below which fading notes are stopped early. This
+     *         should only be called on the message thread.
+     *
+     * @param thresholdDb  The cull threshold in decibels. Values at or below
+     *                     -100dB disable culling.
+     */
+    void setCullThreshold(const float thresholdDb);
+
+    /**
+     * @brief  Turns the body resonance stage on or off. This should only be
+     *         called on the message thread.
+     *
+     * @param enabled  Whether the output passes through the body resonance.
+     */
+    void setBodyResonance(const bool enabled);
+
+    /**
+     * @brief  Sets the highest level the output limiter allows. This should
+     *         only be called on the message thread.
+     *
+     * @param ceilingDb  The output ceiling in decibels, at or below 0dB.
+     */
+    void setLimiterCeiling(const float ceilingDb);
+
+    /**
+     * @brief  Turns soft clipping of output peaks on or off. This should only
+     *         be called on the message thread.
+     *
+     * @param enabled  Whether the output limiter softly clips peaks.
+     */
+    void setSoftClip(const bool enabled);
+
+    /**
+     * @brief  Sets the stereo position of a note. Notes that are already
+     *         playing keep their old position, and loading a kit with a
+     *         different number of notes replaces every position. This should
+     *         only be called on the message thread.
+     *
+     * @param note  The index of the note, below Audio::NoteMixTable::maxNotes.
+     *
+     * @param pan   The note's position, from -1 for hard left to 1 for hard
+     *              right.
+     */
+    void setNotePan(const int note, const float pan);
+
+    /**
+     * @brief  Gets the stereo position of a note, before the stereo width is
+     *         applied. This should only be called on the message thread.
+     *
+     * @param note  The index of the note.
+     *
+     * @return      The note's position, from -1 to 1.
+     */
+    float getNotePan(const int note) const;
+
+    /**
+     * @brief  Sets the gain of a note. Notes that are already playing keep
+     *         their old gain. This should only be called on the message
+     *         thread.
+     *
+     * @param note  The index of the note, below Audio::NoteMixTable::maxNotes.
+     *
+     * @param gain  The note's linear gain, zero or above.
+     */
+    void setNoteGain(const int note, const float gain);
+
+    /**
+     * @brief  Gets the gain of a note. This should only be called on the
+     *         message thread.
+     *
+     * @param note  The index of the note.
+     *
+     * @return      The note's linear gain.
+     */
+    float getNoteGain(const int note) const;
+
+    /**
+     * @brief  Sets how widely notes are spread across the stereo field. This
+     *         should only be called on the message thread.
+     *
+     * @param width  The multiplier applied to every note's position, from 0
+     *               for mono to Audio::NoteMixTable::maxWidth.
+     */
+    void setStereoWidth(const float width);
+
+    /**
+     * @brief  Gets how widely notes are spread across the stereo field. This
+     *         should only be called on the message thread.
+     *
+     * @return  The multiplier applied to every note's position.
+     */
+    float getStereoWidth() const;
+
+    /**
+     * @brief  Gets the largest gain reduction the output limiter applied since
+     *         the last call. This may be called on any thread, but only one
+     *         thread should read it.
+     *
+     * @return  The gain reduction in decibels, zero or above.
+     */
+    float getGainReductionDb();
+
+    /**
+     * @brief  Gets the number of notes stopped early because they fell below
+     *         the cull threshold.
+     *
+     * @return  The number of culled voices.
+     */
+    int64 getCulledVoiceCount() const;
+
+    /**
+     * @brief  Gets the number of sample frames that culled notes would have
+     *         played.
+     *
+     * @return  The number of frames skipped by culling.
+     */
+    int64 getCulledFrameCount() const;
+
+    /**
+     * @brief  Starts playing a sequence of notes on the audio thread, stopping
+     *         any sequence that was already playing. This should only be
+     *         called on the message thread.
+     *
+     * @param eventList  The notes to play.
+     *
+     * @param bpm        The playback speed in beats per minute.
+     */
+    void startSequence(Audio::EventList::Ptr eventList, const int bpm);
+
+    /**
+     * @brief  Replaces the notes of the playing sequence with an edited
+     *         version, without moving its playback position. This does
+     *         nothing if the sequence has finished, and should only be called
+     *         on the message thread.
+     *
+     * @param eventList  The edited notes to play.
+     */
+    void updateSequence(Audio::EventList::Ptr eventList);
+
+    /**
+     * @brief  Stops the playing sequence, if any. Notes that were already
+     *         started will continue to ring. This should only be called on
+     *         the message thread.
+     */
+    void stopSequence();
+
+    /**
+     * @brief  Checks if the last sequence started with startSequence is
+     *         still playing.
+     *
+     * @return  Whether the sequence hasn't yet finished or been stopped.
+     */
+    bool isSequencePlaying() const;
+
+    /**
+     * @brief  Gets the beat currently playing in the active sequence.
+     *
+     * @return  The index of the playing beat, or -1 if no sequence is playing.
+     */
+    int getSequenceBeat() const;
+
     void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override;
 
     void getNextAudioBlock(const AudioSourceChannelInfo& bufferToFill) override;
@@ -24,9 +364,182 @@ public:
     void releaseResources() override;
 
 private:
-    AudioDeviceManager& deviceManager;
-    AudioFormatManager formatManager;
-    OwnedArray<AudioTransportSource> transportSources;
-    OwnedArray<AudioFormatReaderSource> noteSources;
-    Array<double> sampleRates;
+    /**
+     * @brief  Adds a command to the audio thread's command queue, or holds or
+     *         discards it if samples aren't ready yet.
+     *
+     * @param command  The command to send.
+     */
+    void sendCommand(const Audio::CommandQueue::Command& command);
+
+    /**
+     * @brief  Marks the player as ready, sends all commands held while it
+     *         wasn't ready, and sends a change message.
+     */
+    void setReady();
+
+    /**
+     * @brief  Releases a command that will never reach the audio thread.
+     *
+     * @param command  The discarded command.
+     */
+    void discardCommand(const Audio::CommandQueue::Command& command);
+
+    /**
+     * @brief  Sends a newly loaded sample bank to the audio thread, followed
+     *         by all commands held while it was loading. Note positions are
+     *         spread again if the bank's kit plays a different number of
+     *         notes.
+     *
+     * @param sampleBank  A bank loaded at the output sample rate.
+     */
+    void sampleBankLoaded(Audio::SampleBank::Ptr sampleBank) override;
+
+    /**
+     * @brief  Records why a requested sample kit failed to load, and sends a
+     *         change message.
+     *
+     * @param error  The failed result of loading the kit.
+     */
+    void sampleKitFailed(const Result& error) override;
+
+    /**
+     * @brief  Replaces the sample bank used to start new notes. Playing notes
+     *         keep using their own bank until they finish. This should only be
+     *         called on the audio thread, or while the audio device is
+     *         stopped.
+     *
+     * @param newBank  The new sample bank. The bank's command reference is
+     *                 removed.
+     */
+    void setSampleBank(Audio::SampleBank* newBank);
+
+    /**
+     * @brief  Matches the notes that may be played to a newly loaded bank,
+     *         spreading them across the stereo field again if the number of
+     *         notes changed, and tuning the synth to the bank's pitches. This
+     *         should only be called on the audio thread, or while the audio
+     *         device is stopped.
+     *
+     * @param noteBank  The newly loaded bank. The bank's command reference is
+     *                  removed.
+     */
+    void setNoteLayout(Audio::SampleBank* noteBank);
+
+    /**
+     * @brief  Changes the engine used to start new notes, releasing the
+     *         sample bank if it is no longer needed. This should only be
+     *         called on the audio thread, or while the audio device is
+     *         stopped.
+     *
+     * @param newEngine  The engine that will play all new notes.
+     */
+    void setActiveEngine(const Engine newEngine);
+
+    /**
+     * @brief  Applies a single command. This should only be called on the
+     *         audio thread, or while the audio device is stopped.
+     *
+     * @param command  The command to apply.
+     */
+    void handleCommand(const Audio::CommandQueue::Command& command);
+
+    /**
+     * @brief  Applies all commands queued since the last audio block. This
+     *         should only be called on the audio thread.
+     */
+    void handleCommands();
+
+    /**
+     * @brief  Stops all notes and sequences, and discards all queued commands.
+     *         This should only be called while the audio device is stopped.
+     */
+    void resetPlayback();
+
+    /**
+     * @brief  Starts a note with the active engine. This should only be
+     *         called on the audio thread.
+     *
+     * @param note  The index of the note to start.
+     *
+     * @param gain  The note's own gain, applied along with its mix table
+     *              gain.
+     */
+    void startNote(const int note, const float gain = 1.0f);
+
+    /**
+     * @brief  Renders a section of the output buffer with no sequence events
+     *         occurring inside it. This should only be called on the audio
+     *         thread.
+     *
+     * @param output       The audio output buffer.
+     *
+     * @param startSample  The first sample in the buffer to render.
+     *
+     * @param numSamples   The number of samples to render, no larger than the
+     *                     size of the mix buffer.
+     */
+    void renderSection(AudioBuffer<float>& output, const int startSample,
+            const int numSamples);
+
+    // Holds each note's sample data at the output sample rate. This is only
+    // used on the audio thread, or while the audio device is stopped.
+    Audio::SampleBank::Ptr sampleBank;
+    // Ensures sample banks are never deleted on the audio thread:
+    Audio::ReleasePool<Audio::SampleBank> sampleBankPool;
+    // Whether the last requested sample bank was sent to the audio thread,
+    // or the synth engine is selected:
+    std::atomic<bool> ready { false };
+    // The engine selected on the message thread:
+    Engine engine = Engine::samples;
+    // The engine used to start notes on the audio thread:
+    Engine activeEngine = Engine::samples;
+    // Chooses what happens to notes played while samples are loading:
+    EarlyNotePolicy earlyNotePolicy = EarlyNotePolicy::drop;
+    // Commands held on the message thread until samples are ready:
+    Array<Audio::CommandQueue::Command> heldCommands;
+    // The result of loading the last requested sample kit:
+    Result sampleKitResult = Result::ok();
+    // The output sample rate, or zero if playback hasn't been prepared:
+    double outputSampleRate = 0;
+    // The output sample rate, read on the message thread when samples need
+    // to be loaded again:
+    std::atomic<double> preparedSampleRate { 0 };
+    // Each note's position and gain, as set on the message thread:
+    Audio::NoteMixTable noteMix;
+    // Each note's position and gain, used to start notes on the audio thread:
+    Audio::NoteMixTable activeNoteMix;
+    // The synth's pitches for kits that play the default note layout:
+    const Array<double> musicBoxPitches;
+    // Buffer where voices are mixed before copying to each output channel,
+    // using only its first channel for mono output. This is only resized in
+    // prepareToPlay, never in the audio callback.
+    AudioBuffer<float> mixBuffer;
+    // Plays all note samples:
+    Audio::VoicePool voicePool;
+    // Synthesizes notes when the synth engine is selected:
+    Audio::ModalSynth modalSynth;
+    // Adds the music box's body resonance to the mixed output:
+    Audio::Convolver bodyConvolver;
+    // Whether the body resonance is applied on the audio thread:
+    bool bodyResonance = false;
+    // Keeps the output from clipping:
+    Audio::Limiter outputLimiter;
+    // Fills voice sample streams when playing streamed banks:
+    Audio::ReadAheadThread readAheadThread;
+    // Passes commands from the message thread to the audio thread:
+    Audio::CommandQueue commandQueue;
+    // Plays event lists on the audio thread:
+    Audio::Sequencer sequencer;
+    // Ensures event lists are never deleted on the audio thread:
+    Audio::ReleasePool<Audio::EventList> eventListPool;
+    // The ID of the last sequence started on the message thread:
+    uint32 lastSequenceId = 0;
+    // The ID of the last sequence the audio thread finished or stopped:
+    std::atomic<uint32> finishedSequenceId { 0 };
+    // The beat the sequencer is playing, or -1 if no sequence is playing:
+    std::atomic<int> sequenceBeat { -1 };
+    // Loads note samples in the background. This is declared last so it stops
+    // before anything it notifies is destroyed.
+    Audio::SampleLoader sampleLoader;
 };
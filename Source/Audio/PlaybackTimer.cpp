@@ -1,5 +1,8 @@
 #include "PlaybackTimer.h"
-#include "NoteGrid.h"
+#include "Audio_EventList.h"
+
+// Milliseconds between playback progress updates:
+static const constexpr int updateFrequency = 15;
 
 PlaybackTimer::PlaybackTimer(NotePlayer& notePlayer) :
 notePlayer(notePlayer) { }
@@ -23,41 +26,54 @@ void PlaybackTimer::startPlayback(NoteGrid* noteGrid, const int bpm)
         stopPlayback();
     }
     this->noteGrid = noteGrid;
-    this->numBeats = noteGrid->getBeatCount();
-    frequency = msFromBPM(bpm);
-    startTimer(1);
+    beatIndex = -1;
+    editedBeats = Range<int>();
+    eventList = new Audio::EventList(noteGrid->getNoteMap(),
+            noteGrid->getBeatCount(), noteGrid->getGainMap());
+    notePlayer.startSequence(eventList, bpm);
+    noteGrid->addListener(this);
+    startTimer(updateFrequency);
 }
 
 void PlaybackTimer::stopPlayback()
 {
     stopTimer();
+    notePlayer.stopSequence();
+    if (noteGrid != nullptr)
+    {
+        noteGrid->removeListener(this);
+    }
     noteGrid = nullptr;
-    beatIndex = 0;
-    numBeats = 0;
+    beatIndex = -1;
+    eventList = nullptr;
+    editedBeats = Range<int>();
 }
 
 void PlaybackTimer::timerCallback()
 {
-    stopTimer();
-    if (beatIndex >= numBeats)
+    if (! editedBeats.isEmpty())
     {
-        stopPlayback();
-        return;
+        eventList = new Audio::EventList(*eventList, editedBeats,
+                noteGrid->getNoteMap(), noteGrid->getBeatCount(),
+                noteGrid->getGainMap());
+        editedBeats = Range<int>();
+        notePlayer.updateSequence(eventList);
     }
-    Array<int> notes = noteGrid->getNotes(beatIndex, true);
-    if (! notes.isEmpty())
+    const int playingBeat = notePlayer.getSequenceBeat();
+    while (beatIndex < playingBeat)
     {
-        notePlayer.playNotes(notes);
+        beatIndex++;
+        noteGrid->highlightBeat(beatIndex);
     }
-    beatIndex++;
-    if (!isTimerRunning())
+    if (! notePlayer.isSequencePlaying())
     {
-        startTimer(frequency);
+        stopPlayback();
     }
 }
 
-int PlaybackTimer::msFromBPM(const int bpm)
+void PlaybackTimer::notesChanged(NoteGrid* noteGrid, const Range<int> beats)
 {
-    return 36000 / bpm / 2;
+    jassert(noteGrid == this->noteGrid);
+    editedBeats = editedBeats.isEmpty() ? beats
+            : editedBeats.getUnionWith(beats);
 }
-
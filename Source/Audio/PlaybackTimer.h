@@ -1,29 +1,71 @@
+/**
+ * @file  PlaybackTimer.h
+ *
+ * @brief  Starts song playback, and follows its progress on the message
+ *         thread.
+ */
+
 #pragma once
 #include "JuceHeader.h"
 #include "NotePlayer.h"
+#include "NoteGrid.h"
 #include <map>
 
-class NoteGrid;
-
-class PlaybackTimer : public Timer
+/**
+ * @brief  Sends songs to the NotePlayer's sequencer, and highlights each beat
+ *         in the NoteGrid as it plays.
+ *
+ *  All note timing is handled on the audio thread. The timer only runs while
+ * playback is active, and is only used to update the NoteGrid, detect when
+ * playback finishes, and send edits to the playing song. Notes edited during
+ * playback are collected until the next timer update, then only the edited
+ * beats are recompiled into the song's event list.
+ */
+class PlaybackTimer : public Timer, private NoteGrid::Listener
 {
 public:
     PlaybackTimer(NotePlayer& notePlayer);
 
     virtual ~PlaybackTimer();
 
+    /**
+     * @brief  Starts playing all notes in a NoteGrid.
+     *
+     * @param notegrid  The NoteGrid holding the song to play.
+     *
+     * @param bpm       The playback speed in beats per minute.
+     */
     void startPlayback(NoteGrid* notegrid, const int bpm);
 
+    /**
+     * @brief  Stops playback if active.
+     */
     void stopPlayback();
 
 private:
+    /**
+     * @brief  Highlights all beats played since the last update, sends any
+     *         edited notes to the NotePlayer, and stops the timer once
+     *         playback ends.
+     */
     void timerCallback() override;
 
-    int msFromBPM(const int bpm);
+    /**
+     * @brief  Marks beats edited during playback so they're recompiled on the
+     *         next update.
+     *
+     * @param noteGrid  The NoteGrid being played.
+     *
+     * @param beats     The range of beats that changed.
+     */
+    void notesChanged(NoteGrid* noteGrid, const Range<int> beats) override;
 
     NotePlayer& notePlayer;
     NoteGrid* noteGrid = nullptr;
-    int beatIndex = 0;
-    int numBeats = 0;
-    int frequency;
+    // The last beat highlighted in the NoteGrid:
+    int beatIndex = -1;
+    // The event list most recently sent to the NotePlayer:
+    Audio::EventList::Ptr eventList;
+    // All beats edited since the event list was compiled:
+    Range<int> editedBeats;
 };
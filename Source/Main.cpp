@@ -1,6 +1,95 @@
 #include "../JuceLibraryCode/JuceHeader.h"
 #include "MainComponent.h"
 #include "Assets.h"
+#include "MusicFile.h"
+#include "Audio_OfflineRenderer.h"
+#include "Audio_BatchRenderer.h"
+#include "Audio_Benchmark.h"
+#include "Audio_SampleCache.h"
+
+// Command line option used to render a song file without opening a window:
+static const constexpr char* renderOption = "--render";
+// Command line option used to render a directory of song files without
+// opening a window:
+static const constexpr char* batchRenderOption = "--batch-render";
+// Command line option used to run audio benchmarks without opening a window:
+static const constexpr char* benchmarkOption = "--benchmark";
+
+/**
+ * @brief  Renders a music file to an audio file.
+ *
+ * @param songPath    The path to a .mb music file.
+ *
+ * @param outputPath  The path of the .wav or .flac file to write.
+ *
+ * @return            Whether the song was rendered.
+ */
+static bool renderSong(const String& songPath, const String& outputPath)
+{
+    const File songFile = File::getCurrentWorkingDirectory()
+            .getChildFile(songPath);
+    if (! songFile.existsAsFile())
+    {
+        std::cerr << "Song file " << songPath << " not found.\n";
+        return false;
+    }
+    MusicFile musicFile(songFile.getFullPathName());
+    Audio::EventList::Ptr eventList = new Audio::EventList(
+            musicFile.getNoteMap(), musicFile.getBeatCount(),
+            musicFile.getGainMap());
+    Audio::SampleCache sampleCache;
+    Audio::OfflineRenderer renderer(sampleCache.loadBank(
+            Audio::SampleBank::getNoteAssetNames(),
+            Audio::OfflineRenderer::defaultSampleRate));
+    const uint32 startTime = Time::getMillisecondCounter();
+    const Result result = renderer.renderToFile(eventList, musicFile.getBPM(),
+            File::getCurrentWorkingDirectory().getChildFile(outputPath));
+    if (result.failed())
+    {
+        std::cerr << result.getErrorMessage() << "\n";
+        return false;
+    }
+    std::cout << "Rendered " << songPath << " to " << outputPath << " in "
+            << (Time::getMillisecondCounter() - startTime) << "ms\n";
+    return true;
+}
+
+/**
+ * @brief  Renders every music file in a directory to audio files.
+ *
+ * @param songDirectory    The path to a directory holding .mb music files.
+ *
+ * @param outputDirectory  The path of the directory where audio files are
+ *                         written.
+ *
+ * @param format           The output format, either "wav" or "flac".
+ *
+ * @return                 Whether all songs were rendered.
+ */
+static bool renderSongDirectory(const String& songDirectory,
+        const String& outputDirectory, const String& format)
+{
+    if (format != "wav" && format != "flac")
+    {
+        std::cerr << "Unsupported output format " << format << "\n";
+        return false;
+    }
+    const File workingDirectory = File::getCurrentWorkingDirectory();
+    Audio::BatchRenderer renderer;
+    const uint32 startTime = Time::getMillisecondCounter();
+    const Result result = renderer.renderDirectory(
+            workingDirectory.getChildFile(songDirectory),
+            workingDirectory.getChildFile(outputDirectory), "." + format);
+    if (result.failed())
+    {
+        std::cerr << result.getErrorMessage() << "\n";
+        return false;
+    }
+    std::cout << "Rendered " << songDirectory << " to " << outputDirectory
+            << " in " << (Time::getMillisecondCounter() - startTime)
+            << "ms\n";
+    return true;
+}
 
 class MusicBoxApplication  : public JUCEApplication
 {
@@ -24,6 +113,45 @@ public:
 
     void initialise (const String& commandLine) override
     {
+        const StringArray args = StringArray::fromTokens(commandLine, true);
+        if (args.contains(benchmarkOption))
+        {
+            Audio::Benchmark::runAll();
+            quit();
+            return;
+        }
+        const int renderIndex = args.indexOf(renderOption);
+        if (renderIndex >= 0)
+        {
+            const bool rendered = args.size() > renderIndex + 2
+                    && renderSong(args[renderIndex + 1].unquoted(),
+                            args[renderIndex + 2].unquoted());
+            if (args.size() <= renderIndex + 2)
+            {
+                std::cerr << "Usage: " << renderOption
+                        << " <song.mb> <output.wav|output.flac>\n";
+            }
+            setApplicationReturnValue(rendered ? 0 : 1);
+            quit();
+            return;
+        }
+        const int batchIndex = args.indexOf(batchRenderOption);
+        if (batchIndex >= 0)
+        {
+            const bool rendered = args.size() > batchIndex + 2
+                    && renderSongDirectory(args[batchIndex + 1].unquoted(),
+                            args[batchIndex + 2].unquoted(),
+                            args.size() > batchIndex + 3
+                            ? args[batchIndex + 3].unquoted() : "wav");
+            if (args.size() <= batchIndex + 2)
+            {
+                std::cerr << "Usage: " << batchRenderOption
+                        << " <songDirectory> <outputDirectory> [wav|flac]\n";
+            }
+            setApplicationReturnValue(rendered ? 0 : 1);
+            quit();
+            return;
+        }
         mainWindow.reset (new MainWindow (getApplicationName()));
         mainWindow->setContentOwned(new MainComponent, true);
         mainWindow->setVisible(true);
@@ -2,10 +2,13 @@
 #include "Windows_Info.h"
 #include "Assets.h"
 
+// Output channels requested when the audio device opens. The device may open
+// fewer, and the user may switch to mono output:
+static const constexpr int defaultOutputChannels = 2;
+
 //==============================================================================
 MainComponent::MainComponent() :
-notePlayer(deviceManager),
-scrollingPage(notePlayer)
+scrollingPage(notePlayer, deviceManager)
 {
     addAndMakeVisible(scrollingPage);
     Rectangle<int> displaySize = juce::Desktop::getInstance().getDisplays()
@@ -21,13 +24,13 @@ scrollingPage(notePlayer)
         { 
             if (granted)
             {
-                setAudioChannels (0, 1); 
+                setAudioChannels (0, defaultOutputChannels); 
             }
         });
     }
     else
     {
-        setAudioChannels (0, 1);
+        setAudioChannels (0, defaultOutputChannels);
     }
 }
 
@@ -22,8 +22,9 @@ public:
     void resized() override;
 
 private:
-    ScrollingPage scrollingPage;
+    // The NotePlayer must be declared first, so it outlives the ScrollingPage:
     NotePlayer notePlayer;
+    ScrollingPage scrollingPage;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MainComponent)
 };
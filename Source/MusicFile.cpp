@@ -73,6 +73,9 @@ MusicFile MusicFile::openFile(const bool loading)
 }
 
 
+// Separates a note from its gain in a note token, e.g. "12@0.5":
+static const constexpr char* gainSeparator = "@";
+
 // Creates or loads a music file.
 MusicFile::MusicFile(const String path) : path(path)
 {
@@ -90,11 +93,26 @@ MusicFile::MusicFile(const String path) : path(path)
                 Array<int> notes;
                 StringArray noteStrings 
                         = StringArray::fromTokens(line.substring(idx), false);
-                for (const String& note : noteStrings)
+                for (const String& noteString : noteStrings)
                 {
-                    if (note.containsOnly("0123456789"))
+                    const String note = noteString.upToFirstOccurrenceOf(
+                            gainSeparator, false, false);
+                    if (note.isEmpty() || ! note.containsOnly("0123456789"))
+                    {
+                        continue;
+                    }
+                    notes.add(note.getIntValue());
+                    // Notes without a gain play at the default gain:
+                    const String gain = noteString.fromFirstOccurrenceOf(
+                            gainSeparator, false, false);
+                    if (gain.isNotEmpty() && gain.containsOnly("0123456789."))
                     {
-                        notes.add(note.getIntValue());
+                        const float noteGain = jlimit(0.0f,
+                                NoteGrid::defaultGain, gain.getFloatValue());
+                        if (noteGain != NoteGrid::defaultGain)
+                        {
+                            gainMap[beat][note.getIntValue()] = noteGain;
+                        }
                     }
                 }
                 if (! notes.isEmpty())
@@ -138,10 +156,40 @@ void MusicFile::setBPM(const int bpm)
 }
 
 
+// Gets the note data stored in a music file.
+const std::map<int, Array<int>>& MusicFile::getNoteMap() const
+{
+    return noteMap;
+}
+
+
+// Gets the gain of every stored note that doesn't play at full gain.
+const std::map<int, std::map<int, float>>& MusicFile::getGainMap() const
+{
+    return gainMap;
+}
+
+
+// Gets the length of the stored song.
+int MusicFile::getBeatCount() const
+{
+    int beatCount = 0;
+    for (const auto& iter : noteMap)
+    {
+        if (! iter.second.isEmpty() && iter.first >= beatCount)
+        {
+            beatCount = iter.first + 1;
+        }
+    }
+    return beatCount;
+}
+
+
 // Imports note data from a NoteGrid object.
 void MusicFile::importNoteGrid(NoteGrid* noteGrid)
 {
     noteMap = noteGrid->getNoteMap();
+    gainMap = noteGrid->getGainMap();
 }
 
 // Exports file data to a NoteGrid object.
@@ -158,6 +206,14 @@ void MusicFile::exportToNoteGrid(NoteGrid* noteGrid)
             }
         }
     }
+    for (const auto& beatIter : gainMap)
+    {
+        for (const auto& gainIter : beatIter.second)
+        {
+            noteGrid->setNoteGain(gainIter.first, beatIter.first,
+                    gainIter.second);
+        }
+    }
 }
 
 
@@ -174,6 +230,7 @@ bool MusicFile::writeToFile()
         }
         String line(iter.first);
         line += ":";
+        auto gainIter = gainMap.find(iter.first);
         for (const int& note : iter.second)
         {
             if(line.length() > 1)
@@ -181,6 +238,11 @@ bool MusicFile::writeToFile()
                 line += " ";
             }
             line += String(note);
+            if (gainIter != gainMap.end() && gainIter->second.count(note) != 0)
+            {
+                line += gainSeparator;
+                line += String(gainIter->second.at(note), 3);
+            }
         }
         fileOutput += "\n";
         fileOutput += line;
@@ -219,7 +281,7 @@ void MusicFile::writeToSVG()
 {
     // Load first file:
     StringArray fileTexts;
-    fileTexts.add(Assets::findAssetFile(Svg::firstPage).loadFileAsString());
+    fileTexts.add(Assets::loadAssetText(Svg::firstPage));
 
     // Add all beats in the beatMap:
     for (const auto& iter : noteMap)
@@ -236,8 +298,7 @@ void MusicFile::writeToSVG()
         // Add new pages if necessary:
         while (beatFileIdx >= fileTexts.size())
         {
-            fileTexts.add(Assets::findAssetFile(Svg::nextPage)
-                    .loadFileAsString());
+            fileTexts.add(Assets::loadAssetText(Svg::nextPage));
         }
 
         // Get the appropriate file page string reference:
@@ -55,6 +55,30 @@ public:
      */
     void setBPM(const int bpm);
 
+    /**
+     * @brief  Gets the note data stored in a music file.
+     *
+     * @return  A map from each beat number to the list of all notes played on
+     *          that beat.
+     */
+    const std::map<int, Array<int>>& getNoteMap() const;
+
+    /**
+     * @brief  Gets the gain of every stored note that doesn't play at full
+     *         gain.
+     *
+     * @return  A map from each beat number to the gain of each of that beat's
+     *          notes with a gain set.
+     */
+    const std::map<int, std::map<int, float>>& getGainMap() const;
+
+    /**
+     * @brief  Gets the length of the stored song.
+     *
+     * @return  The number of beats needed to play every stored note.
+     */
+    int getBeatCount() const;
+
     /**
      * @brief  Imports note data from a NoteGrid object.
      *
@@ -85,4 +109,5 @@ private:
     String path;
     int bpm = 60;
     std::map<int, Array<int>> noteMap;
+    std::map<int, std::map<int, float>> gainMap;
 };
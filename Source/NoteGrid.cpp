@@ -20,6 +20,7 @@ void NoteGrid::addNote(const int note, const int beat)
     //        << beat);
     resetHighlighting();
     repaint();
+    notifyListeners(Range<int>(beat, beat + 1));
 }
 
 
@@ -27,7 +28,9 @@ void NoteGrid::addNote(const int note, const int beat)
 void NoteGrid::removeNote(const int note, const int beat)
 {
     noteMap[beat].removeAllInstancesOf(note);
+    clearNoteGain(note, beat);
     repaint();
+    notifyListeners(Range<int>(beat, beat + 1));
 }
 
 
@@ -44,15 +47,58 @@ bool NoteGrid::toggleNote(const int note, const int beat)
 }
 
 
+// Sets the gain a note plays at.
+void NoteGrid::setNoteGain(const int note, const int beat, const float gain)
+{
+    auto noteIter = noteMap.find(beat);
+    if (noteIter == noteMap.end() || ! noteIter->second.contains(note))
+    {
+        return;
+    }
+    const float noteGain = jlimit(0.0f, defaultGain, gain);
+    if (noteGain == defaultGain)
+    {
+        clearNoteGain(note, beat);
+    }
+    else
+    {
+        gainMap[beat][note] = noteGain;
+    }
+    repaint();
+    notifyListeners(Range<int>(beat, beat + 1));
+}
+
+
+// Gets the gain a note plays at.
+float NoteGrid::getNoteGain(const int note, const int beat) const
+{
+    auto gainIter = gainMap.find(beat);
+    if (gainIter == gainMap.end())
+    {
+        return defaultGain;
+    }
+    auto noteIter = gainIter->second.find(note);
+    return (noteIter == gainIter->second.end()) ? defaultGain
+            : noteIter->second;
+}
+
+
 // Gets all notes at a specific beat.
-Array<int> NoteGrid::getNotes(const int beat, const bool highlight)
+Array<int> NoteGrid::getNotes(const int beat) const
 {
-    if (highlight)
+    auto noteIter = noteMap.find(beat);
+    return (noteIter == noteMap.end()) ? Array<int>() : noteIter->second;
+}
+
+
+// Highlights notes at a beat briefly when drawing the NoteGrid.
+void NoteGrid::highlightBeat(const int beat)
+{
+    auto noteIter = noteMap.find(beat);
+    if (noteIter != noteMap.end() && ! noteIter->second.isEmpty())
     {
-        const MessageManagerLock mmLock;
         beatColors[beat] = highlightColour;
     }
-    return noteMap[beat];
 }
 
 
@@ -88,12 +134,19 @@ int NoteGrid::getBeatCount() const
 
 
 // Gets all notes stored in the note grid.
-std::map<int, Array<int>> NoteGrid::getNoteMap() const
+const std::map<int, Array<int>>& NoteGrid::getNoteMap() const
 {
     return noteMap;
 }
 
 
+// Gets the gain of every note that doesn't play at the default gain.
+const std::map<int, std::map<int, float>>& NoteGrid::getGainMap() const
+{
+    return gainMap;
+}
+
+
 // Checks if this NoteGrid contains any data.
 bool NoteGrid::isEmpty() const
 {
@@ -115,9 +168,57 @@ bool NoteGrid::isEmpty() const
 // Removes all note data from the NoteGrid.
 void NoteGrid::clear()
 {
+    if (noteMap.empty())
+    {
+        return;
+    }
+    const Range<int> beats(noteMap.begin()->first,
+            noteMap.rbegin()->first + 1);
     noteMap.clear();
+    gainMap.clear();
+    notifyListeners(beats);
 }
 
+
+// Adds a listener to the list of objects receiving notesChanged updates.
+void NoteGrid::addListener(Listener* listener)
+{
+    listeners.addIfNotAlreadyThere(listener);
+}
+
+
+// Removes a listener from the list of objects receiving notesChanged updates.
+void NoteGrid::removeListener(Listener* listener)
+{
+    listeners.removeAllInstancesOf(listener);
+}
+
+
+// Returns a note to the default gain.
+void NoteGrid::clearNoteGain(const int note, const int beat)
+{
+    auto gainIter = gainMap.find(beat);
+    if (gainIter != gainMap.end())
+    {
+        gainIter->second.erase(note);
+        if (gainIter->second.empty())
+        {
+            gainMap.erase(gainIter);
+        }
+    }
+}
+
+
+// Notifies listeners that notes changed.
+void NoteGrid::notifyListeners(const Range<int> beats)
+{
+    for (Listener* listener : listeners)
+    {
+        listener->notesChanged(this, beats);
+    }
+}
+
+
 // Draws all notes in the grid.
 void NoteGrid::paint(Graphics& g)
 {
@@ -150,6 +251,8 @@ void NoteGrid::paint(Graphics& g)
             {
                 DBG(xPos << ", " << yPos);
             }
+            // Quieter notes are drawn fainter:
+            g.setOpacity(0.25f + 0.75f * getNoteGain(note, beat));
             g.fillRoundedRectangle(xPos, yPos, drawnWidth, drawnHeight,
                     cornerSize);
         }
@@ -11,6 +11,9 @@
 class NoteGrid : public Component
 {
 public:
+    // The gain of notes that have no gain set:
+    static const constexpr float defaultGain = 1.0f;
+
     NoteGrid();
 
     virtual ~NoteGrid() { }
@@ -45,17 +48,43 @@ public:
      */
     bool toggleNote(const int note, const int beat);
 
+    /**
+     * @brief  Sets the gain a note plays at.
+     *
+     * @param note  The note value to change.
+     *
+     * @param beat  The beat containing the note to change.
+     *
+     * @param gain  The note's linear gain, between zero and defaultGain.
+     */
+    void setNoteGain(const int note, const int beat, const float gain);
+
+    /**
+     * @brief  Gets the gain a note plays at.
+     *
+     * @param note  The note value to check.
+     *
+     * @param beat  The beat containing the note.
+     *
+     * @return      The note's linear gain, or defaultGain if no gain was set.
+     */
+    float getNoteGain(const int note, const int beat) const;
+
     /**
      * @brief  Gets all notes at a specific beat.
      *
-     * @param beat       The beat to access.
+     * @param beat  The beat to access.
      *
-     * @param highlight  If true, notes at the accessed beat will be highlighted
-     *                   briefly when drawing the NoteGrid.
+     * @return      All notes at the given beat.
+     */
+    Array<int> getNotes(const int beat) const;
+
+    /**
+     * @brief  Highlights notes at a beat briefly when drawing the NoteGrid.
      *
-     * @return           All notes at the given beat.
+     * @param beat  The beat to highlight. Beats without notes are ignored.
      */
-    Array<int> getNotes(const int beat, const bool highlight = false);
+    void highlightBeat(const int beat);
 
     /**
      * @brief  Removes all playback highlighting.
@@ -84,10 +113,19 @@ public:
     /**
      * @brief  Gets all notes stored in the note grid.
      *
-     * @return  A copy of the grid's note map, mapping each beat number to the
-     *          list of notes played on that beat.
+     * @return  The grid's note map, mapping each beat number to the list of
+     *          notes played on that beat.
+     */
+    const std::map<int, Array<int>>& getNoteMap() const;
+
+    /**
+     * @brief  Gets the gain of every note that doesn't play at the default
+     *         gain.
+     *
+     * @return  The grid's gain map, mapping each beat number to the gain of
+     *          each of that beat's notes with a gain set.
      */
-    std::map<int, Array<int>> getNoteMap() const;
+    const std::map<int, std::map<int, float>>& getGainMap() const;
 
     /**
      * @brief  Checks if this NoteGrid contains any data.
@@ -101,9 +139,67 @@ public:
      */
     void clear();
 
+    /**
+     * @brief  An abstract basis for classes that track when notes in the
+     *         NoteGrid change.
+     */
+    class Listener
+    {
+    public:
+        // Only NoteGrid may call notesChanged()
+        friend NoteGrid;
+
+        Listener() { }
+
+        virtual ~Listener() { }
+
+    private:
+        /**
+         * @brief  Notifies the listener that notes or note gains changed.
+         *
+         * @param noteGrid  The NoteGrid that changed.
+         *
+         * @param beats     The range of beats that changed.
+         */
+        virtual void notesChanged(NoteGrid* noteGrid,
+                const Range<int> beats) = 0;
+    };
+
+    /**
+     * @brief  Adds a listener to the list of objects receiving notesChanged
+     *         updates.
+     *
+     * @param listener  The object requesting notesChanged updates.
+     */
+    void addListener(Listener* listener);
+
+    /**
+     * @brief  Removes a listener from the list of objects receiving
+     *         notesChanged updates.
+     *
+     * @param listener  The object that should no longer receive updates.
+     */
+    void removeListener(Listener* listener);
+
     // Number of pixels between the upper bounds and the first note.
     static const constexpr int gridOffset = 15;
 private:
+    /**
+     * @brief  Notifies listeners that notes changed.
+     *
+     * @param beats  The range of beats that changed.
+     */
+    void notifyListeners(const Range<int> beats);
+
+    /**
+     * @brief  Returns a note to the default gain.
+     *
+     * @param note  The note value to change.
+     *
+     * @param beat  The beat containing the note to change.
+     */
+    void clearNoteGain(const int note, const int beat);
+
     /**
      * @brief  Draws all notes in the grid.
      *
@@ -117,6 +213,11 @@ private:
     float beatHeight = 0;
     // Maps each beat to the list of all notes in that beat.
     std::map<int, Array<int>> noteMap;
+    // Maps each beat to the gain of each note in that beat that doesn't play
+    // at the default gain:
+    std::map<int, std::map<int, float>> gainMap;
 
     std::map<int, Colour> beatColors;
+    // All registered listener objects:
+    Array<Listener*> listeners;
 };
@@ -2,23 +2,31 @@
 #include "Layout_Transition_Animator.h"
 #include "MusicFile.h"
 #include "Windows_Alert.h"
+#include "Windows_Info.h"
 #include <map>
 
 static const constexpr int animationMS = 200;
 static const constexpr int defaultBPM = 120;
+static const constexpr float loadingAlpha = 0.3f;
+static const constexpr int meterRefreshHz = 15;
 
 
 // Initializes the component layout and creates the first music strips.
-ScrollingPage::ScrollingPage(NotePlayer& notePlayer):
+ScrollingPage::ScrollingPage(NotePlayer& notePlayer,
+        AudioDeviceManager& deviceManager):
 upButton(Widgets::NavButton::WindowEdge::up),
 downButton(Widgets::NavButton::WindowEdge::down),
 playButton(Widgets::NavButton::WindowEdge::right),
 notePlayer(notePlayer),
+deviceManager(deviceManager),
 playLabel("Play", "Play:"),
 bpmLabel("BPM", "BPM:"),
 loadButton("Load Song"),
 saveButton("Save Song"),
 clearButton("Clear All"),
+kitButton("Load Kit"),
+outputButton("Output: Stereo"),
+limiterLabel("Limiter", "Limit: 0.0dB"),
 playbackTimer(notePlayer)
 {
     using namespace Layout::Group;
@@ -44,7 +52,13 @@ playbackTimer(notePlayer)
             RowItem(&playButton, 1),
             RowItem(1)
         }),
-        Row(15),
+        Row(12),
+        Row(1,
+        { 
+            RowItem(14),
+            RowItem(&limiterLabel, 3),
+            RowItem(1)
+        }),
         Row(1,
         { 
             RowItem(20),
@@ -63,6 +77,18 @@ playbackTimer(notePlayer)
             RowItem(&clearButton, 2),
             RowItem(4)
         }),
+        Row(1,
+        { 
+            RowItem(20),
+            RowItem(&kitButton, 2),
+            RowItem(4)
+        }),
+        Row(1,
+        { 
+            RowItem(20),
+            RowItem(&outputButton, 2),
+            RowItem(4)
+        }),
         Row(2,
         { 
             RowItem(20),
@@ -73,7 +99,7 @@ playbackTimer(notePlayer)
     layoutManager.setLayout(layout, this);
 
     // Initialize labels
-    Array<Label*> labels = { &bpmLabel, &playLabel };
+    Array<Label*> labels = { &bpmLabel, &playLabel, &limiterLabel };
     for (Label* label : labels)
     {
         label->setColour(Label::textColourId, Colour(0xff000000));
@@ -107,7 +133,9 @@ playbackTimer(notePlayer)
     {
         &saveButton,
         &loadButton,
-        &clearButton
+        &clearButton,
+        &kitButton,
+        &outputButton
     };
     for (TextButton* button : textButtons)
     {
@@ -127,6 +155,21 @@ playbackTimer(notePlayer)
     }
 
     addAndMakeVisible(noteGrid);
+
+    notePlayer.addChangeListener(this);
+    deviceManager.addChangeListener(this);
+    updateLoadingState();
+    updateOutputButton();
+    startTimerHz(meterRefreshHz);
+}
+
+
+// Stops listening for NotePlayer loading updates and audio device changes.
+ScrollingPage::~ScrollingPage()
+{
+    stopTimer();
+    deviceManager.removeChangeListener(this);
+    notePlayer.removeChangeListener(this);
 }
 
 
@@ -145,6 +188,8 @@ void ScrollingPage::buttonClicked(Button* button)
         { &clearButton, [this]() { clearData(); } },
         { &saveButton,  [this]() { saveData(); } },
         { &loadButton,  [this]() { loadData(); } }, 
+        { &kitButton,   [this]() { loadKit(); } },
+        { &outputButton, [this]() { toggleOutputChannels(); } },
         {
             &playButton, [this]() 
             { 
@@ -187,9 +232,60 @@ void ScrollingPage::noteClicked(MusicStrip* strip, const int note,
 }
 
 
+// Updates the play button when the NotePlayer finishes or starts loading
+// samples, and the output button when the audio device changes.
+void ScrollingPage::changeListenerCallback(ChangeBroadcaster* source)
+{
+    if (source == &deviceManager)
+    {
+        updateOutputButton();
+        return;
+    }
+    jassert(source == &notePlayer);
+    updateLoadingState();
+    const Result kitResult = notePlayer.getSampleKitResult();
+    if (kitResult.failed() && kitResult.getErrorMessage() != shownKitError)
+    {
+        shownKitError = kitResult.getErrorMessage();
+        AlertWindow::showMessageBoxAsync(AlertWindow::WarningIcon,
+                "Failed to load kit", shownKitError);
+    }
+}
+
+
+// Shows the largest gain reduction the output limiter applied since the last
+// update.
+void ScrollingPage::timerCallback()
+{
+    const float reductionDb = notePlayer.getGainReductionDb();
+    limiterLabel.setText("Limit: "
+            + String((reductionDb > 0.0f) ? -reductionDb : 0.0f, 1) + "dB",
+            NotificationType::dontSendNotification);
+}
+
+
+// Disables the play button and shows a loading label while note samples are
+// loading, and enables it once they are ready.
+void ScrollingPage::updateLoadingState()
+{
+    const bool ready = notePlayer.isReady();
+    playButton.setEnabled(ready);
+    playButton.setAlpha(ready ? 1.0f : loadingAlpha);
+    if (! playbackTimer.isTimerRunning())
+    {
+        playLabel.setText(ready ? "Play:" : "Loading:",
+                NotificationType::dontSendNotification);
+    }
+}
+
+
 // Plays back all notes in the music strip sequence.
 void ScrollingPage::startPlayback()
 {
+    if (! notePlayer.isReady())
+    {
+        return;
+    }
     int bpm = bpmEditor.getText().getIntValue();
     if (bpm <= 0)
     {
@@ -202,7 +298,6 @@ void ScrollingPage::startPlayback()
     stripNum = cachedStripNum;
 
     // Assemble playback data:
-    std::map<int, Array<int>> noteMap = noteGrid.getNoteMap();
     int beatCount = noteGrid.getBeatCount();
     if (beatCount == 0)
     {
@@ -211,9 +306,10 @@ void ScrollingPage::startPlayback()
     }
     beatCount++;
 
-    // Start strip animation:
+    // Start strip animation, timed with the same beat length as the audio:
     const int yOffset = musicStrips[0]->getBeatHeight() * beatCount;
-    const int scrollTime = 36000 / bpm * (beatCount + 1) / 2;
+    const unsigned int scrollTime = (unsigned int) roundToInt(
+            Audio::Sequencer::msPerBeat(bpm) * (beatCount + 1));
     for (MusicStrip* strip : musicStrips)
     {
         Layout::Transition::Animator::transformBounds(strip,
@@ -235,8 +331,8 @@ void ScrollingPage::stopPlayback()
     {
         playbackTimer.stopPlayback();
     }
-    playLabel.setText("Play:", NotificationType::dontSendNotification);
     playButton.setImage("rightIcon_svg");
+    updateLoadingState();
     scrollToCurrentPos();
 }
 
@@ -391,3 +487,66 @@ void ScrollingPage::loadData()
         changeStripPosition(-stripNum);
     }
 }
+
+
+// Loads a sample kit selected by the user.
+void ScrollingPage::loadKit()
+{
+    static WildcardFileFilter filter("*.zip;kit.json", "*", "Sample kits");
+    FileBrowserComponent fileBrowser(
+            FileBrowserComponent::openMode
+            | FileBrowserComponent::canSelectFiles
+            | FileBrowserComponent::canSelectDirectories,
+            File(),
+            &filter,
+            nullptr);
+    FileChooserDialogBox dialogBox("Sample Kits",
+            "Select a kit directory, kit.json file, or .zip archive.",
+            fileBrowser,
+            false,
+            Colour(0xffffffff));
+    Rectangle<int> size = Windows::Info::getBounds();
+    if (dialogBox.show(size.getWidth(), size.getHeight()))
+    {
+        shownKitError = String();
+        notePlayer.loadSampleKit(fileBrowser.getSelectedFile(0));
+    }
+}
+
+
+// Switches the audio device between mono and stereo output.
+void ScrollingPage::toggleOutputChannels()
+{
+    AudioIODevice* device = deviceManager.getCurrentAudioDevice();
+    if (device == nullptr)
+    {
+        return;
+    }
+    const int numChannels = (device->getActiveOutputChannels()
+            .countNumberOfSetBits() == 1) ? 2 : 1;
+    AudioDeviceManager::AudioDeviceSetup setup;
+    deviceManager.getAudioDeviceSetup(setup);
+    setup.outputChannels.clear();
+    setup.outputChannels.setRange(0, numChannels, true);
+    setup.useDefaultOutputChannels = false;
+    const String error = deviceManager.setAudioDeviceSetup(setup, true);
+    if (error.isNotEmpty())
+    {
+        AlertWindow::showMessageBoxAsync(AlertWindow::WarningIcon,
+                "Failed to change output", error);
+    }
+    updateOutputButton();
+}
+
+
+// Shows the number of output channels the audio device opened.
+void ScrollingPage::updateOutputButton()
+{
+    AudioIODevice* device = deviceManager.getCurrentAudioDevice();
+    const int numChannels = (device == nullptr) ? 0
+            : device->getActiveOutputChannels().countNumberOfSetBits();
+    outputButton.setEnabled(device != nullptr
+            && device->getOutputChannelNames().size() > 1);
+    outputButton.setButtonText((numChannels == 1) ? "Output: Mono"
+            : "Output: Stereo");
+}
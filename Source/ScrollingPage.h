@@ -15,18 +15,21 @@
 
 
 class ScrollingPage : public Component, public Button::Listener,
-    public MusicStrip::Listener
+    public MusicStrip::Listener, public ChangeListener, private Timer
 {
 public:
     /**
      * @brief  Initializes the component layout and creates the first music
      *         strips.
      *
-     * @param notePlayer  Handles audio playback for the ScrollingPage.
+     * @param notePlayer     Handles audio playback for the ScrollingPage.
+     *
+     * @param deviceManager  Opens the audio device the NotePlayer plays
+     *                       through.
      */
-    ScrollingPage(NotePlayer& notePlayer);
+    ScrollingPage(NotePlayer& notePlayer, AudioDeviceManager& deviceManager);
     
-    virtual ~ScrollingPage() { }
+    virtual ~ScrollingPage();
     
 private:
     /**
@@ -50,6 +53,27 @@ private:
     void noteClicked(MusicStrip* strip, const int note, const int beat) 
             override;
 
+    /**
+     * @brief  Updates the play button when the NotePlayer finishes or starts
+     *         loading samples, and the output button when the audio device
+     *         changes.
+     *
+     * @param source  The page's NotePlayer or AudioDeviceManager.
+     */
+    void changeListenerCallback(ChangeBroadcaster* source) override;
+
+    /**
+     * @brief  Shows the largest gain reduction the output limiter applied
+     *         since the last update.
+     */
+    void timerCallback() override;
+
+    /**
+     * @brief  Disables the play button and shows a loading label while note
+     *         samples are loading, and enables it once they are ready.
+     */
+    void updateLoadingState();
+
     /**
      * @brief  Plays back all notes in the music strip sequence.
      */
@@ -113,6 +137,22 @@ private:
      * @brief  Loads all song data from a file selected by the user.
      */
     void loadData();
+
+    /**
+     * @brief  Loads a sample kit selected by the user. Notes keep playing
+     *         with the current kit until the new kit is ready.
+     */
+    void loadKit();
+
+    /**
+     * @brief  Switches the audio device between mono and stereo output.
+     */
+    void toggleOutputChannels();
+
+    /**
+     * @brief  Shows the number of output channels the audio device opened.
+     */
+    void updateOutputButton();
     
     // Manages the layout of the navigation buttons:
     Layout::Group::Manager layoutManager;
@@ -133,6 +173,14 @@ private:
     TextButton clearButton;
     TextButton saveButton;
     TextButton loadButton;
+    // Loads a different set of note samples:
+    TextButton kitButton;
+    // Switches between mono and stereo output:
+    TextButton outputButton;
+    // Shows how much the output limiter is reducing the volume:
+    Label limiterLabel;
+    // The last kit loading error shown to the user:
+    String shownKitError;
 
     // The current scrolling offset, measured in number of music strips. 
     float stripNum = 0;
@@ -142,6 +190,8 @@ private:
     NoteGrid noteGrid;
     // Plays notes using audio samples.
     NotePlayer& notePlayer;
+    // Opens the audio output device.
+    AudioDeviceManager& deviceManager;
     // Plays back all notes in the sequence.
     PlaybackTimer playbackTimer;
 };
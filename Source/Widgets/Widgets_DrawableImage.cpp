@@ -59,7 +59,22 @@ placement(placement)
 // Changes the image drawn by this component.
 void Widgets::DrawableImage::setImage(const juce::String assetFilename)
 {
-    setImage(Assets::findAssetFile(assetFilename));
+    const juce::MessageManagerLock mmLock;
+    std::unique_ptr<juce::InputStream> imageStream
+            = Assets::createAssetInputStream(assetFilename);
+    if (imageStream == nullptr)
+    {
+        imageDrawable.reset(nullptr);
+        return;
+    }
+    juce::Drawable* drawable
+            = juce::Drawable::createFromImageDataStream(*imageStream);
+    if (drawable == nullptr)
+    {
+        DBG(dbgPrefix << __func__ << ": Failed to load " << assetFilename);
+        return;
+    }
+    setImage(drawable);
 }
 
 